@@ -123,6 +123,7 @@ struct GlobalVar {
   Type t;
   std::string name;
   std::optional<ExprPtr> init; // int/char only for now
+  bool scratchpad = false;     // placed in the scratchpad
 };
 
 struct Program {
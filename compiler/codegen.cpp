@@ -26,6 +26,7 @@
 #include <sstream>
 #include <functional>
 #include <cstdint>
+#include <cstring>
 
 static inline int align4(int x)  { return (x + 3) & ~3; }
 static inline int align16(int x) { return (x + 15) & ~15; }
@@ -98,10 +99,10 @@ void CodeGen::emit_load_imm(AsmOut& o, const std::string& rd, int32_t imm) {
   if (imm >= -32768 && imm <= 32767) {
     o.emit("\taddi\t" + rd + ", $zero, " + std::to_string(imm));
   } else {
-    int32_t hi = (imm >> 16) & 0xFFFF;
-    int32_t lo = imm & 0xFFFF;
-    o.emit("\tlui\t" + rd + ", " + std::to_string(hi));
-    o.emit("\tori\t" + rd + ", " + rd + ", " + std::to_string(lo));
+    // As for a label: addi keeps the low 16 bits, and Coconut's lui takes
+    // the upper half of the whole value and leaves the lower half alone.
+    o.emit("\taddi\t" + rd + ", $zero, " + std::to_string(imm));
+    o.emit("\tlui\t" + rd + ", " + std::to_string(imm));
   }
 }
 
@@ -119,6 +120,36 @@ void CodeGen::emit_load_word(AsmOut& o, const std::string& rd, const std::string
 void CodeGen::emit_store_word(AsmOut& o, const std::string& rs, const std::string& raddr) {
   o.emit("\tsw\t" + rs + ", 0(" + raddr + ")");
 }
+void CodeGen::emit_load_byte(AsmOut& o, const std::string& rd, const std::string& raddr) {
+  o.emit("\tlbu\t" + rd + ", 0(" + raddr + ")");
+}
+void CodeGen::emit_store_byte(AsmOut& o, const std::string& rs, const std::string& raddr) {
+  o.emit("\tsb\t" + rs + ", 0(" + raddr + ")");
+}
+
+bool CodeGen::is_char_element(const Expr& e, std::unordered_map<std::string, VarInfo>& locals) {
+  auto* a = dynamic_cast<const IndexRef*>(&e);
+  if (!a) return false;
+  auto itL = locals.find(a->name);
+  if (itL != locals.end()) return itL->second.t.base == BaseType::Char;
+  auto itG = sym.globals.find(a->name);
+  return itG != sym.globals.end() && itG->second.t.base == BaseType::Char;
+}
+
+// Words holding the bytes in address order.  Coconut keeps memory, and
+// a.out, in the host's byte order, so the bytes are laid out in each word
+// as the host lays them out in memory: lbu then reads them back in order
+// on a host of either endianness.
+std::vector<int> CodeGen::pack_bytes(const std::string& bytes) {
+  std::vector<int> words((bytes.size() + 3) / 4, 0);
+  for (size_t w = 0; w < words.size(); ++w) {
+    unsigned char b[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < 4 && 4 * w + i < bytes.size(); ++i)
+      b[i] = (unsigned char)bytes[4 * w + i];
+    std::memcpy(&words[w], b, sizeof(b));
+  }
+  return words;
+}
 
 void CodeGen::push_t0(AsmOut& o) {
   o.emit("\taddi\t$sp, $sp, -4");
@@ -227,10 +258,10 @@ bool CodeGen::gen_builtin_call(AsmOut& o, const Call& c,
     emit_load_label_addr(o, "$s0", label);
 
     o.emit(loop);
-    emit_load_word(o, "$t1", "$s0");
+    emit_load_byte(o, "$t1", "$s0");
     o.emit("\tbeq\t$t1, $zero, " + done);
     o.emit("\tdout\t$t1, 2");
-    o.emit("\taddi\t$s0, $s0, 4");
+    o.emit("\taddi\t$s0, $s0, 1");
     o.emit("\tj\t" + loop);
 
     o.emit(done);
@@ -274,11 +305,13 @@ void CodeGen::gen_lvalue_addr(AsmOut& o, const Expr& lhs,
     else emit_load_label_addr(o, "$t2", a->name + "_addr");
 
     gen_expr(o, *a->idx, locals);
-    int elem = 4; // v1 stores everything as word
-    emit_load_imm(o, "$t1", elem);
+    if (vi.t.base != BaseType::Char) {
+      int elem = 4; // char arrays are packed, everything else is a word
+      emit_load_imm(o, "$t1", elem);
 
-    o.emit("\tmult\t$t0, $t1");
-    o.emit("\tmflo\t$t0");
+      o.emit("\tmult\t$t0, $t1");
+      o.emit("\tmflo\t$t0");
+    }
     o.emit("\tadd\t$t2, $t2, $t0");
     return;
   }
@@ -322,7 +355,8 @@ void CodeGen::gen_expr(AsmOut& o, const Expr& e,
 
   if (dynamic_cast<const IndexRef*>(&e)) {
     gen_lvalue_addr(o, e, locals);
-    emit_load_word(o, "$t0", "$t2");
+    if (is_char_element(e, locals)) emit_load_byte(o, "$t0", "$t2");
+    else emit_load_word(o, "$t0", "$t2");
     return;
   }
 
@@ -349,7 +383,11 @@ void CodeGen::gen_expr(AsmOut& o, const Expr& e,
     gen_lvalue_addr(o, *as->lhs, locals);
     pop_t1(o);
     o.emit("\tadd\t$t0, $t1, $zero");
-    emit_store_word(o, "$t0", "$t2");
+    if (is_char_element(*as->lhs, locals)) {
+      emit_store_byte(o, "$t0", "$t2");
+      o.emit("\tandi\t$t0, $t0, 255"); // the value is what was stored
+    }
+    else emit_store_word(o, "$t0", "$t2");
     return;
   }
 
@@ -483,7 +521,7 @@ void CodeGen::gen_stmt(AsmOut& o, const Stmt& s,
         o.emit("\tsw\t$zero, " + std::to_string(off) + "($fp)");
       }
     } else {
-      int n = v->t.arrayLen;
+      int n = align4(v->t.sizeBytes()) / 4; // words, char arrays are packed
       std::string loop = newLabel("ZARR");
       std::string done = newLabel("ZARR_DONE");
       o.emit("\taddi\t$t2, $fp, " + std::to_string(off)); // base
@@ -594,21 +632,29 @@ std::string CodeGen::compile(const Program& p) {
   out.emit("\tj\tHALT");
   out.emit("");
 
+  // strings are packed, four characters to a word
   for (auto& s : strings) {
     out.emit(s.label);
-    for (unsigned char c : s.s) {
-      out.emit("\tdw\t" + std::to_string((int)c));
+    for (int w : pack_bytes(s.s + '\0')) {
+      out.emit("\tdw\t" + std::to_string(w));
     }
-    out.emit("\tdw\t0");
   }
   out.emit("");
 
   for (const auto& fn : p.funcs) gen_func(out, fn);
 
-  if (!p.globals.empty()) {
-    out.emit("");
-    out.emit("; --- globals ---");
+  // globals, then those placed in the scratchpad at its own address
+  for (int pass = 0; pass < 2; ++pass) {
+    bool scratchpad = (pass == 1);
+    bool first = true;
     for (const auto& g : p.globals) {
+      if (g.scratchpad != scratchpad) continue;
+      if (first) {
+        out.emit("");
+        out.emit(scratchpad ? "# --- scratchpad globals ---" : "# --- globals ---");
+        if (scratchpad) out.emit("\tbegin\t" + std::to_string(scratchpadBase));
+        first = false;
+      }
       out.emit(g.name + "_addr");
       int words = align4(g.t.sizeBytes()) / 4;
       int initVal = 0;
@@ -37,6 +37,9 @@ struct CodeGen {
   // memory layout
   // Coconut examples typically begin/start at 1024.
   int codeBase = 1024;
+  // 'scratchpad' globals go here; the simulator's default SCRATCHPAD_BASE
+  // ( mips/scratchpad.h ).
+  int scratchpadBase = 0x10000;
   int curLabelId = 1;
 
   SymTab sym;
@@ -84,6 +87,12 @@ private:
   // memory access by address in reg
   void emit_load_word(AsmOut& o, const std::string& rd, const std::string& raddr);
   void emit_store_word(AsmOut& o, const std::string& rs, const std::string& raddr);
+  void emit_load_byte(AsmOut& o, const std::string& rd, const std::string& raddr);
+  void emit_store_byte(AsmOut& o, const std::string& rs, const std::string& raddr);
+
+  // char arrays (and strings) are packed a byte per element
+  bool is_char_element(const Expr& e, std::unordered_map<std::string, VarInfo>& locals);
+  static std::vector<int> pack_bytes(const std::string& bytes);
 
   // stack temp
   void push_t0(AsmOut& o);
@@ -91,6 +91,7 @@ Token Lexer::lex_ident_or_kw() {
   if (s == "else") return make(TokKind::KwElse, s, line, col);
   if (s == "while") return make(TokKind::KwWhile, s, line, col);
   if (s == "for") return make(TokKind::KwFor, s, line, col);
+  if (s == "scratchpad") return make(TokKind::KwScratchpad, s, line, col);
 
   return make(TokKind::Ident, s, line, col);
 }
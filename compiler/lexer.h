@@ -42,6 +42,7 @@ enum class TokKind {
   KwElse,
   KwWhile,
   KwFor,
+  KwScratchpad,  // placement of a global, see codegen.h
 
   // punctuation
   LParen, RParen,
@@ -37,12 +37,19 @@ static bool has_suffix(const std::string& s, const std::string& suf) {
 
 int main(int argc, char** argv) {
   try {
-    if (argc != 2) {
-      std::cerr << "Usage: smallc <file.smallc.c>\n";
+    CodeGen cg;
+    int arg = 1;
+    if (argc == 4 && std::string(argv[1]) == "-s") {
+      // where the simulator's scratchpad is, if not at its default base
+      cg.scratchpadBase = std::stoi(argv[2], nullptr, 0);
+      arg = 3;
+    }
+    if (argc != arg + 1) {
+      std::cerr << "Usage: smallc [-s scratchpad_base] <file.smallc.c>\n";
       return 1;
     }
 
-    std::string inPath = argv[1];
+    std::string inPath = argv[arg];
     const std::string requiredExt = ".smallc.c";
 
     // 1) Enforce input extension
@@ -69,7 +76,6 @@ int main(int argc, char** argv) {
     Parser parser(std::move(lex));
     Program prog = parser.parse_program();
 
-    CodeGen cg;
     std::string asmText = cg.compile(prog);
 
     // 5) Write output with header
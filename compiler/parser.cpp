@@ -60,6 +60,7 @@ Program Parser::parse_program() {
 }
 
 void Parser::parse_global_or_func(Program& p) {
+  bool scratchpad = accept(TokKind::KwScratchpad);
   Type t = parse_type();
   if (_tok.kind != TokKind::Ident) throw CompileError("Expected identifier");
   std::string name = _tok.text;
@@ -67,6 +68,7 @@ void Parser::parse_global_or_func(Program& p) {
 
   // function?
   if (accept(TokKind::LParen)) {
+    if (scratchpad) throw CompileError("Only globals can be placed in the scratchpad");
     Func f;
     f.ret = t;
     f.name = name;
@@ -96,6 +98,7 @@ void Parser::parse_global_or_func(Program& p) {
   GlobalVar gv;
   gv.t = t;
   gv.name = name;
+  gv.scratchpad = scratchpad;
 
   if (accept(TokKind::LBracket)) {
     if (_tok.kind != TokKind::IntLit) throw CompileError("Array length must be int literal");
@@ -79,8 +79,16 @@
 # define	OP_BNE		5
 # define	OP_J		2
 # define	OP_JAL		3
+# define	OP_LB		0x20
+# define	OP_LH		0x21
 # define	OP_LW		0x23
+# define	OP_LBU		0x24
+# define	OP_LHU		0x25
+# define	OP_SB		0x28
+# define	OP_SH		0x29
 # define	OP_SW		0x2b
+# define	OP_LL		0x30		// Load linked
+# define	OP_SC		0x38		// Store conditional, rt <- 1 / 0
 
 # define	OP_DIN		0x3f		// Addition to MIPS
 # define	OP_DOUT		0x3e		// Addition to MIPS
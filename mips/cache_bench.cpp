@@ -0,0 +1,131 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Micro-benchmark of SimpleCache lookups.  Times reads that hit a
+// warmed-up cache, and reads that mostly miss, and prints the lookups
+// per second of each, then does the same for the prebuilt 32KB hierarchy
+// of StaticTopology.  Run from 'test/' as
+//	./cache_bench [ blocks [ wordsPerBlock [ associativity [ lookups ] ] ] ]
+
+# include <iostream>
+using std::cout;
+using std::flush;
+# include <cstdlib>
+using std::atoi;
+# include <ctime>
+
+# include <semaphore.h>
+sem_t * cout_mutex;	// Referred as extern from the caches
+
+# include "memory.h"
+# include "simple_cache.h"
+# include "static_cache.h"
+
+# define BENCH_MEMORY_SIZE ( 32 * 1024 * 1024 )
+
+static unsigned int state = 1;
+static unsigned int Next ( )	// xorshift, as in Replacement
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// Reads lookups random words of the first 'bytes' of memory; returns the
+// lookups per second.
+static double Run ( Cache * c, int bytes, int lookups, word_64 & sum )
+{
+	word_32 value;
+	clock_t start = clock ( );
+	for ( int i = 0; i < lookups; i++ )
+	{
+		c -> Read ( ( Next ( ) % ( bytes / 4 ) ) * 4, value, 4 );
+		sum += value;
+	}
+	double seconds = static_cast<double>( clock ( ) - start ) / CLOCKS_PER_SEC;
+	return ( seconds > 0 ) ? lookups / seconds : 0;
+}
+
+int main ( int argc, char * argv[] )
+{
+	sem_t mutex;
+	sem_init ( &mutex, 0, 1 );
+	cout_mutex = &mutex;
+	
+	int nob = ( argc > 1 ) ? atoi ( argv[1] ) : 16384;
+	int wpb = ( argc > 2 ) ? atoi ( argv[2] ) : 8;
+	int assoc = ( argc > 3 ) ? atoi ( argv[3] ) : 16;
+	int lookups = ( argc > 4 ) ? atoi ( argv[4] ) : 4000000;
+	if ( nob < 1 || wpb < 1 || assoc < 1 || assoc > nob || lookups < 1 )
+	{
+		cout << "\nUsage : cache_bench [ blocks [ wordsPerBlock "
+			<< "[ associativity [ lookups ] ] ] ]\n" << flush;
+		return 1;
+	}
+	
+	MainMemory * mem = new MainMemory ( BENCH_MEMORY_SIZE );
+	char type[] = "BENCH";
+	SimpleCache * c = new SimpleCache ( mem, nob, wpb, assoc, type, 1, false );
+	int cacheBytes = nob * wpb * 4;
+	if ( cacheBytes * 4 > BENCH_MEMORY_SIZE )
+	{
+		cout << "\nThe cache is too large for the benchmark memory\n" << flush;
+		return 1;
+	}
+	
+	// Warm up half the cache, so that every set has room for it
+	word_32 value;
+	word_64 sum = 0;
+	for ( int a = 0; a < cacheBytes / 2; a += wpb * 4 )
+		c -> Read ( a, value, 4 );
+	
+	double hits = Run ( c, cacheBytes / 2, lookups, sum );
+	double misses = Run ( c, cacheBytes * 4, lookups / 4, sum );
+	
+	cout << "\nSimpleCache of " << nob << " blocks, " << wpb << " words per block, "
+		<< assoc << "-way, " << SimpleCache::LookupPath ( ) 
+		<< " tag compare"
+		<< "\nHits   : " << hits << " lookups per second"
+		<< "\nMisses : " << misses << " lookups per second"
+		<< "\n( checksum " << sum << " )\n" << flush;
+	
+	// The statically composed cache, with the same lookups
+	Cache * s = StaticTopology::Build ( 1, mem, type );
+	int staticBytes = 32768;
+	for ( int a = 0; a < staticBytes / 2; a += 32 )
+		s -> Read ( a, value, 4 );
+	hits = Run ( s, staticBytes / 2, lookups, sum );
+	misses = Run ( s, staticBytes * 4, lookups / 4, sum );
+	
+	cout << "\nStaticCache, " << StaticTopology::Name ( 1 )
+		<< "\nHits   : " << hits << " lookups per second"
+		<< "\nMisses : " << misses << " lookups per second"
+		<< "\n( checksum " << sum << " )\n" << flush;
+	
+	s -> AtExit ( );
+	c -> AtExit ( );
+	mem -> AtExit ( );
+	sem_destroy ( &mutex );
+	return 0;
+}
@@ -0,0 +1,239 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Trace driven cache simulator.  Replays a trace written by coconut
+// ( trace.file = name, see trace.h ) through a data and an instruction
+// SimpleCache for each configuration given, and prints their hit ratios.
+// Only the tags are simulated ( SimpleCache::ReplayAccess ), and the
+// trace is decoded a batch at a time, which each configuration then
+// takes in one tight loop.  With -j the configurations are shared out
+// among that many threads, each reading the trace on its own.  Run from
+// 'test/' as
+//	./coconut-cachesim [ -j threads ] trace blocks,words,assoc[,policy] ...
+// where policy is one of the replacement policies ( LRU if not given ).
+
+# include <iostream>
+using std::cout;
+using std::flush;
+# include <iomanip>
+using std::setw;
+# include <cstdlib>
+using std::atoi;
+# include <cstdio>	// sscanf
+# include <cstring>	// strcasecmp
+# include <strings.h>
+# include <ctime>
+
+# include <pthread.h>
+# include <semaphore.h>
+sem_t * cout_mutex;	// Referred as extern from the caches
+
+# include "memory.h"
+# include "simple_cache.h"
+# include "trace.h"
+
+# define MAX_CONFIGS 64
+# define MAX_SIM_THREADS 16
+# define POLICY_NAME_SIZE 16
+# define REPLAY_BATCH 4096	// accesses decoded at a time
+# define NO_MEMORY_SIZE 4096	// the caches never reach the level below
+
+class SimConfig
+{
+public:
+	int nob, wpb, assoc;
+	ReplacementPolicy policy;
+	SimpleCache * dc;
+	SimpleCache * ic;
+};
+
+class SimThread
+{
+public:
+	const char * traceFile;
+	SimConfig * configs;
+	int noOfConfigs;
+	int first;		// this thread takes first, first + step, ...
+	int step;
+	word_64 accesses;	// replayed, per configuration
+	bool ok;		// the trace was opened
+	bool started;
+	pthread_t thread;
+};
+
+// Parses blocks,words,assoc[,policy]
+static bool ParseConfig ( const char * text, SimConfig & c )
+{
+	char policy[POLICY_NAME_SIZE] = "LRU";
+	int fields = sscanf ( text, "%d,%d,%d,%15s", &c.nob, &c.wpb, &c.assoc, policy );
+	if ( fields < 3 || c.nob < 1 || c.wpb < 1 || c.assoc < 1 || c.assoc > c.nob ||
+			c.nob % c.assoc != 0 )
+		return false;
+	for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+		if ( strcasecmp ( policy, Replacement::Name ( static_cast<ReplacementPolicy>(p) ) ) == 0 )
+		{
+			c.policy = static_cast<ReplacementPolicy>(p);
+			return true;
+		}
+	return false;
+}
+
+static void* Replay ( void * tobj )
+{
+	SimThread * t = static_cast<SimThread *>( tobj );
+	TraceReader reader;
+	t -> ok = reader.Open ( t -> traceFile );
+	if ( t -> ok == false ) return NULL;
+	
+	// A batch for all of this thread's configurations, one after another
+	ShadowAccess batch[REPLAY_BATCH];
+	int n;
+	do
+	{
+		for ( n = 0; n < REPLAY_BATCH && reader.Next ( batch[n] ) == true; n++ );
+		for ( int c = t -> first; c < t -> noOfConfigs; c += t -> step )
+		{
+			SimpleCache * dc = t -> configs[c].dc;
+			SimpleCache * ic = t -> configs[c].ic;
+			for ( int i = 0; i < n; i++ )
+				if ( batch[i].kind == SHADOW_FETCH )
+					ic -> ReplayAccess ( batch[i].address, false );
+				else
+					dc -> ReplayAccess ( batch[i].address, batch[i].kind == SHADOW_STORE );
+		}
+		t -> accesses += n;
+	} while ( n == REPLAY_BATCH );
+	reader.Close ( );
+	return NULL;
+}
+
+static void Row ( const char * label, SimpleCache * c )
+{
+	word_64 accesses, hits;
+	c -> Totals ( accesses, hits );
+	cout << setw ( 14 ) << label << setw ( 14 ) << accesses << setw ( 14 ) 
+		<< accesses - hits << setw ( 14 ) << std::fixed << std::setprecision ( 4 ) 
+		<< ( ( accesses != 0 ) ? static_cast<double>( hits ) / accesses : 0 );
+	cout.unsetf ( std::ios::floatfield );
+}
+
+int main ( int argc, char * argv[] )
+{
+	sem_t mutex;
+	sem_init ( &mutex, 0, 1 );
+	cout_mutex = &mutex;
+	
+	int arg = 1, threads = 1;
+	if ( argc > 2 && strcmp ( argv[1], "-j" ) == 0 )
+	{
+		threads = atoi ( argv[2] );
+		arg = 3;
+	}
+	static SimConfig configs[MAX_CONFIGS];
+	int noOfConfigs = argc - arg - 1;
+	bool usage = ( threads < 1 || threads > MAX_SIM_THREADS || noOfConfigs < 1 || 
+		noOfConfigs > MAX_CONFIGS );
+	for ( int c = 0; usage == false && c < noOfConfigs; c++ )
+		if ( ParseConfig ( argv[arg + 1 + c], configs[c] ) == false )
+		{
+			cout << "\nBad configuration \"" << argv[arg + 1 + c] << "\"" << flush;
+			usage = true;
+		}
+	if ( usage == true )
+	{
+		cout << "\nUsage : coconut-cachesim [ -j threads ] trace "
+			<< "blocks,words,assoc[,policy] ...\n" << flush;
+		return 1;
+	}
+	const char * traceFile = argv[arg];
+	if ( threads > noOfConfigs )
+		threads = noOfConfigs;
+	
+	MainMemory * mem = new MainMemory ( NO_MEMORY_SIZE );
+	for ( int c = 0; c < noOfConfigs; c++ )
+	{
+		configs[c].dc = new SimpleCache ( mem, configs[c].nob, 
+			configs[c].wpb, configs[c].assoc, "DATA", 1, false );
+		configs[c].ic = new SimpleCache ( mem, configs[c].nob, 
+			configs[c].wpb, configs[c].assoc, "INSTRUCTION", 1, false );
+		configs[c].dc -> SetReplacement ( configs[c].policy, 1 );
+		configs[c].ic -> SetReplacement ( configs[c].policy, 1 );
+	}
+	
+	static SimThread sim[MAX_SIM_THREADS];
+	timespec start, end;
+	clock_gettime ( CLOCK_MONOTONIC, &start );
+	for ( int t = 0; t < threads; t++ )
+	{
+		sim[t].traceFile = traceFile;
+		sim[t].configs = configs;
+		sim[t].noOfConfigs = noOfConfigs;
+		sim[t].first = t;
+		sim[t].step = threads;
+		sim[t].accesses = 0;
+		sim[t].ok = false;
+		sim[t].started = ( pthread_create ( &sim[t].thread, NULL, &Replay, &sim[t] ) == 0 );
+	}
+	for ( int t = 0; t < threads; t++ )
+		if ( sim[t].started == true )
+			pthread_join ( sim[t].thread, NULL );
+	clock_gettime ( CLOCK_MONOTONIC, &end );
+	
+	// Each thread reads the trace for itself, and the table is only
+	// right if every one of them got through all of it.
+	for ( int t = 0; t < threads; t++ )
+		if ( sim[t].started == false || sim[t].ok == false || 
+			sim[t].accesses != sim[0].accesses )
+		{
+			cout << "\nCould not read the trace \"" << traceFile 
+				<< "\" on replay thread " << t << "\n" << flush;
+			return 1;
+		}
+	double seconds = ( end.tv_sec - start.tv_sec ) + ( end.tv_nsec - start.tv_nsec ) / 1e9;
+	word_64 replayed = 0;
+	for ( int t = 0; t < threads; t++ )
+		replayed += sim[t].accesses * ( ( noOfConfigs - t + threads - 1 ) / threads );
+	
+	cout << "\nTrace " << traceFile << " : " << sim[0].accesses << " accesses, "
+		<< noOfConfigs << " configurations on " << threads << " threads"
+		<< "\n" << setw ( 28 ) << "" << setw ( 14 ) << "accesses" << setw ( 14 ) 
+		<< "misses" << setw ( 14 ) << "hit ratio";
+	for ( int c = 0; c < noOfConfigs; c++ )
+	{
+		cout << "\n" << std::left << setw ( 14 ) << argv[arg + 1 + c] << std::right;
+		Row ( "data", configs[c].dc );
+		cout << "\n" << setw ( 14 ) << "";
+		Row ( "instruction", configs[c].ic );
+	}
+	cout << "\n" << replayed / ( ( seconds > 0 ) ? seconds : 1 ) 
+		<< " accesses simulated per second\n" << flush;
+	
+	for ( int c = 0; c < noOfConfigs; c++ )
+	{
+		configs[c].dc -> AtExit ( );
+		configs[c].ic -> AtExit ( );
+	}
+	mem -> AtExit ( );
+	sem_destroy ( &mutex );
+	return 0;
+}
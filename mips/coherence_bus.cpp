@@ -0,0 +1,234 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "coherence_bus.h"
+# include "simple_cache.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+CoherenceBus :: CoherenceBus ( int lineSize )
+{
+	// Recursive, because SC holds the lock across its WriteMem, which
+	// goes through an attached cache that locks again.
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init ( &attr );
+	pthread_mutexattr_settype ( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init ( &busMutex, &attr );
+	for ( int i = 0; i < MAX_BUS_SET_LOCKS; i++ )
+		pthread_mutex_init ( &setMutex[i], &attr );
+	pthread_mutexattr_destroy ( &attr );
+	
+	lineBytes = ( lineSize >= 4 ) ? lineSize : 4;
+	noOfCaches = 0;
+	noOfSetLocks = 1;
+	setsInCommon = 0;
+	
+	for ( int i = 0; i < MAX_LINKS; i++ )
+	{
+		linkValid[i] = false;
+		linkLine[i] = 0;
+	}
+	
+	busReads = busReadExclusives = busUpgrades = flushes = 0;
+	invalidations = trueSharing = falseSharing = 0;
+	scSuccesses = scFailures = linksBroken = 0;
+}
+
+void CoherenceBus :: AtExit ( )
+{
+	pthread_mutex_destroy ( &busMutex );
+	for ( int i = 0; i < MAX_BUS_SET_LOCKS; i++ )
+		pthread_mutex_destroy ( &setMutex[i] );
+}
+
+// Before the cores start: the set locks are picked by line % noOfSetLocks.
+void CoherenceBus :: AttachCache ( SimpleCache * c, int core, bool snoop, int sets )
+{
+	if ( noOfCaches == MAX_BUS_CACHES )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ CoherenceBus ] Too many caches, not attaching"
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return;
+	}
+	cache[noOfCaches] = c;
+	cacheCore[noOfCaches] = core;
+	cacheSnoops[noOfCaches] = snoop;
+	noOfCaches ++;
+	
+	int a = setsInCommon, b = sets;
+	while ( b != 0 )
+	{
+		int r = a % b;
+		a = b;
+		b = r;
+	}
+	setsInCommon = a;
+	noOfSetLocks = ( setsInCommon < MAX_BUS_SET_LOCKS ) ? setsInCommon : MAX_BUS_SET_LOCKS;
+	while ( setsInCommon % noOfSetLocks != 0 )
+		noOfSetLocks --;
+}
+
+void CoherenceBus :: Lock ( )
+{
+	pthread_mutex_lock ( &busMutex );
+}
+
+void CoherenceBus :: Unlock ( )
+{
+	pthread_mutex_unlock ( &busMutex );
+}
+
+void CoherenceBus :: LockSet ( word_32 address )
+{
+	pthread_mutex_lock ( &setMutex[static_cast<u_word_32>( LineOf ( address ) ) % noOfSetLocks] );
+}
+
+void CoherenceBus :: UnlockSet ( word_32 address )
+{
+	pthread_mutex_unlock ( &setMutex[static_cast<u_word_32>( LineOf ( address ) ) % noOfSetLocks] );
+}
+
+word_32 CoherenceBus :: LineOf ( word_32 address )
+{
+	return static_cast<word_32>( static_cast<u_word_32>(address) / lineBytes );
+}
+
+/*********************************************************************************
+*******************Bus transactions**********************************************/
+
+bool CoherenceBus :: BusRead ( SimpleCache * requester, word_32 address )
+{
+	busReads ++;
+	bool shared = false;
+	for ( int i = 0; i < noOfCaches; i++ )
+	{
+		if ( cache[i] == requester || cacheSnoops[i] == false ) continue;
+		bool flushed;
+		if ( cache[i] -> SnoopRead ( address, flushed ) )
+			shared = true;
+		if ( flushed ) flushes ++;
+	}
+	return shared;
+}
+
+void CoherenceBus :: BusReadExclusive ( SimpleCache * requester, word_32 address )
+{
+	busReadExclusives ++;
+	Invalidate ( requester, address );
+}
+
+void CoherenceBus :: BusUpgrade ( SimpleCache * requester, word_32 address )
+{
+	busUpgrades ++;
+	Invalidate ( requester, address );
+}
+
+void CoherenceBus :: Invalidate ( SimpleCache * requester, word_32 address )
+{
+	for ( int i = 0; i < noOfCaches; i++ )
+	{
+		if ( cache[i] == requester || cacheSnoops[i] == false ) continue;
+		bool flushed, wordTouched;
+		if ( cache[i] -> SnoopInvalidate ( address, flushed, wordTouched ) )
+		{
+			invalidations ++;
+			if ( wordTouched ) trueSharing ++;
+			else falseSharing ++;
+		}
+		if ( flushed ) flushes ++;
+	}
+}
+
+/*********************************************************************************
+*******************LL / SC*******************************************************/
+
+void CoherenceBus :: Link ( int linkId, word_32 address )
+{
+	if ( linkId < 0 || linkId >= MAX_LINKS ) return;
+	Lock ( );
+	linkValid[linkId] = true;
+	linkLine[linkId] = LineOf ( address );
+	Unlock ( );
+}
+
+bool CoherenceBus :: LinkIntact ( int linkId, word_32 address )
+{
+	if ( linkId < 0 || linkId >= MAX_LINKS ) return false;
+	Lock ( );
+	bool intact = linkValid[linkId] && linkLine[linkId] == LineOf ( address );
+	Unlock ( );
+	return intact;
+}
+
+void CoherenceBus :: StoreDone ( int linkId, word_32 address, bool conditional, bool success )
+{
+	Lock ( );
+	if ( conditional )
+	{
+		if ( success ) scSuccesses ++;
+		else scFailures ++;
+		if ( linkId >= 0 && linkId < MAX_LINKS )
+			linkValid[linkId] = false;	// An SC always consumes the link
+	}
+	if ( conditional == false || success == true )
+	{
+		word_32 line = LineOf ( address );
+		for ( int i = 0; i < MAX_LINKS; i++ )
+			if ( i != linkId && linkValid[i] == true && linkLine[i] == line )
+			{
+				linkValid[i] = false;
+				linksBroken ++;
+			}
+	}
+	Unlock ( );
+}
+
+void CoherenceBus :: Statistics ( )
+{
+	cout << green << "\n[ CoherenceBus::Statistics ] MESI bus, "
+		<< noOfCaches << " caches, " << lineBytes << " byte lines, "
+		<< noOfSetLocks << " set locks"
+		<< reset << flush;
+	cout << "\nBusRd transactions : " << busReads
+		<< "\nBusRdX transactions : " << busReadExclusives
+		<< "\nBusUpgr transactions : " << busUpgrades
+		<< "\nFlushes ( snoop write backs ) : " << flushes
+		<< "\nTotal coherence messages : " 
+		<< busReads + busReadExclusives + busUpgrades + flushes
+		<< "\nInvalidations : " << invalidations
+		<< "\n  true sharing : " << trueSharing
+		<< "\n  false sharing : " << falseSharing
+		<< "\nSC succeeded : " << scSuccesses
+		<< "\nSC failed : " << scFailures
+		<< "\nLinks broken by other stores : " << linksBroken
+		<< flush;
+}
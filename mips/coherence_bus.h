@@ -0,0 +1,121 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A snooping bus joining the private L1 caches of several cores to the
+ * shared MainMemory.  The SimpleCaches attached to it keep their lines
+ * in MESI states; on a miss or on a write to a Shared line they place a
+ * BusRd, BusRdX or BusUpgr on the bus, which the other snooping caches
+ * answer by flushing ( writing back ) and downgrading or invalidating
+ * their copy.  The lower level is always MainMemory, so a flush followed
+ * by the requester's fetch is all the data transfer there is.
+ *
+ * The bus also holds the LL/SC link registers, because a link is broken
+ * by a store from any other hardware thread, on any core.
+ *
+ * Each core runs on its own host threads.  A hit that needs no bus
+ * transaction holds only the lock of its set, which a snoop of that set
+ * also needs; the lines of a set in every attached cache share one lock.
+ * Misses, upgrades and the LL/SC links change bus-wide state and take the
+ * ( recursive ) bus lock first, then the set's.  LL and SC take the bus
+ * lock to make their read-link and check-write atomic.
+ */
+
+# ifndef __COHERENCE_BUS_H
+# define __COHERENCE_BUS_H
+
+# include "../include/instruction.h"
+
+# include <pthread.h>
+
+# define MAX_CORES	8
+# define MAX_BUS_CACHES	( 2 * MAX_CORES )	// An I and a D cache per core
+# define MAX_LINKS	64			// cores * hardware threads
+# define MAX_BUS_SET_LOCKS	64
+
+class SimpleCache;
+
+class CoherenceBus
+{
+private:
+	pthread_mutex_t busMutex;
+	int lineBytes;
+	
+	// Lock i covers the lines i, i + noOfSetLocks, ...; noOfSetLocks
+	// divides the number of sets of every attached cache, so a set never
+	// needs two of them.
+	pthread_mutex_t setMutex[MAX_BUS_SET_LOCKS];
+	int noOfSetLocks;
+	int setsInCommon;	// the GCD of the attached caches' numbers of sets
+	
+	SimpleCache * cache[MAX_BUS_CACHES];
+	int cacheCore[MAX_BUS_CACHES];
+	bool cacheSnoops[MAX_BUS_CACHES];
+	int noOfCaches;
+	
+	bool linkValid[MAX_LINKS];
+	word_32 linkLine[MAX_LINKS];	// line address of the LL
+	
+	// Statistics
+	word_64 busReads;
+	word_64 busReadExclusives;
+	word_64 busUpgrades;
+	word_64 flushes;
+	word_64 invalidations;
+	word_64 trueSharing;	// invalidated copy had used the written word
+	word_64 falseSharing;	// ... had only used other words of the line
+	word_64 scSuccesses;
+	word_64 scFailures;
+	word_64 linksBroken;
+	
+	word_32 LineOf ( word_32 address );
+	void Invalidate ( SimpleCache * requester, word_32 address );
+public:
+	CoherenceBus ( int lineSize );
+	void AtExit ( );
+	
+	void AttachCache ( SimpleCache * c, int core, bool snoop, int sets );
+	
+	void Lock ( );		// bus-wide
+	void Unlock ( );
+	void LockSet ( word_32 address );	// the set of the line holding address
+	void UnlockSet ( word_32 address );
+	
+	// Transactions, placed by an attached cache that holds the bus lock
+	// and the lock of the line's set.
+	bool BusRead ( SimpleCache * requester, word_32 address );
+		// returns true if some other cache keeps a copy
+	void BusReadExclusive ( SimpleCache * requester, word_32 address );
+	void BusUpgrade ( SimpleCache * requester, word_32 address );
+	
+	// LL / SC support.  linkId identifies a hardware thread.
+	void Link ( int linkId, word_32 address );
+	bool LinkIntact ( int linkId, word_32 address );
+	void StoreDone ( int linkId, word_32 address, bool conditional, bool success );
+		// Records a store ( or a conditional store attempt ), breaking
+		// the links other threads hold on the line.
+	
+	void Statistics ( );
+};
+
+# endif
@@ -0,0 +1,400 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "dram.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+DramController :: DramController ( MainMemory * m, int channels, int banks, int rowSize )
+{
+	mem = m;
+	noOfChannels = ( channels < 1 ) ? 1 : 
+		( channels > MAX_DRAM_CHANNELS ) ? MAX_DRAM_CHANNELS : channels;
+	noOfBanks = ( banks < 1 ) ? 1 : ( banks > MAX_DRAM_BANKS ) ? MAX_DRAM_BANKS : banks;
+	rowBytes = ( rowSize < MIN_DRAM_ROW_BYTES ) ? MIN_DRAM_ROW_BYTES : rowSize;
+	
+	for ( int c = 0; c < noOfChannels; c++ )
+	{
+		busFreeAt[c] = busBefore[c] = burstAt[c] = 0;
+		for ( int b = 0; b < noOfBanks; b++ )
+		{
+			bank[c][b].openRow = bank[c][b].rowBefore = -1;
+			bank[c][b].readyAt = bank[c][b].freeBefore = bank[c][b].lastStart = 0;
+		}
+	}
+	pagePolicy = PAGE_OPEN;
+	SetTimings ( 1, 1, 1, 1 );
+	SetRefresh ( 0, 0 );
+	SetWriteQueue ( 0 );
+	queuedWrites = 0;
+	
+	reads = writes = 0;
+	rowHits = rowEmpty = rowConflicts = 0;
+	readLatency = 0;
+	readsReordered = writesReordered = writeQueueStalls = refreshStalls = 0;
+	lastClock = 0;
+	pthread_mutex_init ( &mutex, NULL );
+}
+
+void DramController :: SetPagePolicy ( PagePolicy policy )
+{
+	pagePolicy = policy;
+}
+
+void DramController :: SetTimings ( int rcd, int cas, int rp, int burst )
+{
+	tRCD = rcd;
+	tCAS = cas;
+	tRP = rp;
+	tBurst = ( burst < 1 ) ? 1 : burst;
+}
+
+void DramController :: SetRefresh ( int interval, int cycles )
+{
+	refreshInterval = ( interval > cycles ) ? interval : 0;
+	refreshCycles = cycles;
+}
+
+void DramController :: SetWriteQueue ( int entries )
+{
+	writeQueueSize = ( entries < 0 ) ? 0 : 
+		( entries > MAX_DRAM_WRITE_QUEUE ) ? MAX_DRAM_WRITE_QUEUE : entries;
+}
+
+void DramController :: Locate ( word_32 address, int & channel, int & bk, int & row )
+{
+	u_word_32 unit = static_cast<u_word_32>( address ) / rowBytes;
+	channel = unit % noOfChannels;
+	unit /= noOfChannels;
+	bk = unit % noOfBanks;
+	row = unit / noOfBanks;
+}
+
+// A bank that was idle when a refresh started has been precharged by it.
+// Returns the clock the bank can take a command for an access at now.
+int DramController :: Refreshed ( int channel, int bk, int now )
+{
+	DramBank & b = bank[channel][bk];
+	int start = ( now > b.readyAt ) ? now : b.readyAt;
+	if ( refreshInterval == 0 ) return start;
+	
+	int refresh = ( start / refreshInterval ) * refreshInterval;
+	if ( refresh != 0 && b.readyAt <= refresh ) b.openRow = -1;
+	return start;
+}
+
+// ... and a command that would fall in a refresh waits for its end.
+int DramController :: Start ( int channel, int bk, int now )
+{
+	int start = Refreshed ( channel, bk, now );
+	if ( refreshInterval == 0 ) return start;
+	
+	int refresh = ( start / refreshInterval ) * refreshInterval;
+	if ( refresh != 0 && start < refresh + refreshCycles )
+	{
+		refreshStalls ++;
+		start = refresh + refreshCycles;
+	}
+	return start;
+}
+
+int DramController :: Access ( int channel, int bk, int row, int now, int noOfWords )
+{
+	DramBank & b = bank[channel][bk];
+	int start = Start ( channel, bk, now );
+	b.rowBefore = b.openRow;
+	b.freeBefore = b.readyAt;
+	b.lastStart = start;
+	int dataAt;
+	if ( b.openRow == row )
+	{
+		rowHits ++;
+		dataAt = start + tCAS;
+	}
+	else if ( b.openRow == -1 )
+	{
+		rowEmpty ++;
+		dataAt = start + tRCD + tCAS;
+	}
+	else
+	{
+		rowConflicts ++;
+		dataAt = start + tRP + tRCD + tCAS;
+	}
+	
+	int first = ( dataAt > busFreeAt[channel] ) ? dataAt : busFreeAt[channel];
+	int end = first + noOfWords * tBurst;
+	busBefore[channel] = busFreeAt[channel];
+	burstAt[channel] = first;
+	busFreeAt[channel] = end;
+	if ( pagePolicy == PAGE_OPEN )
+	{
+		b.openRow = row;
+		b.readyAt = end;
+	}
+	else
+	{
+		b.openRow = -1;
+		b.readyAt = end + tRP;
+	}
+	if ( end > lastClock ) lastClock = end;
+	return first;
+}
+
+// The read goes in the gap before the bank's latest access, which is
+// left as it was timed; so it must hit the row open in the gap, and no
+// refresh may fall in it.
+bool DramController :: ReadAhead ( int channel, int bk, int row, int now, int noOfWords,
+	int & first )
+{
+	DramBank & b = bank[channel][bk];
+	if ( pagePolicy != PAGE_OPEN || b.rowBefore != row || now >= b.lastStart ) 
+		return false;
+	
+	int start = ( now > b.freeBefore ) ? now : b.freeBefore;
+	int dataAt = start + tCAS;
+	int from = ( dataAt > busBefore[channel] ) ? dataAt : busBefore[channel];
+	int end = from + noOfWords * tBurst;
+	if ( end > b.lastStart || end > burstAt[channel] ) return false;
+	if ( refreshInterval != 0 && 
+			( b.freeBefore / refreshInterval != end / refreshInterval ||
+			( start >= refreshInterval && start % refreshInterval < refreshCycles ) ) )
+		return false;
+	
+	rowHits ++;
+	readsReordered ++;
+	b.freeBefore = end;
+	busBefore[channel] = end;
+	first = from;
+	return true;
+}
+
+void DramController :: IssueWrite ( int w )
+{
+	DramWrite & e = writeQueue[w];
+	Access ( e.channel, e.bank, e.row, e.arrival, e.noOfWords );
+	for ( int i = w; i < queuedWrites - 1; i++ )
+		writeQueue[i] = writeQueue[i + 1];
+	queuedWrites --;
+}
+
+// Each pass issues, to a bank that is free before now, a queued write
+// that hits the bank's open row, or else the oldest one.
+void DramController :: DrainWrites ( int now )
+{
+	for ( ;; )
+	{
+		int pick = -1;
+		bool pickHit = false;
+		for ( int w = 0; w < queuedWrites; w++ )
+		{
+			DramWrite & e = writeQueue[w];
+			DramBank & b = bank[e.channel][e.bank];
+			if ( e.arrival >= now || b.readyAt >= now ) continue;
+			bool hit = ( pagePolicy == PAGE_OPEN && b.openRow == e.row );
+			if ( pick == -1 || ( hit == true && pickHit == false ) )
+			{
+				pick = w;
+				pickHit = hit;
+			}
+		}
+		if ( pick == -1 ) return;
+		IssueWrite ( pick );
+	}
+}
+
+// Queued writes that hit the open row of the read's bank go first, when
+// the read would not.
+void DramController :: ReadFirst ( int channel, int bk, int row, int now )
+{
+	DramBank & b = bank[channel][bk];
+	for ( ;; )
+	{
+		Refreshed ( channel, bk, now );
+		if ( b.openRow == -1 || b.openRow == row ) return;
+		int pick = -1;
+		for ( int w = 0; w < queuedWrites && pick == -1; w++ )
+			if ( writeQueue[w].channel == channel && writeQueue[w].bank == bk &&
+					writeQueue[w].row == b.openRow && writeQueue[w].arrival <= now )
+				pick = w;
+		if ( pick == -1 ) return;
+		IssueWrite ( pick );
+		writesReordered ++;
+	}
+}
+
+void DramController :: TimeRead ( word_32 address, int noOfWords )
+{
+	int channel, bk, row;
+	Locate ( address, channel, bk, row );
+	int first;
+	if ( ReadAhead ( channel, bk, row, clock, noOfWords, first ) == false )
+	{
+		DrainWrites ( clock );
+		ReadFirst ( channel, bk, row, clock );
+		first = Access ( channel, bk, row, clock, noOfWords );
+	}
+	
+	lastLatency = hitLatency + first - clock + tBurst - 1;
+	lastOccupancy = lastLatency + ( noOfWords - 1 ) * tBurst;
+	reads ++;
+	readLatency += lastLatency;
+	AccountAccess ( );
+}
+
+// A write is done for the cache once it is in the queue; if the queue is
+// full, the write the scheduler picks is issued to make room.
+void DramController :: PostWrite ( word_32 address, int noOfWords )
+{
+	int channel, bk, row;
+	Locate ( address, channel, bk, row );
+	DrainWrites ( clock );
+	writes ++;
+	
+	if ( writeQueueSize == 0 )
+	{
+		int first = Access ( channel, bk, row, clock, noOfWords );
+		lastLatency = hitLatency + first - clock + tBurst - 1;
+		lastOccupancy = lastLatency + ( noOfWords - 1 ) * tBurst;
+		AccountAccess ( );
+		return;
+	}
+	
+	lastLatency = lastOccupancy = hitLatency;
+	if ( queuedWrites == writeQueueSize )
+	{
+		int pick = 0;
+		for ( int w = 0; w < queuedWrites; w++ )
+		{
+			DramWrite & e = writeQueue[w];
+			if ( pagePolicy == PAGE_OPEN && bank[e.channel][e.bank].openRow == e.row )
+			{
+				pick = w;
+				break;
+			}
+		}
+		DramWrite & e = writeQueue[pick];
+		int done = Access ( e.channel, e.bank, e.row, e.arrival, e.noOfWords ) +
+			e.noOfWords * tBurst;
+		for ( int i = pick; i < queuedWrites - 1; i++ )
+			writeQueue[i] = writeQueue[i + 1];
+		queuedWrites --;
+		writeQueueStalls ++;
+		if ( done > clock )
+			lastLatency = lastOccupancy = hitLatency + done - clock;
+	}
+	
+	DramWrite & e = writeQueue[queuedWrites ++];
+	e.channel = channel;
+	e.bank = bk;
+	e.row = row;
+	e.arrival = clock;
+	e.noOfWords = noOfWords;
+	AccountAccess ( );
+}
+
+bool DramController :: Read ( word_32 address, word_32 & result, int noOfBytes )
+{
+	pthread_mutex_lock ( &mutex );
+	TimeRead ( address, 1 );
+	bool ret = mem -> Read ( address, result, noOfBytes );
+	pthread_mutex_unlock ( &mutex );
+	return ret;
+}
+
+bool DramController :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+{
+	return mem -> Read_nofetch ( address, result, noOfBytes );
+}
+
+bool DramController :: Write ( word_32 address, word_32 value, int noOfBytes )
+{
+	pthread_mutex_lock ( &mutex );
+	PostWrite ( address, 1 );
+	bool ret = mem -> Write ( address, value, noOfBytes );
+	pthread_mutex_unlock ( &mutex );
+	return ret;
+}
+
+bool DramController :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	pthread_mutex_lock ( &mutex );
+	TimeRead ( address, noOfWords );
+	bool ret = mem -> ReadBlock ( address, data, noOfWords );
+	if ( arrival != NULL )
+		for ( int n = 0; n < noOfWords; n++ )
+			arrival[( first + n ) % noOfWords] = lastLatency + n * tBurst;
+	pthread_mutex_unlock ( &mutex );
+	return ret;
+}
+
+bool DramController :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	pthread_mutex_lock ( &mutex );
+	PostWrite ( address, noOfWords );
+	bool ret = mem -> WriteBlock ( address, data, noOfWords );
+	pthread_mutex_unlock ( &mutex );
+	return ret;
+}
+
+void DramController :: Statistics ( )
+{
+	word_64 accesses = rowHits + rowEmpty + rowConflicts;
+	cout << green << "\n[ DramController::Statistics ] " << noOfChannels 
+		<< " channel(s) of " << noOfBanks << " banks, " << rowBytes << " byte rows, "
+		<< ( pagePolicy == PAGE_OPEN ? "open" : "closed" ) << " page" << reset
+		<< "\ntRCD / tCAS / tRP / burst : " << tRCD << " / " << tCAS << " / "
+		<< tRP << " / " << tBurst << " cycles"
+		<< "\nReads : " << reads << ", writes : " << writes
+		<< "\nRow buffer hits : " << rowHits << ", on a closed bank : " << rowEmpty
+		<< ", conflicts : " << rowConflicts
+		<< "\nRow buffer hit ratio : " << ( ( accesses != 0 ) ? 
+			static_cast<double>( rowHits ) / accesses : 0 )
+		<< "\nAverage read latency : " << ( ( reads != 0 ) ?
+			static_cast<double>( readLatency ) / reads : 0 ) << " cycles"
+		<< "\nReads served from an open row ahead of a later access : " 
+		<< readsReordered;
+	if ( writeQueueSize != 0 )
+		cout << "\nWrite queue : " << writeQueueSize << " entries, "
+			<< writesReordered << " writes served ahead of a read, "
+			<< writeQueueStalls << " writes found it full";
+	if ( refreshInterval != 0 )
+		cout << "\nRefreshes : " << lastClock / refreshInterval << " per channel, every "
+			<< refreshInterval << " cycles for " << refreshCycles << " cycles, "
+			<< refreshStalls << " commands delayed by one";
+	cout << flush;
+	mem -> Statistics ( );
+}
+
+void DramController :: AtExit ( )
+{
+	pthread_mutex_destroy ( &mutex );
+}
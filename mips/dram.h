@@ -0,0 +1,137 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __DRAM_H
+# define __DRAM_H
+
+# include "memory.h"
+
+# include <pthread.h>
+
+# define MAX_DRAM_CHANNELS 8
+# define MAX_DRAM_BANKS 64	// per channel
+# define MIN_DRAM_ROW_BYTES 64
+# define MAX_DRAM_WRITE_QUEUE 64
+
+enum PagePolicy { PAGE_OPEN, PAGE_CLOSED };
+
+class DramBank
+{
+public:
+	int openRow;		// -1 when precharged
+	int readyAt;		// first clock it can take a command
+	
+	// The bank before its latest access: idle from freeBefore to
+	// lastStart, with rowBefore open
+	int rowBefore, freeBefore, lastStart;
+};
+
+// A write waiting in the controller's write queue.  The data is already
+// in MainMemory; only the timing is left to do.
+class DramWrite
+{
+public:
+	int channel, bank, row;
+	int arrival;
+	int noOfWords;
+};
+
+// Timing of DRAM behind the last cache level.  MainMemory still holds the
+// data, the controller works out when it is there.  Addresses are spread
+// row by row over the channels, then over the banks of a channel.  A bank
+// keeps its row open ( the open page policy ) or precharges after each
+// access ( closed page ), and the words of an access stream over the
+// channel's bus a burst apart.  Every refresh interval, each channel is
+// refreshed for some cycles, which closes its rows.
+//
+// A cache waits for its reads, so each is timed as it comes, and its time
+// cannot change later.  The cores run a quantum apart, though, so a read
+// may come with an earlier clock than a bank's latest access.  If it hits
+// the row open before that access, it is served first, from that row in
+// the bank's idle time ( FR-FCFS for reads ), as long as it is done before
+// the bank and the channel's bus are taken by the later access.  Writes
+// are posted to a write queue, which is scheduled FR-FCFS: writes go to
+// banks left idle before the next read, row hits first and then the
+// oldest, and a queued write that hits the open row of a read's bank goes
+// ahead of a read that would miss it.  A full queue holds up the write.
+// The main memory latency counts as the controller's own, on every access.
+class DramController : public Cache
+{
+private:
+	MainMemory * mem;
+	int noOfChannels, noOfBanks, rowBytes;
+	PagePolicy pagePolicy;
+	int tRCD, tCAS, tRP, tBurst;	// cycles; tBurst per word
+	int refreshInterval, refreshCycles;	// no refresh if refreshInterval is 0
+	
+	DramBank bank[MAX_DRAM_CHANNELS][MAX_DRAM_BANKS];
+	int busFreeAt[MAX_DRAM_CHANNELS];
+	int busBefore[MAX_DRAM_CHANNELS];	// the bus idle from here ...
+	int burstAt[MAX_DRAM_CHANNELS];		// ... to the latest burst
+	
+	DramWrite writeQueue[MAX_DRAM_WRITE_QUEUE];
+	int writeQueueSize, queuedWrites;
+	
+	// The stage threads of both sides may reach the controller
+	pthread_mutex_t mutex;
+	
+	word_64 reads, writes;
+	word_64 rowHits, rowEmpty, rowConflicts;
+	word_64 readLatency;		// summed, to the first word
+	word_64 readsReordered;		// served ahead of a later access
+	word_64 writesReordered;	// served ahead of a read
+	word_64 writeQueueStalls;
+	word_64 refreshStalls;
+	int lastClock;			// for the number of refreshes
+	
+	void Locate ( word_32 address, int & channel, int & bk, int & row );
+	int Refreshed ( int channel, int bk, int now );
+	int Start ( int channel, int bk, int now );	// after the bank and any refresh
+	int Access ( int channel, int bk, int row, int now, int noOfWords );
+		// returns the clock of the first word
+	void IssueWrite ( int w );
+	bool ReadAhead ( int channel, int bk, int row, int now, int noOfWords, 
+		int & first );		// false if it does not fit
+	void DrainWrites ( int now );		// into banks idle before now
+	void ReadFirst ( int channel, int bk, int row, int now );
+	void PostWrite ( word_32 address, int noOfWords );
+	void TimeRead ( word_32 address, int noOfWords );
+public:
+	DramController ( MainMemory * m, int channels, int banks, int rowSize );
+	
+	void SetPagePolicy ( PagePolicy policy );
+	void SetTimings ( int rcd, int cas, int rp, int burst );
+	void SetRefresh ( int interval, int cycles );
+	void SetWriteQueue ( int entries );
+	
+	void Statistics ( );
+	bool Read ( word_32 address, word_32 & result, int noOfBytes );
+	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes );
+	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	void AtExit ( );
+};
+
+# endif
@@ -27,6 +27,7 @@ void Latch :: Initialise ( )
 {
 	PC = 0;
 	inst.iV = 0;
+	thread = 0;
 	
 	targReg = -1;
 	targReg2 = -1;
@@ -35,6 +36,8 @@ void Latch :: Initialise ( )
 	
 	dataFetchIncomplete = false;	// indicates fetch did not fail.
 	FetchFailedFor = IDRES_FT;	// indicates fetch did not fail.
+	memReadyAt = -1;
+	redirect = false;
 	finished = false;
 }
 
@@ -42,6 +45,7 @@ void LatchCopy ( Latch &ldest, Latch &lsource )
 {
 	ldest.PC = lsource.PC;
 	ldest.inst.iV = lsource.inst.iV;
+	ldest.thread = lsource.thread;
 	
 	ldest.targReg = lsource.targReg;
 	ldest.targReg2 = lsource.targReg2;
@@ -59,6 +63,9 @@ void LatchCopy ( Latch &ldest, Latch &lsource )
 	ldest.ALUOutput = lsource.ALUOutput;
 	ldest.ALUOutputHi = lsource.ALUOutputHi;
 	ldest.LMD = lsource.LMD;
+	ldest.memReadyAt = lsource.memReadyAt;
+	ldest.redirect = lsource.redirect;
+	ldest.redirectPC = lsource.redirectPC;
 	
 	ldest.finished = false;
 }
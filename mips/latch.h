@@ -31,6 +31,7 @@ class Latch
 public:
 	u_word_32 PC;
 	Inst inst;
+	int thread;	// The hardware thread the instruction belongs to
 	
 	int targReg;
 	int targReg2;	// This comes useful in MULT and DIV instructions.
@@ -53,6 +54,11 @@ public:
 	word_32 ALUOutputHi;
 	
 	word_32 LMD;
+	int memReadyAt;		// clock at which Stage3's memory access completes,
+				// -1 until it has been started
+	
+	bool redirect;		// a taken branch that has not yet moved the PC,
+	u_word_32 redirectPC;	// which it does on leaving the last EX stage
 	
 	bool finished;
 	
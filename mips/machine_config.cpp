@@ -0,0 +1,449 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "machine_config.h"
+
+# include <iostream>
+using std::cout;
+using std::cin;
+using std::flush;
+# include <fstream>
+using std::ifstream;
+using std::ofstream;
+# include <cstring>
+using std::strcpy;
+using std::strncpy;
+using std::strcmp;
+using std::strlen;
+using std::strchr;
+# include <cstdio>
+using std::snprintf;
+# include <cstdlib>
+using std::atoi;
+using std::exit;
+# include <strings.h>	// strcasecmp
+
+# include "../include/color.h"
+
+# define CONFIG_LINE_SIZE 256
+
+// Strips leading and trailing blanks, in place
+static char * Trim ( char * s )
+{
+	while ( *s == ' ' || *s == '\t' ) s ++;
+	int n = strlen ( s );
+	while ( n > 0 && ( s[n - 1] == ' ' || s[n - 1] == '\t' || 
+			s[n - 1] == '\r' || s[n - 1] == '\n' ) )
+		s[-- n] = '\0';
+	return s;
+}
+
+// Whole decimal numbers only
+static bool IsNumber ( const char * s, int & value )
+{
+	const char * p = s;
+	if ( *p == '-' ) p ++;
+	if ( *p == '\0' ) return false;
+	for ( ; *p != '\0'; p ++ )
+		if ( *p < '0' || *p > '9' ) return false;
+	value = atoi ( s );
+	return true;
+}
+
+static void MakeKey ( char * key, const char * prefix, const char * name )
+{
+	if ( prefix[0] == '\0' )
+		snprintf ( key, CONFIG_KEY_SIZE, "%s", name );
+	else
+		snprintf ( key, CONFIG_KEY_SIZE, "%s.%s", prefix, name );
+}
+
+MachineConfig :: MachineConfig ( )
+{
+	noOfGiven = noOfEffective = 0;
+	fileName[0] = '\0';
+}
+
+bool MachineConfig :: Set ( const char * key, const char * value, int line )
+{
+	for ( int i = 0; i < noOfGiven; i++ )
+		if ( strcmp ( given[i].key, key ) == 0 )
+		{
+			// Later settings win, so the command line overrides the file
+			strncpy ( given[i].value, value, CONFIG_VALUE_SIZE - 1 );
+			given[i].line = line;
+			return true;
+		}
+	if ( noOfGiven == MAX_CONFIG_ENTRIES || key[0] == '\0' ||
+		strlen ( key ) >= CONFIG_KEY_SIZE || strlen ( value ) >= CONFIG_VALUE_SIZE )
+		return false;
+	
+	ConfigEntry & e = given[noOfGiven ++];
+	strcpy ( e.key, key );
+	strcpy ( e.value, value );
+	e.used = false;
+	e.line = line;
+	return true;
+}
+
+bool MachineConfig :: Load ( const char * filename )
+{
+	ifstream in ( filename );
+	if ( ! in )
+	{
+		cout << red << "\n[ MachineConfig ] Could not open \"" << filename << "\"" 
+			<< reset << flush;
+		return false;
+	}
+	strncpy ( fileName, filename, CONFIG_VALUE_SIZE - 1 );
+	
+	char buffer[CONFIG_LINE_SIZE];
+	char section[CONFIG_KEY_SIZE] = "";
+	int lineNo = 0;
+	while ( in.getline ( buffer, CONFIG_LINE_SIZE ) )
+	{
+		lineNo ++;
+		char * hash = strchr ( buffer, '#' );
+		if ( hash != NULL ) *hash = '\0';
+		char * line = Trim ( buffer );
+		if ( *line == '\0' ) continue;
+		
+		bool ok = true;
+		if ( *line == '[' )
+		{
+			char * close = strchr ( line, ']' );
+			if ( close == NULL ) 
+				ok = false;
+			else
+			{
+				*close = '\0';
+				char * name = Trim ( line + 1 );
+				ok = strlen ( name ) < CONFIG_KEY_SIZE;
+				if ( ok == true ) strcpy ( section, name );
+			}
+		}
+		else
+		{
+			char * equals = strchr ( line, '=' );
+			if ( equals == NULL )
+				ok = false;
+			else
+			{
+				*equals = '\0';
+				char key[CONFIG_KEY_SIZE];
+				MakeKey ( key, section, Trim ( line ) );
+				ok = Set ( key, Trim ( equals + 1 ), lineNo );
+			}
+		}
+		if ( ok == false )
+		{
+			cout << red << "\n[ MachineConfig ] " << filename << ":" << lineNo
+				<< " is not a \"key = value\" or \"[ section ]\" line" 
+				<< reset << flush;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MachineConfig :: Override ( const char * assignment )
+{
+	char buffer[CONFIG_LINE_SIZE];
+	strncpy ( buffer, assignment, CONFIG_LINE_SIZE - 1 );
+	buffer[CONFIG_LINE_SIZE - 1] = '\0';
+	char * equals = strchr ( buffer, '=' );
+	if ( equals != NULL )
+	{
+		*equals = '\0';
+		if ( Set ( Trim ( buffer ), Trim ( equals + 1 ), 0 ) == true )
+			return true;
+	}
+	cout << red << "\n[ MachineConfig ] \"" << assignment 
+		<< "\" is not a key=value setting" << reset << flush;
+	return false;
+}
+
+ConfigEntry * MachineConfig :: Find ( const char * prefix, const char * name )
+{
+	char key[CONFIG_KEY_SIZE];
+	MakeKey ( key, prefix, name );
+	for ( int i = 0; i < noOfGiven; i++ )
+		if ( strcmp ( given[i].key, key ) == 0 )
+		{
+			given[i].used = true;
+			return &given[i];
+		}
+	return NULL;
+}
+
+void MachineConfig :: Record ( const char * prefix, const char * name, const char * value )
+{
+	if ( noOfEffective == MAX_CONFIG_ENTRIES ) return;
+	ConfigEntry & e = effective[noOfEffective ++];
+	MakeKey ( e.key, prefix, name );
+	strncpy ( e.value, value, CONFIG_VALUE_SIZE - 1 );
+	e.value[CONFIG_VALUE_SIZE - 1] = '\0';
+	e.used = true;
+	e.line = 0;
+}
+
+void MachineConfig :: Fail ( ConfigEntry * e, const char * reason )
+{
+	cout << red << "\n[ MachineConfig ] " << e -> key << " = " << e -> value << " ( ";
+	if ( e -> line == 0 )
+		cout << "command line";
+	else
+		cout << fileName << ":" << e -> line;
+	cout << " ) : " << reason << "\nTerminating... \n" << reset << flush;
+	exit ( -4 );
+}
+
+// Once the input runs out ( or is not a number ), asking again is no use;
+// that is a setting missing from the configuration.
+int MachineConfig :: Ask ( const char * prefix, const char * name, int lo, int hi )
+{
+	int value;
+	cin >> value;
+	while ( cin.good ( ) == true && ( value < lo || value > hi ) )
+	{
+		cout << red << "\nBad choice, Enter again : " << reset << flush;
+		cin >> value;
+	}
+	if ( cin.good ( ) == false )
+	{
+		char key[CONFIG_KEY_SIZE];
+		MakeKey ( key, prefix, name );
+		cout << red << "\n[ MachineConfig ] No value for " << key
+			<< "\nTerminating... \n" << reset << flush;
+		exit ( -4 );
+	}
+	return value;
+}
+
+int MachineConfig :: Int ( const char * prefix, const char * name, int lo, int hi )
+{
+	int value;
+	ConfigEntry * e = Find ( prefix, name );
+	if ( e != NULL )
+	{
+		if ( IsNumber ( e -> value, value ) == false )
+			Fail ( e, "not a number" );
+		if ( value < lo || value > hi )
+			Fail ( e, "out of range" );
+		cout << value << flush;
+	}
+	else
+		value = Ask ( prefix, name, lo, hi );
+	char text[CONFIG_VALUE_SIZE];
+	snprintf ( text, CONFIG_VALUE_SIZE, "%d", value );
+	Record ( prefix, name, text );
+	return value;
+}
+
+int MachineConfig :: Choice ( const char * prefix, const char * name, 
+	const char * const * names, int count )
+{
+	int choice = 0;
+	ConfigEntry * e = Find ( prefix, name );
+	if ( e != NULL )
+	{
+		if ( IsNumber ( e -> value, choice ) == false )
+			for ( int i = 0; i < count; i++ )
+				if ( strcasecmp ( e -> value, names[i] ) == 0 )
+					choice = i + 1;
+		if ( choice < 1 || choice > count )
+			Fail ( e, "not one of the choices" );
+		cout << names[choice - 1] << flush;
+	}
+	else
+		choice = Ask ( prefix, name, 1, count );
+	Record ( prefix, name, names[choice - 1] );
+	return choice;
+}
+
+void MachineConfig :: String ( const char * prefix, const char * name, char * value, 
+	int size )
+{
+	ConfigEntry * e = Find ( prefix, name );
+	if ( e != NULL )
+	{
+		strncpy ( value, e -> value, size - 1 );
+		value[size - 1] = '\0';
+		cout << value << flush;
+	}
+	else
+		cin >> value;	// As before, size is the caller's buffer
+	Record ( prefix, name, value );
+}
+
+bool MachineConfig :: Has ( const char * prefix, const char * name )
+{
+	char key[CONFIG_KEY_SIZE];
+	MakeKey ( key, prefix, name );
+	for ( int i = 0; i < noOfGiven; i++ )
+		if ( strcmp ( given[i].key, key ) == 0 )
+			return true;
+	return false;
+}
+
+int MachineConfig :: Value ( const char * prefix, const char * name, int lo, int hi, 
+	int fallback )
+{
+	int value = fallback;
+	ConfigEntry * e = Find ( prefix, name );
+	if ( e != NULL )
+	{
+		if ( IsNumber ( e -> value, value ) == false )
+			Fail ( e, "not a number" );
+		if ( value < lo || value > hi )
+			Fail ( e, "out of range" );
+	}
+	char text[CONFIG_VALUE_SIZE];
+	snprintf ( text, CONFIG_VALUE_SIZE, "%d", value );
+	Record ( prefix, name, text );
+	return value;
+}
+
+void MachineConfig :: Value ( const char * prefix, const char * name, char * value, 
+	int size, const char * fallback )
+{
+	ConfigEntry * e = Find ( prefix, name );
+	strncpy ( value, ( e != NULL ) ? e -> value : fallback, size - 1 );
+	value[size - 1] = '\0';
+	Record ( prefix, name, value );
+}
+
+// Every key some setting of main reads.  In a pattern '#' stands for a
+// number, and '@' for the key of a cache: one of cacheKeys, on its own or
+// followed by a level ( .l# ) of a multilevel cache.
+static const char * knownKeys[] = 
+{
+	"program", "model", "threads", "fetch", "store_buffer", "ex_stages", 
+	"mem_stages", "cores", "quantum", "caches", "shadows",
+	"memory.size", "memory.latency", "memory.timing",
+	"ooo.rob", "ooo.width", "ooo.issue_queue", "ooo.lsq",
+	"thread.#.image", "device.#", "scratchpad.size", "scratchpad.base",
+	"trace.file", "trace.mmap", 
+	"mmu.page_size", "itlb.entries", "itlb.assoc", "dtlb.entries", "dtlb.assoc",
+	"dram.channels", "dram.banks", "dram.row_bytes", "dram.page_policy",
+	"dram.tRCD", "dram.tCAS", "dram.tRP", "dram.burst", "dram.refresh_interval",
+	"dram.refresh_cycles", "dram.write_queue",
+	"unified.inclusion", "unified.ports", "unified.level",
+	"@.kind", "@.blocks", "@.words", "@.assoc", "@.display", "@.levels", 
+	"@.topology", "@.latency", "@.fill", "@.mshrs", "@.replacement", "@.seed",
+	"@.compare", "@.write", "@.write_miss", "@.write_buffer", "@.prefetcher",
+	"@.degree", "@.victims", "@.mrc", "@.mrc_sets", "@.mrc_ways", "@.classify"
+};
+static const char * cacheKeys[] = 
+{
+	"data", "instruction", "unified", "core", "shadow.#.data", 
+	"shadow.#.instruction"
+};
+
+static bool Matches ( const char * pattern, const char * key )
+{
+	for ( ; *pattern != '\0'; pattern ++, key ++ )
+	{
+		if ( *pattern == '#' )
+		{
+			if ( *key < '0' || *key > '9' ) return false;
+			while ( key[1] >= '0' && key[1] <= '9' ) key ++;
+		}
+		else if ( *pattern == '@' )
+		{
+			char expanded[CONFIG_KEY_SIZE * 2];
+			int n = sizeof ( cacheKeys ) / sizeof ( cacheKeys[0] );
+			for ( int i = 0; i < n; i++ )
+			{
+				snprintf ( expanded, sizeof ( expanded ), "%s%s", cacheKeys[i], 
+					pattern + 1 );
+				if ( Matches ( expanded, key ) == true ) return true;
+				snprintf ( expanded, sizeof ( expanded ), "%s.l#%s", cacheKeys[i], 
+					pattern + 1 );
+				if ( Matches ( expanded, key ) == true ) return true;
+			}
+			return false;
+		}
+		else if ( *pattern != *key )
+			return false;
+	}
+	return *key == '\0';
+}
+
+bool MachineConfig :: Known ( const char * key )
+{
+	int n = sizeof ( knownKeys ) / sizeof ( knownKeys[0] );
+	for ( int i = 0; i < n; i++ )
+		if ( Matches ( knownKeys[i], key ) == true )
+			return true;
+	return false;
+}
+
+// A key no setting reads is most likely misspelt, and ends the run.  A
+// known one may just belong to a choice this machine did not make ( the
+// dram keys with memory.timing = fixed, say ), which only gets a warning.
+bool MachineConfig :: Check ( )
+{
+	bool ok = true;
+	for ( int i = 0; i < noOfGiven; i++ )
+	{
+		if ( given[i].used == true ) continue;
+		bool known = Known ( given[i].key );
+		cout << ( known ? yellow : red ) << "\n[ MachineConfig ] " 
+			<< given[i].key << " ( ";
+		if ( given[i].line == 0 )
+			cout << "command line";
+		else
+			cout << fileName << ":" << given[i].line;
+		if ( known == true )
+			cout << " ) is not used by this machine, ignored" << reset << flush;
+		else
+		{
+			cout << " ) is not a setting of this machine" << reset << flush;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool MachineConfig :: Dump ( const char * filename )
+{
+	ofstream file;
+	bool screen = strcmp ( filename, "-" ) == 0;
+	if ( screen == false )
+	{
+		file.open ( filename );
+		if ( ! file )
+		{
+			cout << red << "\n[ MachineConfig ] Could not write \"" << filename 
+				<< "\"" << reset << flush;
+			return false;
+		}
+	}
+	std::ostream & out = screen ? cout : file;
+	out << "\n# The effective configuration; run it again with ./coconut -c <file>\n";
+	for ( int i = 0; i < noOfEffective; i++ )
+		out << effective[i].key << " = " << effective[i].value << "\n";
+	out << flush;
+	return true;
+}
@@ -0,0 +1,92 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __MACHINE_CONFIG_H
+# define __MACHINE_CONFIG_H
+
+// Machine description files.  A file holds lines of
+//	key = value
+// with '#' starting a comment; a line "[ section ]" prefixes the keys
+// after it with "section.".  Keys given on the command line as
+// key=value override the file.  Every setting main asks for goes
+// through here: a configured value is used ( and echoed after the prompt ),
+// anything not configured is asked for as before.  The values used,
+// configured or typed in, make up the effective configuration, which
+// can be written out as a file of its own.
+
+# define MAX_CONFIG_ENTRIES 256
+# define CONFIG_KEY_SIZE 64
+# define CONFIG_VALUE_SIZE 128
+
+class ConfigEntry
+{
+public:
+	char key[CONFIG_KEY_SIZE];
+	char value[CONFIG_VALUE_SIZE];
+	bool used;		// asked for by main
+	int line;		// in the file, 0 for the command line
+};
+
+class MachineConfig
+{
+private:
+	ConfigEntry given[MAX_CONFIG_ENTRIES];	// from the file and the command line
+	int noOfGiven;
+	ConfigEntry effective[MAX_CONFIG_ENTRIES];	// as used, in the order asked
+	int noOfEffective;
+	char fileName[CONFIG_VALUE_SIZE];
+	
+	bool Set ( const char * key, const char * value, int line );
+	ConfigEntry * Find ( const char * prefix, const char * name );
+	void Record ( const char * prefix, const char * name, const char * value );
+	void Fail ( ConfigEntry * e, const char * reason );	// does not return
+	int Ask ( const char * prefix, const char * name, int lo, int hi );
+		// reads an unset value from cin
+public:
+	MachineConfig ( );
+	
+	bool Load ( const char * filename );	// false on an unreadable file or bad line
+	bool Override ( const char * assignment );	// "key=value"
+	
+	// The key is prefix.name ( just name for an empty prefix ).  A
+	// configured value out of range, or not one of the names, ends the
+	// program; a typed one is asked for again.
+	int Int ( const char * prefix, const char * name, int lo, int hi );
+	int Choice ( const char * prefix, const char * name, const char * const * names,
+		int count );	// 1 for names[0], as in the menus; the number or the name
+	void String ( const char * prefix, const char * name, char * value, int size );
+	
+	// These are not asked for: the fallback is used unless configured.
+	bool Has ( const char * prefix, const char * name );
+	int Value ( const char * prefix, const char * name, int lo, int hi, int fallback );
+	void Value ( const char * prefix, const char * name, char * value, int size,
+		const char * fallback );
+	
+	bool Known ( const char * key );	// read by some setting of main
+	
+	// Lists the keys never asked for; false if any of them is not Known.
+	bool Check ( );
+	bool Dump ( const char * filename );	// "-" for the screen
+};
+
+# endif
@@ -23,9 +23,13 @@
 
 # include <iostream>
 using std::cout;
-using std::cin;
 using std::flush;
 
+# include <cstring>
+using std::strcmp;
+# include <cstdio>
+using std::snprintf;
+
 # include <fcntl.h>
 # include <semaphore.h>
 sem_t * cout_mutex;	// Referred as extern from all
@@ -34,9 +38,20 @@ sem_t * cout_mutex;	// Referred as extern from all
 	// while c-ing out...
 
 # include "processor.h"
+# include "ooo_processor.h"
+# include "multicore.h"
+# include "coherence_bus.h"
 # include "memory.h"
 # include "simple_cache.h"
+# include "static_cache.h"
+# include "shared_cache.h"
+# include "mmu.h"
+# include "scratchpad.h"
+# include "shadow.h"
+# include "trace.h"
+# include "dram.h"
 # include "portmanager.h"
+# include "machine_config.h"
 
 # include "../include/color.h"
 
@@ -45,10 +60,56 @@ sem_t * cout_mutex;	// Referred as extern from all
 
 // Does it justify having a declaration when the definition is also in the same file?
 // Why not move the definition up here?
-Cache * pickCache ( Cache * mem, bool noMultilevel, char * type, int level );
+Cache * pickCache ( Cache * mem, bool noMultilevel, const char * type, int level, 
+	const char * key );
+void pickTiming ( int & hitLatency, FillPolicy & fill, int & mshrs, 
+	const char * key );	// For a SimpleCache
+void pickReplacement ( ReplacementPolicy & policy, unsigned int & seed, bool & compare,
+	const char * key );
+void pickWritePolicy ( bool & through, bool & allocate, int & bufferEntries, 
+	const char * key );
+void pickPrefetcher ( PrefetchKind & kind, int & degree, const char * key );
+SharedCache * pickSharedCache ( Cache * mem );
+Cache * pickDram ( MainMemory * mem, int latency );
+void attachAbove ( Cache * below, SimpleCache * above );
+PageTable * pickMmu ( MainMemory * mem, int * tlbEntries, int * tlbAssoc );
+Scratchpad * makeScratchpad ( MainMemory * mem, Cache * dc, int base, int size );
+ShadowSet * pickShadows ( int latency );
+bool finishConfig ( const char * dumpFile );
+
+// Every setting is looked up here before it is asked for; the keys
+// are given with each call.
+MachineConfig config;
+
+# define MEMORY_SIZE 0	// the whole 32-bit address space, unless configured
+# define MAX_INT 0x7fffffff
+
+static const char * yesNo[] = { "yes", "no" };
 
-int main ( )
+// ./coconut [ -c machine.cfg ] [ -d effective.cfg ] [ key=value ... ]
+int main ( int argc, char * argv[] )
 {	
+	const char * dumpFile = NULL;
+	for ( int a = 1; a < argc; a++ )
+	{
+		bool ok;
+		if ( strcmp ( argv[a], "-c" ) == 0 && a + 1 < argc )
+			ok = config.Load ( argv[++ a] );
+		else if ( strcmp ( argv[a], "-d" ) == 0 && a + 1 < argc )
+		{
+			dumpFile = argv[++ a];
+			ok = true;
+		}
+		else
+			ok = config.Override ( argv[a] );
+		if ( ok == false )
+		{
+			cout << red << "\nUsage : coconut [ -c machine.cfg ] [ -d effective.cfg ]"
+				<< " [ key=value ... ]\nTerminating... \n" << reset << flush;
+			return -4;
+		}
+	}
+	
 	cout_mutex = sem_open ( "/coutmutex", O_CREAT | O_EXCL, O_RDWR, 1 );
 	if ( cout_mutex == NULL )
 	{
@@ -62,28 +123,46 @@ int main ( )
 		return -3;
 	}
 	
-	// TODO this should be a configuration
-	MainMemory * mem = new MainMemory ( 4914304 ); // 4 MB
+	MainMemory * mem = new MainMemory ( config.Value ( "memory", "size", 
+		0, MAX_INT, MEMORY_SIZE ) );
+	cout << "\nEnter the main memory latency in cycles : ";
+	int memLatency = config.Int ( "memory", "latency", 1, MAX_INT );
+	mem -> SetLatency ( memLatency );
 	
 	// Here we initialise the memory system
 	// so that the processor starting address 
 	// contains the bootloader snippet.
-	if( ! mem -> Load_MIPS_program ( "a.out" ) )
+	char program[CONFIG_VALUE_SIZE];
+	config.Value ( "", "program", program, CONFIG_VALUE_SIZE, "a.out" );
+	if( ! mem -> Load_MIPS_program ( program ) )
 	{
-		cout << red << "\nError, could not load the \"a,out\" program..."
+		cout << red << "\nError, could not load the \"" << program << "\" program..."
 			<< "\nTerminating... \n" << reset << flush;
 		return -2;
 	}
 	
+	// The caches sit on the DRAM controller, if there is one
+	Cache * memory = pickDram ( mem, memLatency );
+	
 	Cache *dc = NULL, *ic = NULL;
 	
+	// With shared levels, each side's caches sit on its port of them
+	SharedCache * shared = pickSharedCache ( memory );
+	Cache * dataBelow = memory, * instrBelow = memory;
+	if ( shared != NULL )
+	{
+		dataBelow = shared -> Port ( REQUESTER_DATA );
+		instrBelow = shared -> Port ( REQUESTER_INSTRUCTION );
+	}
+	
 	cout << "\nChoose the type of cache you want for " 
 		<< green << "Data" << reset << flush;
-	dc = pickCache ( mem, false, "DATA", 1 );	// Multilevels are allowed
+	dc = pickCache ( dataBelow, false, "DATA", 1, "data" );	// Multilevels are allowed
 	
 	cout << "\nChoose the type of cache you want for "
 		<< green << "Instructions" << reset << flush;
-	ic = pickCache ( mem, false, "INSTRUCTION", 1 );	// Multilevels are allowed
+	ic = pickCache ( instrBelow, false, "INSTRUCTION", 1, "instruction" );
+		// Multilevels are allowed
 	
 	if ( dc == NULL ) // No data cache
 	{
@@ -99,39 +178,258 @@ int main ( )
 		return -1;
 	}
 	
+	// Other hierarchies to try out on the same run, see shadow.h
+	ShadowSet * shadows = pickShadows ( memLatency );
+	
+	// With an MMU, the pipeline reaches the caches through it
+	int tlbEntries[NO_OF_REQUESTERS], tlbAssoc[NO_OF_REQUESTERS];
+	PageTable * pageTable = pickMmu ( mem, tlbEntries, tlbAssoc );
+	if ( pageTable != NULL )
+	{
+		Mmu * mmu = new Mmu ( pageTable, dc, ic, 
+			tlbEntries[REQUESTER_DATA], tlbAssoc[REQUESTER_DATA],
+			tlbEntries[REQUESTER_INSTRUCTION], tlbAssoc[REQUESTER_INSTRUCTION] );
+		dc = mmu -> Port ( REQUESTER_DATA );
+		ic = mmu -> Port ( REQUESTER_INSTRUCTION );
+	}
+	
+	// A scratchpad is only ever set up by a machine description or on the
+	// command line ( scratchpad.size = bytes ), each core gets its own.
+	int spSize = config.Value ( "scratchpad", "size", 0, MAX_SCRATCHPAD_SIZE, 0 );
+	int spBase = config.Value ( "scratchpad", "base", 0, MAX_INT, SCRATCHPAD_BASE );
+	
 	// We also need to create the port manager system
 	// And set up the mapping between ports or device numbers
-	// and sockets...
+	// and sockets...  Devices 1 and 2 are a character input and a
+	// character output device unless configured otherwise; "device.N = 0"
+	// leaves device N out.
 	PortManager * pMan = new PortManager ( );
-	pMan -> AddPort ( 1, INPUTPORT );	// A character Input device
-	pMan -> AddPort ( 2, OUTPUTPORT );	// A character Output device
+	for ( int d = 1; d < MAX_PORTS; d++ )
+	{
+		char name[8];
+		snprintf ( name, sizeof ( name ), "%d", d );
+		if ( d > 2 && config.Has ( "device", name ) == false ) continue;
+		int socketPort = config.Value ( "device", name, 0, 65535,
+			( d == 1 ) ? INPUTPORT : ( d == 2 ) ? OUTPUTPORT : 0 );
+		if ( socketPort != 0 )
+			pMan -> AddPort ( d, socketPort );
+	}
 	
-	Processor proc ( mem, dc,ic, pMan );
-	proc.Execute ( );	// Now this thread runs the processor clock function...
+	cout << "\nChoose the processor model : "
+		<< "\n 1. 5-stage in-order pipeline"
+		<< "\n 2. Out-of-order core"
+		<< "\nPlease enter your choice : " << flush;
+	static const char * models[] = { "in-order", "out-of-order" };
+	int model = config.Choice ( "", "model", models, 2 );
+	
+	if ( model == 2 )
+	{
+		cout << "\nEnter number of reorder buffer entries : ";
+		int robsz = config.Int ( "ooo", "rob", 1, MAX_INT );
+		cout << "\nEnter fetch / dispatch / issue / retire width (max "
+			<< OOO_MAX_WIDTH << ") : ";
+		int wid = config.Int ( "ooo", "width", 1, OOO_MAX_WIDTH );
+		cout << "\nEnter number of issue queue entries : ";
+		int iqsz = config.Int ( "ooo", "issue_queue", 1, MAX_INT );
+		cout << "\nEnter number of load/store queue entries : ";
+		int lsqsz = config.Int ( "ooo", "lsq", 1, MAX_INT );
+		if ( finishConfig ( dumpFile ) == false ) return -4;
+		
+		OOOProcessor oooProc ( mem, dc, ic, pMan, robsz, wid, iqsz, lsqsz );
+		if ( spSize > 0 )
+			oooProc.SetScratchpad ( makeScratchpad ( mem, dc, spBase, spSize ) );
+		oooProc.SetShadows ( shadows );
+		oooProc.Execute ( );	// Runs the model on this thread...
+		return 0;
+	}
+	
+	cout << "\nEnter number of hardware threads (1-" << MAX_HW_THREADS << ") : ";
+	int threads = config.Int ( "", "threads", 1, MAX_HW_THREADS );
+	
+	FetchPolicy policy = FETCH_ROUND_ROBIN;
+	u_word_32 threadStart[MAX_HW_THREADS];
+	for ( int t = 0; t < threads; t++ )
+		threadStart[t] = SYSTEM_START_ADDRESS;
+	
+	if ( threads > 1 )
+	{
+		cout << "\nChoose the thread fetch policy : "
+			<< "\n 1. Round robin"
+			<< "\n 2. Stall aware (skip threads with a load or branch in flight)"
+			<< "\nPlease enter your choice : " << flush;
+		static const char * policies[] = { "round-robin", "stall-aware" };
+		int choice = config.Choice ( "", "fetch", policies, 2 );
+		policy = ( choice == 1 ) ? FETCH_ROUND_ROBIN : FETCH_STALL_AWARE;
+		
+		// Each thread finds its number in $k0.  A thread may also run
+		// a program of its own, which must be assembled at addresses
+		// ( 'begin' ) that do not overlap the other images.
+		for ( int t = 1; t < threads; t++ )
+		{
+			cout << "\nEnter program image for thread " << t
+				<< " ( - to share \"" << program << "\" ) : " << flush;
+			char image[256];
+			char key[CONFIG_KEY_SIZE];
+			snprintf ( key, CONFIG_KEY_SIZE, "thread.%d", t );
+			config.String ( key, "image", image, sizeof ( image ) );
+			if ( image[0] == '-' && image[1] == '\0' ) continue;
+			if ( ! mem -> Load_MIPS_program ( image, &threadStart[t] ) )
+			{
+				cout << red << "\nError, could not load \"" << image 
+					<< "\", thread " << t << " will share \"" << program << "\""
+					<< reset << flush;
+				threadStart[t] = SYSTEM_START_ADDRESS;
+			}
+		}
+	}
+	
+	cout << "\nEnter number of store buffer entries ( 0 for none ) : ";
+	int sbEntries = config.Int ( "", "store_buffer", 0, MAX_INT );
+	
+	cout << "\nEnter number of EX stages (1-" << MAX_SUBSTAGES << ") : ";
+	int exStages = config.Int ( "", "ex_stages", 1, MAX_SUBSTAGES );
+	cout << "\nEnter number of MEM stages (1-" << MAX_SUBSTAGES << ") : ";
+	int memStages = config.Int ( "", "mem_stages", 1, MAX_SUBSTAGES );
+	
+	cout << "\nEnter number of cores (1-" << MAX_CORES << ") : ";
+	int cores = config.Int ( "", "cores", 1, MAX_CORES );
+	
+	if ( cores == 1 )
+	{
+		if ( finishConfig ( dumpFile ) == false ) return -4;
+		Processor proc ( mem, dc,ic, pMan, threads, policy );
+		for ( int t = 1; t < threads; t++ )
+			proc.SetThreadStart ( t, threadStart[t] );
+		proc.SetStoreBuffer ( sbEntries );
+		if ( spSize > 0 )
+			proc.SetScratchpad ( makeScratchpad ( mem, dc, spBase, spSize ) );
+		proc.SetShadows ( shadows );
+		proc.SetPipelineDepth ( exStages, memStages );
+		proc.Execute ( );	// Now this thread runs the processor clock function...
+		
+		return 0;
+	}
+	
+	// Every core gets private L1 caches, in place of the ones chosen 
+	// above, kept coherent over a bus.  Each core runs all the threads
+	// given above; $k0 numbers the threads across the cores.
+	cout << "\nEach core has private MESI " << green << "L1 Data" << reset 
+		<< " and " << green << "L1 Instruction" << reset << " caches"
+		<< "\nEnter number of Blocks in each L1 cache : ";
+	int nob = config.Int ( "core", "blocks", 1, MAX_INT );
+	cout << "\nEnter number of words per block : ";
+	int wpb = config.Int ( "core", "words", 1, MAX_INT );
+	cout << "\nEnter associativity : ";
+	int assoc = config.Int ( "core", "assoc", 1, nob );
+	cout << "\nSelect extent of cache info displayed : "
+		<< "\n 1.verbose"
+		<< "\n 2.silent"
+		<< "\nEnter your choice : ";
+	static const char * displays[] = { "verbose", "silent" };
+	int display = config.Choice ( "core", "display", displays, 2 );
+	bool verbose = ( display == 1 )? true : false ;
+	int hitLatency, mshrs; FillPolicy fill;
+	pickTiming ( hitLatency, fill, mshrs, "core" );
+	ReplacementPolicy repl; unsigned int seed; bool compare;
+	pickReplacement ( repl, seed, compare, "core" );
+	cout << "\nEnter the quantum ( cycles a core may run ahead of the others ) : ";
+	int quantum = config.Int ( "", "quantum", 1, MAX_INT );
+	if ( finishConfig ( dumpFile ) == false ) return -4;
+	
+	dc -> AtExit ( );
+	ic -> AtExit ( );
+	if ( shared != NULL )
+		shared -> AtExit ( );
+	
+	CoherenceBus * bus = new CoherenceBus ( wpb * 4 );
+	MultiCore * system = new MultiCore ( bus, quantum );
+	for ( int c = 0; c < cores; c++ )
+	{
+		SimpleCache * cdc = new SimpleCache ( memory, nob, wpb, assoc, "DATA", 1, verbose );
+		SimpleCache * cic = new SimpleCache ( memory, nob, wpb, assoc, "INSTRUCTION", 1, 
+			verbose );
+		cdc -> SetLatency ( hitLatency );
+		cic -> SetLatency ( hitLatency );
+		cdc -> SetFillPolicy ( fill );
+		cic -> SetFillPolicy ( fill );
+		cdc -> SetMSHRs ( mshrs );
+		cic -> SetMSHRs ( mshrs );
+		cdc -> SetReplacement ( repl, seed );
+		cic -> SetReplacement ( repl, seed );
+		if ( compare == true )
+		{
+			cdc -> ComparePolicies ( seed );
+			cic -> ComparePolicies ( seed );
+		}
+		cdc -> AttachBus ( bus, c, true );
+		cic -> AttachBus ( bus, c, false );	// Code is not written to
+		
+		// Each core has TLBs of its own over the one page table
+		Cache * pdc = cdc, * pic = cic;
+		if ( pageTable != NULL )
+		{
+			Mmu * mmu = new Mmu ( pageTable, cdc, cic, 
+				tlbEntries[REQUESTER_DATA], tlbAssoc[REQUESTER_DATA],
+				tlbEntries[REQUESTER_INSTRUCTION], tlbAssoc[REQUESTER_INSTRUCTION] );
+			pdc = mmu -> Port ( REQUESTER_DATA );
+			pic = mmu -> Port ( REQUESTER_INSTRUCTION );
+		}
+		
+		Processor * p = new Processor ( mem, pdc, pic, pMan, threads, policy,
+			bus, system, c );
+		for ( int t = 1; t < threads; t++ )
+			p -> SetThreadStart ( t, threadStart[t] );
+		p -> SetStoreBuffer ( sbEntries );
+		if ( spSize > 0 )
+			p -> SetScratchpad ( makeScratchpad ( mem, pdc, spBase, spSize ) );
+		if ( c == 0 )
+			p -> SetShadows ( shadows );	// They watch the first core
+		p -> SetPipelineDepth ( exStages, memStages );
+		system -> AddCore ( p );
+	}
+	system -> Execute ( );	// This thread runs the clock of core 0...
 	
 	return 0;
 }
 
+// Called once everything is set up: keys that no setting reads are errors
+// ( most likely misspelt ), known ones this machine never asked for are
+// listed and ignored, and the configuration used is written out if asked to.
+bool finishConfig ( const char * dumpFile )
+{
+	if ( config.Check ( ) == false )
+	{
+		cout << red << "\nTerminating... \n" << reset << flush;
+		return false;
+	}
+	if ( dumpFile != NULL )
+		config.Dump ( dumpFile );
+	return true;
+}
+
 # define MULTILEVEL 3
+# define STATIC_HIERARCHY 4	// only over the main memory
 
-Cache * pickCache ( Cache * mem, bool noMultilevel, char * type, int level )
+// The settings of a cache are under key ( "data", "instruction" or
+// "unified" ); those of each level of a multilevel cache are under
+// key.l1, key.l2 and so on.
+Cache * pickCache ( Cache * mem, bool noMultilevel, const char * type, int level, 
+	const char * key )
 {
+	bool overMemory = dynamic_cast<MainMemory *>( mem ) != NULL;
 	cout << "\n" << level << "-level " << type 
 		<< " Cache : The choices available are"
 		<< "\n 1. No Cache "
-		<< "\n 2. Simple single level FIFO writeback cache ";
+		<< "\n 2. Simple single level writeback cache ";
 	if ( noMultilevel == false )
 		cout << "\n " << MULTILEVEL << ". Multilevel Cache ";
+	if ( noMultilevel == false && overMemory == true )
+		cout << "\n " << STATIC_HIERARCHY << ". Prebuilt cache hierarchy ";
 	cout << "\nPlease enter your choice : " << flush;
 	
-	int choice;
-	cin >> choice;
-	while ( choice < 1 || ( noMultilevel == true && choice > (MULTILEVEL-1) ) ||
-		( noMultilevel == false && choice > MULTILEVEL ) )
-	{
-		cout << red << "\nBad choice, Enter again : " << reset << flush;
-		cin >> choice;
-	}
+	static const char * kinds[] = { "none", "simple", "multilevel", "prebuilt" };
+	int choice = config.Choice ( key, "kind", kinds, 
+		noMultilevel ? MULTILEVEL - 1 : overMemory ? STATIC_HIERARCHY : MULTILEVEL );
 	
 	Cache * c = NULL;
 	
@@ -143,42 +441,346 @@ Cache * pickCache ( Cache * mem, bool noMultilevel, char * type, int level )
 	case 2: 
 		{
 			cout << "\nEnter number of Blocks in cache : ";
-			int nob; cin >> nob;
+			int nob = config.Int ( key, "blocks", 1, MAX_INT );
 			cout << "\nEnter number of words per block : ";
-			int wpb; cin >> wpb;
+			int wpb = config.Int ( key, "words", 1, MAX_INT );
 			cout << "\nEnter associativity : ";
-			int assoc; cin >> assoc;
+			int assoc = config.Int ( key, "assoc", 1, nob );
 			cout << "\nSelect extent of cache info displayed : "
 				<< "\n 1.verbose"
 				<< "\n 2.silent"
 				<< "\nEnter your choice : ";
-			int display; cin >> display;
-			while ( display < 1 || display > 2 )
-			{
-				cout << red << "\nBad choice, Enter again : " 
-					<< reset << flush;
-				cin >> display;
-			}
+			static const char * displays[] = { "verbose", "silent" };
+			int display = config.Choice ( key, "display", displays, 2 );
 			bool verbose = ( display == 1 )? true : false ;
+			int hitLatency, mshrs; FillPolicy fill;
+			pickTiming ( hitLatency, fill, mshrs, key );
+			ReplacementPolicy repl; unsigned int seed; bool compare;
+			pickReplacement ( repl, seed, compare, key );
+			bool through, allocate; int bufferEntries;
+			pickWritePolicy ( through, allocate, bufferEntries, key );
+			PrefetchKind prefetch; int degree;
+			pickPrefetcher ( prefetch, degree, key );
+			cout << "\nEnter the number of victim cache entries ( 0 for none ) : ";
+			int victims = config.Int ( key, "victims", 0, MAX_INT );
+			// Miss ratio curves only come from a machine description or
+			// the command line ( key.mrc = file.csv )
+			char mrc[CONFIG_VALUE_SIZE];
+			config.Value ( key, "mrc", mrc, CONFIG_VALUE_SIZE, "" );
+			// The misses are told apart by cause, and counted per set,
+			// only if key.classify = 1, as it costs a shadow LRU cache
+			int classify = config.Value ( key, "classify", 0, 1, 0 );
 			
-			c = dynamic_cast<Cache *>( new SimpleCache(mem, nob, wpb,
-					assoc, type, level, verbose) );
+			SimpleCache * sc = new SimpleCache(mem, nob, wpb,
+					assoc, type, level, verbose);
+			sc -> SetLatency ( hitLatency );
+			sc -> SetFillPolicy ( fill );
+			sc -> SetMSHRs ( mshrs );
+			sc -> SetReplacement ( repl, seed );
+			if ( compare == true )
+				sc -> ComparePolicies ( seed );
+			sc -> SetWritePolicy ( through, allocate, bufferEntries );
+			sc -> SetPrefetcher ( prefetch, degree );
+			sc -> SetVictimCache ( victims );
+			if ( mrc[0] != '\0' )
+				sc -> ProfileStackDistances ( mrc, 
+					config.Value ( key, "mrc_sets", 2, MAX_STACK_SETS, DEFAULT_STACK_SETS ),
+					config.Value ( key, "mrc_ways", 1, MAX_STACK_WAYS, DEFAULT_STACK_WAYS ) );
+			if ( classify == 1 )
+				sc -> ClassifyMisses ( );
+			attachAbove ( mem, sc );
+			c = dynamic_cast<Cache *>( sc );
 		}
 		break;
 	case MULTILEVEL:
 		{
 			cout << "\nEnter the number of levels in the Cache : ";
-			int noLevels; cin >> noLevels;
+			int noLevels = config.Int ( key, "levels", 1, MAX_INT );
 			Cache * prev_c = mem;
 			for ( int i = 0; i < noLevels; i++ )
 			{
-				cout << "\nChoose the " << noLevels - i << "-level cache : ";
-				c = pickCache ( prev_c, true, type, noLevels - i );
+				int l = noLevels - i + level - 1;
+				char levelKey[CONFIG_KEY_SIZE];
+				snprintf ( levelKey, CONFIG_KEY_SIZE, "%s.l%d", key, l );
+				cout << "\nChoose the " << l << "-level cache : ";
+				c = pickCache ( prev_c, true, type, l, levelKey );
 					// 2-nd arg = true => no multilevel
 				prev_c = c;
 			}
 		}
 		break;
+	case STATIC_HIERARCHY:
+		{
+			cout << "\nThe prebuilt hierarchies are";
+			for ( int t = 0; t < NO_OF_STATIC_TOPOLOGIES; t++ )
+				cout << "\n " << t + 1 << ". " << StaticTopology::Name ( t );
+			cout << "\nEnter your choice : ";
+			int topology = config.Int ( key, "topology", 1, NO_OF_STATIC_TOPOLOGIES );
+			c = StaticTopology::Build ( topology - 1, 
+				dynamic_cast<MainMemory *>( mem ), type );
+		}
+		break;
 	};
 	return c;
 }
+
+// The main memory is either a fixed latency away, or behind a DRAM
+// controller whose timing is asked for here; the main memory latency
+// is then that of the controller itself.
+Cache * pickDram ( MainMemory * mem, int latency )
+{
+	cout << "\nChoose the main memory timing : "
+		<< "\n 1. Fixed latency"
+		<< "\n 2. DRAM ( banks, row buffers, refresh ) behind a controller"
+		<< "\nPlease enter your choice : " << flush;
+	static const char * timings[] = { "fixed", "dram" };
+	if ( config.Choice ( "memory", "timing", timings, 2 ) == 1 ) return mem;
+	
+	cout << "\nEnter number of channels (1-" << MAX_DRAM_CHANNELS << ") : ";
+	int channels = config.Int ( "dram", "channels", 1, MAX_DRAM_CHANNELS );
+	cout << "\nEnter number of banks per channel (1-" << MAX_DRAM_BANKS << ") : ";
+	int banks = config.Int ( "dram", "banks", 1, MAX_DRAM_BANKS );
+	cout << "\nEnter the row size in bytes : ";
+	int rowBytes = config.Int ( "dram", "row_bytes", MIN_DRAM_ROW_BYTES, MAX_INT );
+	DramController * dram = new DramController ( mem, channels, banks, rowBytes );
+	dram -> SetLatency ( latency );	// the controller's own
+	
+	cout << "\nChoose the page policy : "
+		<< "\n 1. open page ( rows stay open for later hits )"
+		<< "\n 2. closed page ( precharge after every access )"
+		<< "\nEnter your choice : ";
+	static const char * policies[] = { "open", "closed" };
+	int policy = config.Choice ( "dram", "page_policy", policies, 2 );
+	dram -> SetPagePolicy ( ( policy == 1 ) ? PAGE_OPEN : PAGE_CLOSED );
+	
+	cout << "\nEnter tRCD ( activate to read ) in cycles : ";
+	int rcd = config.Int ( "dram", "tRCD", 0, MAX_INT );
+	cout << "\nEnter tCAS ( read to data ) in cycles : ";
+	int cas = config.Int ( "dram", "tCAS", 0, MAX_INT );
+	cout << "\nEnter tRP ( precharge ) in cycles : ";
+	int rp = config.Int ( "dram", "tRP", 0, MAX_INT );
+	cout << "\nEnter the bus cycles per word : ";
+	int burst = config.Int ( "dram", "burst", 1, MAX_INT );
+	dram -> SetTimings ( rcd, cas, rp, burst );
+	
+	cout << "\nEnter the refresh interval in cycles ( 0 for no refresh ) : ";
+	int interval = config.Int ( "dram", "refresh_interval", 0, MAX_INT );
+	int cycles = 0;
+	if ( interval != 0 )
+	{
+		cout << "\nEnter the cycles each refresh takes : ";
+		cycles = config.Int ( "dram", "refresh_cycles", 1, interval - 1 );
+	}
+	dram -> SetRefresh ( interval, cycles );
+	
+	cout << "\nEnter number of write queue entries (0-" << MAX_DRAM_WRITE_QUEUE
+		<< ", 0 to write at once) : ";
+	dram -> SetWriteQueue ( config.Int ( "dram", "write_queue", 0, MAX_DRAM_WRITE_QUEUE ) );
+	return dram;
+}
+
+// Lower levels shared by data and instructions, or NULL for separate
+// hierarchies.  They are picked like a cache of their own, from level 2
+// down, or from unified.level ( only configured ) when each side keeps
+// private levels above them: with 3, a private L2 on each side ( a two
+// level multilevel cache ) sits over a shared L3.
+SharedCache * pickSharedCache ( Cache * mem )
+{
+	cout << "\nShould data and instructions share the lower cache levels ?"
+		<< "\n 1. No, separate hierarchies"
+		<< "\n 2. Yes, unified lower levels ( an L2 and below, unless configured )"
+		<< "\nPlease enter your choice : " << flush;
+	static const char * hierarchies[] = { "separate", "unified" };
+	int choice = config.Choice ( "", "caches", hierarchies, 2 );
+	if ( choice == 1 ) return NULL;
+	
+	int first = config.Value ( "unified", "level", 2, MAX_INT, 2 );
+	cout << "\nChoose the type of cache you want for the " 
+		<< green << "Unified" << reset << " levels, from level " << first 
+		<< " ( the levels above it are each side's own )" << flush;
+	Cache * unified = pickCache ( mem, false, "UNIFIED", first, "unified" );
+	
+	cout << "\nThe unified cache holds the lines of the caches above it : "
+		<< "\n 1. non-inclusive"
+		<< "\n 2. inclusive ( evicting a line takes it from above too )"
+		<< "\n 3. exclusive ( a line is either above or here )"
+		<< "\nEnter your choice : ";
+	static const char * inclusions[] = { "non-inclusive", "inclusive", "exclusive" };
+	int inclusion = config.Choice ( "unified", "inclusion", inclusions, 3 );
+	cout << "\nEnter the number of ports of the unified cache ( 1-" 
+		<< MAX_SHARED_PORTS << " ) : ";
+	int ports = config.Int ( "unified", "ports", 1, MAX_SHARED_PORTS );
+	return new SharedCache ( unified, ports, 
+		static_cast<InclusionPolicy>( inclusion - 1 ) );
+}
+
+// Lets the level below reach the new cache, for inclusion
+void attachAbove ( Cache * below, SimpleCache * above )
+{
+	SimpleCache * sc = dynamic_cast<SimpleCache *>( below );
+	CachePort * port = dynamic_cast<CachePort *>( below );
+	if ( sc != NULL )
+		sc -> AddUpper ( above );
+	else if ( port != NULL )
+		port -> Shared ( ) -> AddUpper ( above );
+}
+
+PageTable * pickMmu ( MainMemory * mem, int * tlbEntries, int * tlbAssoc )
+{
+	cout << "\nEnter the page size in bytes ( " << MIN_PAGE_SIZE << "-" << MAX_PAGE_SIZE
+		<< ", 0 for no MMU ) : ";
+	int pageSize = config.Int ( "mmu", "page_size", 0, MAX_PAGE_SIZE );
+	if ( pageSize == 0 ) return NULL;
+	
+	static const char * keys[NO_OF_REQUESTERS] = { "dtlb", "itlb" };
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+	{
+		cout << "\nEnter number of " << green << Cache::RequesterName ( r ) << reset 
+			<< " TLB entries : ";
+		tlbEntries[r] = config.Int ( keys[r], "entries", 1, MAX_TLB_ENTRIES );
+		cout << "\nEnter associativity : ";
+		tlbAssoc[r] = config.Int ( keys[r], "assoc", 1, tlbEntries[r] );
+	}
+	return new PageTable ( mem, pageSize );
+}
+
+// The scratchpad starts out with what the program image has in its range.
+Scratchpad * makeScratchpad ( MainMemory * mem, Cache * dc, int base, int size )
+{
+	Scratchpad * sp = new Scratchpad ( base, size, dc );
+	sp -> Preload ( mem );
+	return sp;
+}
+
+// Shadow hierarchies are only ever set up by a machine description or on
+// the command line ( shadows = N ).  The caches of shadow k are chosen as
+// the core's are, under shadow.k.data and shadow.k.instruction, over a
+// main memory of their own with the same latency.  The same accesses
+// are written to a trace if there is one ( trace.file = name, and
+// trace.mmap = 1 to write it through a mapping ), see trace.h.
+ShadowSet * pickShadows ( int latency )
+{
+	int count = config.Value ( "", "shadows", 0, MAX_INT, 0 );
+	char traceFile[CONFIG_VALUE_SIZE];
+	config.Value ( "trace", "file", traceFile, CONFIG_VALUE_SIZE, "" );
+	int traceMmap = config.Value ( "trace", "mmap", 0, 1, 0 );
+	if ( count == 0 && traceFile[0] == '\0' ) return NULL;
+	
+	ShadowSet * set = new ShadowSet ( );
+	if ( traceFile[0] != '\0' )
+	{
+		TraceWriter * trace = new TraceWriter ( );
+		if ( trace -> Open ( traceFile, traceMmap == 1 ) == true )
+			set -> SetTrace ( trace );
+		else
+			delete trace;
+	}
+	for ( int s = 1; s <= count; s++ )
+	{
+		char name[CONFIG_KEY_SIZE], dataKey[CONFIG_KEY_SIZE], instrKey[CONFIG_KEY_SIZE];
+		snprintf ( name, CONFIG_KEY_SIZE, "shadow.%d", s );
+		snprintf ( dataKey, CONFIG_KEY_SIZE, "%s.data", name );
+		snprintf ( instrKey, CONFIG_KEY_SIZE, "%s.instruction", name );
+		
+		MainMemory * m = new MainMemory ( 0 );
+		m -> SetLatency ( latency );
+		cout << "\nChoose the type of cache you want for " << green << "Data" 
+			<< reset << " in shadow hierarchy " << s << flush;
+		Cache * sdc = pickCache ( m, false, "DATA", 1, dataKey );
+		cout << "\nChoose the type of cache you want for " << green << "Instructions" 
+			<< reset << " in shadow hierarchy " << s << flush;
+		Cache * sic = pickCache ( m, false, "INSTRUCTION", 1, instrKey );
+		set -> Add ( new ShadowHierarchy ( name, m, sdc, sic ) );
+	}
+	return set;
+}
+
+void pickTiming ( int & hitLatency, FillPolicy & fill, int & mshrs, const char * key )
+{
+	cout << "\nEnter the hit latency in cycles : ";
+	hitLatency = config.Int ( key, "latency", 1, MAX_INT );
+	cout << "\nOn a miss, continue : "
+		<< "\n 1. after the whole block is in"
+		<< "\n 2. as soon as the requested word is in ( early restart )"
+		<< "\n 3. ... fetching the requested word first ( critical word first )"
+		<< "\nEnter your choice : ";
+	static const char * fills[] = { "whole-block", "early-restart", "critical-word-first" };
+	int choice = config.Choice ( key, "fill", fills, 3 );
+	fill = ( choice == 1 ) ? FILL_WHOLE_BLOCK :
+		( choice == 2 ) ? FILL_EARLY_RESTART : FILL_CRITICAL_WORD_FIRST;
+	cout << "\nEnter the number of MSHRs ( 0 for a blocking cache ) : ";
+	mshrs = config.Int ( key, "mshrs", 0, MAX_INT );
+}
+
+void pickReplacement ( ReplacementPolicy & policy, unsigned int & seed, bool & compare,
+	const char * key )
+{
+	const char * names[NO_OF_REPL_POLICIES];
+	cout << "\nChoose the replacement policy : ";
+	for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+	{
+		names[p] = Replacement::Name ( static_cast<ReplacementPolicy>(p) );
+		cout << "\n " << p + 1 << ". " << names[p];
+	}
+	cout << "\nEnter your choice : ";
+	int choice = config.Choice ( key, "replacement", names, NO_OF_REPL_POLICIES );
+	policy = static_cast<ReplacementPolicy>( choice - 1 );
+	
+	seed = 1;
+	if ( policy == REPL_RANDOM || policy == REPL_BRRIP )
+	{
+		cout << "\nEnter the random seed : ";
+		seed = config.Int ( key, "seed", 0, MAX_INT );
+	}
+	
+	cout << "\nAlso count the hits every policy would get : "
+		<< "\n 1. yes"
+		<< "\n 2. no"
+		<< "\nEnter your choice : ";
+	choice = config.Choice ( key, "compare", yesNo, 2 );
+	compare = ( choice == 1 );
+}
+
+void pickWritePolicy ( bool & through, bool & allocate, int & bufferEntries, 
+	const char * key )
+{
+	cout << "\nChoose the write policy : "
+		<< "\n 1. write-back"
+		<< "\n 2. write-through"
+		<< "\nEnter your choice : ";
+	static const char * writes[] = { "write-back", "write-through" };
+	int choice = config.Choice ( key, "write", writes, 2 );
+	through = ( choice == 2 );
+	
+	cout << "\nOn a write miss : "
+		<< "\n 1. write-allocate"
+		<< "\n 2. no-write-allocate"
+		<< "\nEnter your choice : ";
+	static const char * misses[] = { "write-allocate", "no-write-allocate" };
+	choice = config.Choice ( key, "write_miss", misses, 2 );
+	allocate = ( choice == 1 );
+	
+	cout << "\nEnter the number of write buffer entries ( 0 for none ) : ";
+	bufferEntries = config.Int ( key, "write_buffer", 0, MAX_INT );
+}
+
+void pickPrefetcher ( PrefetchKind & kind, int & degree, const char * key )
+{
+	const char * names[NO_OF_PREFETCH_KINDS];
+	cout << "\nChoose the prefetcher : ";
+	for ( int k = 0; k < NO_OF_PREFETCH_KINDS; k++ )
+	{
+		names[k] = Prefetcher::Name ( static_cast<PrefetchKind>(k) );
+		cout << "\n " << k + 1 << ". " << names[k];
+	}
+	cout << "\nEnter your choice : ";
+	int choice = config.Choice ( key, "prefetcher", names, NO_OF_PREFETCH_KINDS );
+	kind = static_cast<PrefetchKind>( choice - 1 );
+	
+	degree = 0;
+	if ( kind == PREFETCH_NONE ) return;
+	cout << "\nEnter the prefetch degree ( " 
+		<< ( kind == PREFETCH_STREAM ? "blocks in the stream buffer" : "blocks ahead" )
+		<< " ) : ";
+	degree = config.Int ( key, "degree", 1, MAX_INT );
+}
@@ -30,23 +30,163 @@ using std::flush;
 using std::ifstream;
 # include <cstring>
 using std::strcpy;
+using std::memcpy;
 # include <cstdlib>
 
+# include <sys/mman.h>	// the guest memory is reserved with mmap
+# include <unistd.h>
+
 # include "../include/color.h"
 
 # include <semaphore.h>
 extern sem_t * cout_mutex;	// Defined in main.cpp
 
-MainMemory :: MainMemory ( int sz )
+/********************************************************************
+ * Timing, common to all levels
+ ********************************************************************/
+
+Cache :: Cache ( )
+{
+	hitLatency = 1;
+	lastLatency = lastOccupancy = 1;
+	busyUntil = -1;
+	clock = 0;
+	accessPC = 0;
+	requester = -1;
+	timedAccesses = totalLatency = 0;
+}
+
+void Cache :: SetLatency ( int cycles )
+{
+	hitLatency = ( cycles > 0 ) ? cycles : 1;
+}
+
+void Cache :: SetClock ( int now )
+{
+	clock = now;
+}
+
+void Cache :: SetPC ( word_32 pc )
+{
+	accessPC = pc;
+}
+
+void Cache :: SetRequester ( int r )
+{
+	requester = r;
+}
+
+const char * Cache :: RequesterName ( int r )
+{
+	switch ( r )
+	{
+	case REQUESTER_DATA: return "DATA";
+	case REQUESTER_INSTRUCTION: return "INSTRUCTION";
+	default: return "?";
+	};
+}
+
+int Cache :: LastLatency ( )
+{
+	return lastLatency;
+}
+
+int Cache :: LastOccupancy ( )
+{
+	return lastOccupancy;
+}
+
+void Cache :: AccountAccess ( )
+{
+	timedAccesses ++;
+	totalLatency += lastLatency;
+}
+
+double Cache :: AverageAccessTime ( )
+{
+	if ( timedAccesses == 0 ) return 0;
+	return static_cast<double>(totalLatency) / timedAccesses;
+}
+
+bool Cache :: Busy ( int now )
+{
+	return now <= busyUntil;
+}
+
+// An access that takes one cycle is ready, and the level free again, in
+// the cycle it was made.
+int Cache :: TimedRead ( word_32 address, word_32 & result, int noOfBytes, int now )
+{
+	if ( Busy ( now ) ) return -1;
+	clock = now;
+	if ( Read ( address, result, noOfBytes ) == false ) return -1;
+	busyUntil = now + lastOccupancy - 1;
+	return now + lastLatency - 1;
+}
+
+int Cache :: TimedWrite ( word_32 address, word_32 value, int noOfBytes, int now )
+{
+	if ( Busy ( now ) ) return -1;
+	clock = now;
+	if ( Write ( address, value, noOfBytes ) == false ) return -1;
+	busyUntil = now + lastOccupancy - 1;
+	return now + lastLatency - 1;
+}
+
+bool Cache :: Aligned ( word_32 address, int noOfBytes )
+{
+	return ( noOfBytes == 1 || noOfBytes == 2 || noOfBytes == 4 ) &&
+		static_cast<u_word_32>( address ) % noOfBytes == 0;
+}
+
+word_32 Cache :: Extract ( word_32 word, word_32 address, int noOfBytes )
 {
-	size = sz;
-	memory = new char [ size ];
-	if (memory == NULL)
+	unsigned char * bytes = reinterpret_cast<unsigned char *>( &word ) +
+		static_cast<u_word_32>( address ) % 4;
+	switch ( noOfBytes )
 	{
-		cout << red << "\nError: could not allocate memory...\n" 
+	case 1:
+		return *bytes;
+	case 2:
+		return *( reinterpret_cast<unsigned short *> (bytes) );
+	default:
+		return word;
+	};
+}
+
+word_32 Cache :: Merge ( word_32 word, word_32 address, word_32 value, int noOfBytes )
+{
+	unsigned char * bytes = reinterpret_cast<unsigned char *>( &word ) +
+		static_cast<u_word_32>( address ) % 4;
+	switch ( noOfBytes )
+	{
+	case 1:
+		*bytes = static_cast<unsigned char>( value );
+		return word;
+	case 2:
+		*( reinterpret_cast<unsigned short *> (bytes) ) = static_cast<unsigned short>( value );
+		return word;
+	default:
+		return value;
+	};
+}
+
+/********************************************************************/
+
+MainMemory :: MainMemory ( word_64 sz )
+{
+	size = ( sz <= 0 || sz > MAX_MEMORY_SIZE ) ? MAX_MEMORY_SIZE : sz;
+	void * reserved = mmap ( NULL, size, PROT_READ | PROT_WRITE, 
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if ( reserved == MAP_FAILED )
+	{
+		cout << red << "\nError: could not reserve " << size << " bytes of memory...\n" 
 			<< reset << flush;
 		std::exit ( 10 );
 	}
+	memory = static_cast<char *>( reserved );
+	bytesRead = bytesWritten = 0;
+	lineTransfers = 0;
 }
 
 MainMemory :: ~MainMemory ()
@@ -54,11 +194,20 @@ MainMemory :: ~MainMemory ()
 	AtExit ( );
 }
 
+bool MainMemory :: InRange ( word_32 address, int noOfBytes )
+{
+	return static_cast<u_word_32>( address ) + static_cast<word_64>( noOfBytes ) <= size;
+}
+
+// Word and half word accesses are single ( aligned ) host loads and stores,
+// so the guest's byte order is the host's.
 bool MainMemory :: Read ( word_32 address, word_32 & result, int noOfBytes )
 {
-	word_32 retVal = 0;
-	char * ref = reinterpret_cast<char *> (&retVal);
-	if ( address >= size || address < 0 )
+	lastLatency = lastOccupancy = hitLatency;
+	AccountAccess ( );
+	bytesRead += noOfBytes;
+	
+	if ( InRange ( address, noOfBytes ) == false )
 	{
 		sem_wait ( cout_mutex );
 		cout << red << "\n[ Memory::Read ] Error, Address out of bounds" 
@@ -67,10 +216,11 @@ bool MainMemory :: Read ( word_32 address, word_32 & result, int noOfBytes )
 		return false;
 	}
 	
+	char * ref = memory + static_cast<u_word_32>( address );
 	switch ( noOfBytes )
 	{
 	case 1:
-		ref[0] = memory[address];
+		result = *( reinterpret_cast<unsigned char *> (ref) );
 		break;
 	case 2:
 		if (address % 2 != 0 )
@@ -81,8 +231,7 @@ bool MainMemory :: Read ( word_32 address, word_32 & result, int noOfBytes )
 			sem_post ( cout_mutex );
 			return false;
 		}
-		ref[0] = memory[address];
-		ref[1] = memory[address+1];
+		result = *( reinterpret_cast<unsigned short *> (ref) );
 		break;
 	case 4:
 		if (address % 4 != 0 )
@@ -93,10 +242,7 @@ bool MainMemory :: Read ( word_32 address, word_32 & result, int noOfBytes )
 			sem_post ( cout_mutex );
 			return false;
 		}
-		ref[0] = memory[address];
-		ref[1] = memory[address+1];
-		ref[2] = memory[address+2];
-		ref[3] = memory[address+3];
+		result = *( reinterpret_cast<word_32 *> (ref) );
 		break;
 	default:
 		sem_wait ( cout_mutex );
@@ -106,14 +252,16 @@ bool MainMemory :: Read ( word_32 address, word_32 & result, int noOfBytes )
 		return false;
 		break;
 	};
-	result = retVal;
 	return true;
 }
 
 bool MainMemory :: Write ( word_32 address, word_32 value, int noOfBytes )
 {
-	char * ref = reinterpret_cast<char *> (&value);
-	if ( address >= size || address < 0 )
+	lastLatency = lastOccupancy = hitLatency;
+	AccountAccess ( );
+	bytesWritten += noOfBytes;
+	
+	if ( InRange ( address, noOfBytes ) == false )
 	{
 		sem_wait ( cout_mutex );
 		cout << red << "\n[ Memory::Write ] Error, Address out of bounds" 
@@ -122,10 +270,11 @@ bool MainMemory :: Write ( word_32 address, word_32 value, int noOfBytes )
 		return false;
 	}
 	
+	char * ref = memory + static_cast<u_word_32>( address );
 	switch ( noOfBytes )
 	{
 	case 1:
-		memory[address] = ref[0];
+		*ref = static_cast<char>( value );
 		break;
 	case 2:
 		if (address % 2 != 0 )
@@ -136,8 +285,7 @@ bool MainMemory :: Write ( word_32 address, word_32 value, int noOfBytes )
 			sem_post ( cout_mutex );
 			return false;
 		}
-		memory[address] = ref[0];
-		memory[address+1] = ref[1];
+		*( reinterpret_cast<unsigned short *> (ref) ) = static_cast<unsigned short>( value );
 		break;
 	case 4:
 		if (address % 4 != 0 )
@@ -148,10 +296,7 @@ bool MainMemory :: Write ( word_32 address, word_32 value, int noOfBytes )
 			sem_post ( cout_mutex );
 			return false;
 		}
-		memory[address] = ref[0];
-		memory[address+1] = ref[1];
-		memory[address+2] = ref[2];
-		memory[address+3] = ref[3];
+		*( reinterpret_cast<word_32 *> (ref) ) = value;
 		break;
 	default:
 		sem_wait ( cout_mutex );
@@ -164,7 +309,51 @@ bool MainMemory :: Write ( word_32 address, word_32 value, int noOfBytes )
 	return true;
 }
 
-bool MainMemory :: Load_MIPS_program ( char * filename )
+bool MainMemory :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	lastLatency = hitLatency;
+	lastOccupancy = hitLatency + noOfWords - 1;
+	AccountAccess ( );
+	lineTransfers ++;
+	bytesRead += 4 * noOfWords;
+	
+	if ( address % 4 != 0 || InRange ( address, 4 * noOfWords ) == false )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Memory::ReadBlock ] Error, Address out of bounds"
+			<< " or misaligned" << reset << flush;
+		sem_post ( cout_mutex );
+		return false;
+	}
+	memcpy ( data, memory + static_cast<u_word_32>( address ), 4 * noOfWords );
+	if ( arrival != NULL )
+		for ( int n = 0; n < noOfWords; n++ )
+			arrival[( first + n ) % noOfWords] = hitLatency + n;
+	return true;
+}
+
+bool MainMemory :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	lastLatency = hitLatency;
+	lastOccupancy = hitLatency + noOfWords - 1;
+	AccountAccess ( );
+	lineTransfers ++;
+	bytesWritten += 4 * noOfWords;
+	
+	if ( address % 4 != 0 || InRange ( address, 4 * noOfWords ) == false )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Memory::WriteBlock ] Error, Address out of bounds"
+			<< " or misaligned" << reset << flush;
+		sem_post ( cout_mutex );
+		return false;
+	}
+	memcpy ( memory + static_cast<u_word_32>( address ), data, 4 * noOfWords );
+	return true;
+}
+
+bool MainMemory :: Load_MIPS_program ( char * filename, u_word_32 * startAddress )
 {
 	ifstream progFile( filename );
 	if ( !progFile ) return false;	// failed to open the file.
@@ -174,33 +363,83 @@ bool MainMemory :: Load_MIPS_program ( char * filename )
 	// This record can be ignored in this function as the
 	// boot time fetch address is fixed...
 	// Note that this function is used only for BOOTLOADING.
+	// Additional hardware threads with their own image do start
+	// there, so it is handed back if asked for.
 	
 	OneRecord rec;
 	int size = sizeof (rec);
 	progFile.read ( reinterpret_cast<char*>(&rec), size);
 	if ( !progFile ) return false;
+	if ( startAddress != NULL )
+		*startAddress = rec.inst.iV;
 	
 	// Reading the first significant record.
 	progFile.read ( reinterpret_cast<char*>(&rec), size);
 	
 	while ( progFile )
 	{
-		*( reinterpret_cast<int*> (memory + rec.address) ) = rec.inst.iV;
+		if ( InRange ( rec.address, 4 ) == false ) return false;
+		memcpy ( memory + rec.address, &rec.inst.iV, 4 );
 		progFile.read ( reinterpret_cast<char*>(&rec), size);
 	}
 	progFile.close();
 	return true;
 }
 
+word_64 MainMemory :: Size ( )
+{
+	return size;
+}
+
+word_64 MainMemory :: Traffic ( )
+{
+	return bytesRead + bytesWritten;
+}
+
+bool MainMemory :: Peek ( word_32 address, word_32 & value )
+{
+	if ( address % 4 != 0 || InRange ( address, 4 ) == false ) return false;
+	value = *( reinterpret_cast<word_32 *> (memory + static_cast<u_word_32>( address )) );
+	return true;
+}
+
+bool MainMemory :: Poke ( word_32 address, word_32 value )
+{
+	if ( address % 4 != 0 || InRange ( address, 4 ) == false ) return false;
+	*( reinterpret_cast<word_32 *> (memory + static_cast<u_word_32>( address )) ) = value;
+	return true;
+}
+
 void MainMemory :: AtExit ( )
 {
 	if ( memory != NULL )
-		delete [] memory;
+		munmap ( memory, size );
+	memory = NULL;
 	size = 0;
 }
 
 void MainMemory :: Statistics ( ) 
 {
+	cout << green << "\n[ MainMemory::Statistics ] Latency : " << hitLatency 
+		<< " cycles, accesses : " << timedAccesses 
+		<< " ( " << lineTransfers << " line transfers )"
+		<< ", bytes read : " << bytesRead << ", bytes written : " << bytesWritten
+		<< "\n\tHost memory in use : " << Resident ( ) / 1024 << " KB of "
+		<< size / 1024 << " KB" << reset << flush;
+}
+
+word_64 MainMemory :: Resident ( )
+{
+	if ( memory == NULL ) return 0;
+	long page = sysconf ( _SC_PAGESIZE );
+	word_64 pages = ( size + page - 1 ) / page;
+	unsigned char * in = new unsigned char [ pages ];
+	word_64 resident = 0;
+	if ( mincore ( memory, size, in ) == 0 )
+		for ( word_64 p = 0; p < pages; p++ )
+			resident += in[p] & 1;
+	delete [] in;
+	return resident * page;
 }
 
 bool MainMemory :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
@@ -211,7 +450,7 @@ bool MainMemory :: Read_nofetch ( word_32 address, word_32 & result, int noOfByt
 /********************************************************************/
 
 
-NoCache :: NoCache ( Cache * memory, char * ty, int lev )
+NoCache :: NoCache ( Cache * memory, const char * ty, int lev )
 {
 	mem = memory;
 	accesses = 0;
@@ -224,14 +463,23 @@ void NoCache :: Statistics ( )
 {
 	cout << green << "\n[ NoCache::Statistics] Statistics for the "
 		<< level << "-level " << type << " cache." << reset
-		<< "\nNo of accesses = " << accesses << flush;
+		<< "\nNo of accesses = " << accesses 
+		<< "\nAverage memory access time : " << AverageAccessTime ( ) 
+		<< " cycles" << flush;
 	mem -> Statistics ( );
 }
 
 bool NoCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
 {
 	accesses ++;
-	return mem -> Read ( address, result, noOfBytes );
+	mem -> SetClock ( clock );
+	mem -> SetPC ( accessPC );
+	mem -> SetRequester ( requester );
+	bool ret = mem -> Read ( address, result, noOfBytes );
+	lastLatency = mem -> LastLatency ( );
+	lastOccupancy = mem -> LastOccupancy ( );
+	AccountAccess ( );
+	return ret;
 }
 
 bool NoCache :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
@@ -242,7 +490,45 @@ bool NoCache :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes
 bool NoCache :: Write ( word_32 address, word_32 value, int noOfBytes )
 {
 	accesses ++;
-	return mem -> Write ( address, value, noOfBytes );
+	mem -> SetClock ( clock );
+	mem -> SetPC ( accessPC );
+	mem -> SetRequester ( requester );
+	bool ret = mem -> Write ( address, value, noOfBytes );
+	lastLatency = mem -> LastLatency ( );
+	lastOccupancy = mem -> LastOccupancy ( );
+	AccountAccess ( );
+	return ret;
+}
+
+bool NoCache :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	accesses ++;
+	mem -> SetClock ( clock );
+	mem -> SetPC ( accessPC );
+	mem -> SetRequester ( requester );
+	bool ret = mem -> ReadBlock ( address, data, noOfWords, first, arrival );
+	lastLatency = mem -> LastLatency ( );
+	lastOccupancy = mem -> LastOccupancy ( );
+	AccountAccess ( );
+	return ret;
+}
+
+bool NoCache :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	accesses ++;
+	mem -> SetClock ( clock );
+	mem -> SetRequester ( requester );
+	bool ret = mem -> WriteBlock ( address, data, noOfWords );
+	lastLatency = mem -> LastLatency ( );
+	lastOccupancy = mem -> LastOccupancy ( );
+	AccountAccess ( );
+	return ret;
+}
+
+void NoCache :: CleanEviction ( word_32 address, word_32 * data, int noOfWords )
+{
+	mem -> CleanEviction ( address, data, noOfWords );
 }
 
 void NoCache :: AtExit ( )
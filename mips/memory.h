@@ -26,19 +26,95 @@
 
 # include "../include/instruction.h"
 
+# include <cstddef>	// NULL
+
 # define TYPEFIELDSIZE 16
 
+# define MAX_MEMORY_SIZE 0x100000000LL	// the 32-bit guest address space
+
+// Who an access to a level shared by the data and instruction sides is
+// made for, see shared_cache.h.
+enum Requester { REQUESTER_DATA, REQUESTER_INSTRUCTION, NO_OF_REQUESTERS };
 
 class Cache
 {
+protected:
+	// Timing, in cycles.  Every Read and Write sets lastLatency ( until the
+	// requested word is available ) and lastOccupancy ( until this level
+	// can start another access ), counting the lower levels.  Reads and
+	// writes are still carried out at once; the processor waits out the
+	// latency through TimedRead / TimedWrite.
+	int hitLatency;		// a hit here, or any access for MainMemory
+	int lastLatency;
+	int lastOccupancy;
+	int busyUntil;		// last cycle occupied by the last access
+	int clock;		// cycle at which the next access reaches this level
+	word_32 accessPC;	// instruction making the next access, for prefetchers
+	int requester;		// a Requester, or -1 above any shared level
+	
+	word_64 timedAccesses;	// for the average memory access time
+	word_64 totalLatency;
+	void AccountAccess ( );	// counts lastLatency in the above
 public:
+	Cache ( );
+	
+	void SetLatency ( int cycles );
+	void SetClock ( int now );	// set by the level above before each access
+	void SetPC ( word_32 pc );	// likewise, by the processor or the level above
+	void SetRequester ( int r );	// likewise, by a CachePort or the level above
+	static const char * RequesterName ( int r );
+	int LastLatency ( );
+	int LastOccupancy ( );
+	double AverageAccessTime ( );
+	
+	// The "busy until" protocol.  These perform the access if this level
+	// is free at cycle 'now', and return the cycle at which the data is
+	// available ( for a write, at which the write is done ).  They return
+	// -1 without doing anything if this level is still busy, or if the
+	// access failed.
+	int TimedRead ( word_32 address, word_32 & result, int noOfBytes, int now );
+	int TimedWrite ( word_32 address, word_32 value, int noOfBytes, int now );
+	bool Busy ( int now );
+	
+	// Byte and half word accesses within a cached word, in the host's
+	// byte order like MainMemory.  Aligned is true for 1, 2 or 4 bytes at
+	// a multiple of their size; Extract gives the bytes the access reads
+	// ( zero extended ), Merge the word after the access writes them.
+	static bool Aligned ( word_32 address, int noOfBytes );
+	static word_32 Extract ( word_32 word, word_32 address, int noOfBytes );
+	static word_32 Merge ( word_32 word, word_32 address, word_32 value, int noOfBytes );
+	
 	virtual void Statistics ( ) = 0;
+	
+	// Demand accesses to this level and its hits, for tables comparing
+	// caches ( see shadow.h ); false if this level does not count them.
+	virtual bool Totals ( word_64 & accesses, word_64 & hits ) { return false; };
 
 	virtual bool Read ( word_32 address, word_32 & result, int noOfBytes ) = 0;
 	virtual bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes ) = 0;
 	
 	virtual bool Write ( word_32 address, word_32 value, int noOfBytes ) = 0;
 	
+	// Whole line transfers, for fills and write backs: noOfWords words
+	// from the word aligned address, counted as one access per line.
+	// ReadBlock fetches them starting with word 'first'; if arrival is
+	// given, arrival[i] is set to the latency of word i.  LastLatency ( )
+	// is then that of the first word fetched, LastOccupancy ( ) that of
+	// the last.
+	virtual bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL ) = 0;
+	virtual bool WriteBlock ( word_32 address, word_32 * data, int noOfWords ) = 0;
+	
+	// The level above dropped an unmodified line; an exclusive level
+	// keeps it, the others ignore it.
+	virtual void CleanEviction ( word_32 address, word_32 * data, int noOfWords ) { };
+	
+	// Held by a caller that makes several accesses as one step; taken
+	// before the coherence bus lock.  Only a level shared between host
+	// threads that is not on a bus has anything to lock.
+	virtual void Lock ( ) { };
+	virtual void Unlock ( ) { };
+	
 	// AtExit is the destructor, so there is really no need for the virtual destructor
 	virtual void AtExit ( ) = 0;
 
@@ -47,13 +123,23 @@ public:
 
 
 
+// The guest memory is reserved, not allocated: the host maps a page in,
+// zeroed, the first time it is written, so that a guest may use as much
+// of the address space as it likes and host memory goes only to what
+// it touches.
 class MainMemory : public Cache
 {
 private:
 	char * memory;
-	int size;
+	word_64 size;
+	word_64 bytesRead;	// traffic, for the statistics
+	word_64 bytesWritten;
+	word_64 lineTransfers;	// ReadBlock and WriteBlock calls
+	
+	bool InRange ( word_32 address, int noOfBytes );
+	word_64 Resident ( );	// bytes of host memory in use
 public:
-	MainMemory ( int sz );
+	MainMemory ( word_64 sz );	// 0 for the whole address space
 	~MainMemory ();
 	
 	// The following two functions are provided just to make 
@@ -65,7 +151,19 @@ public:
 	
 	bool Write ( word_32 address, word_32 value, int noOfBytes );
 	
-	bool Load_MIPS_program ( char * filename );
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	
+	bool Load_MIPS_program ( char * filename, u_word_32 * startAddress = 0 );
+		// If startAddress is given, the program's start record is returned in it.
+	
+	// Word accesses outside of the timing and the statistics, like the
+	// loader's, for tables the simulator sets up ( see mmu.h ).
+	word_64 Size ( );
+	word_64 Traffic ( );	// bytes read and written
+	bool Peek ( word_32 address, word_32 & value );
+	bool Poke ( word_32 address, word_32 value );
 	
 	void AtExit ( );
 };
@@ -85,11 +183,15 @@ private:
 	char type[TYPEFIELDSIZE];
 	int level;
 public:
-	NoCache ( Cache * memory, char * ty, int lev );
+	NoCache ( Cache * memory, const char * ty, int lev );
 	void Statistics ( );
 	bool Read ( word_32 address, word_32 & result, int noOfBytes );
 	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes );
 	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	void CleanEviction ( word_32 address, word_32 * data, int noOfWords );
 	void AtExit ( );
 };
 
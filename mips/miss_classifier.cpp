@@ -0,0 +1,310 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "miss_classifier.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include <iomanip>
+using std::setw;
+
+# define INITIAL_TOUCHED_SIZE 1024
+
+// The home entry of a block in a table of 'size' entries, a power of two:
+// the top bits of the product, as its low bits depend only on the low
+// bits of the block and power of two strides would all share one.
+static u_word_32 Hash ( int block, int size )
+{
+	return ( static_cast<u_word_32>( block ) * 2654435761u ) >> ( 32 - __builtin_ctz ( size ) );
+}
+
+MissClassifier :: MissClassifier ( int sets, int blocks )
+{
+	noOfSets = sets;
+	capacity = blocks;
+	
+	slotBlock = new int [capacity];
+	newer = new int [capacity];
+	older = new int [capacity];
+	head = tail = -1;
+	used = 0;
+	for ( lruHashSize = 2; lruHashSize < capacity * 2; lruHashSize *= 2 );
+	lruHash = new int [lruHashSize];
+	for ( int i = 0; i < lruHashSize; i++ )
+		lruHash[i] = -1;
+	
+	touchedSize = INITIAL_TOUCHED_SIZE;
+	touched = new int [touchedSize];
+	for ( int i = 0; i < touchedSize; i++ )
+		touched[i] = -1;
+	noOfTouched = 0;
+	
+	for ( int k = 0; k < NO_OF_MISS_KINDS; k++ )
+		misses[k] = 0;
+	setAccesses = new word_64 [noOfSets];
+	setMisses = new word_64 [noOfSets];
+	setEvictions = new word_64 [noOfSets];
+	for ( int s = 0; s < noOfSets; s++ )
+		setAccesses[s] = setMisses[s] = setEvictions[s] = 0;
+}
+
+void MissClassifier :: AtExit ( )
+{
+	delete[] slotBlock;
+	delete[] newer;
+	delete[] older;
+	delete[] lruHash;
+	delete[] touched;
+	delete[] setAccesses;
+	delete[] setMisses;
+	delete[] setEvictions;
+}
+
+/*********************************************************************************
+*******************The fully associative cache***********************************/
+
+int MissClassifier :: FindSlot ( int block, int & entry )
+{
+	u_word_32 h = Hash ( block, lruHashSize );
+	while ( lruHash[h] != -1 && slotBlock[lruHash[h]] != block )
+		h = ( h + 1 ) & ( lruHashSize - 1 );
+	entry = static_cast<int>( h );
+	return lruHash[h];
+}
+
+// Entries after the hole move into it unless their home is between the
+// hole and them, so that every probe sequence stays unbroken.
+void MissClassifier :: Unhash ( int entry )
+{
+	int hole = entry;
+	for ( int j = ( entry + 1 ) & ( lruHashSize - 1 ); lruHash[j] != -1;
+			j = ( j + 1 ) & ( lruHashSize - 1 ) )
+	{
+		int home = static_cast<int>( Hash ( slotBlock[lruHash[j]], lruHashSize ) );
+		bool stays = ( hole <= j ) ? ( hole < home && home <= j ) : 
+			( hole < home || home <= j );
+		if ( stays == false )
+		{
+			lruHash[hole] = lruHash[j];
+			hole = j;
+		}
+	}
+	lruHash[hole] = -1;
+}
+
+void MissClassifier :: Unlink ( int slot )
+{
+	if ( newer[slot] != -1 ) older[newer[slot]] = older[slot];
+	else head = older[slot];
+	if ( older[slot] != -1 ) newer[older[slot]] = newer[slot];
+	else tail = newer[slot];
+}
+
+void MissClassifier :: PushFront ( int slot )
+{
+	newer[slot] = -1;
+	older[slot] = head;
+	if ( head != -1 ) newer[head] = slot;
+	head = slot;
+	if ( tail == -1 ) tail = slot;
+}
+
+/*********************************************************************************
+*******************The blocks touched********************************************/
+
+bool MissClassifier :: FirstTouch ( int block )
+{
+	u_word_32 h = Hash ( block, touchedSize );
+	while ( touched[h] != -1 )
+	{
+		if ( touched[h] == block ) return false;
+		h = ( h + 1 ) & ( touchedSize - 1 );
+	}
+	touched[h] = block;
+	if ( ++ noOfTouched * 2 > touchedSize )
+	{
+		int * old = touched;
+		int oldSize = touchedSize;
+		touchedSize *= 2;
+		touched = new int [touchedSize];
+		for ( int i = 0; i < touchedSize; i++ )
+			touched[i] = -1;
+		for ( int i = 0; i < oldSize; i++ )
+			if ( old[i] != -1 )
+			{
+				h = Hash ( old[i], touchedSize );
+				while ( touched[h] != -1 )
+					h = ( h + 1 ) & ( touchedSize - 1 );
+				touched[h] = old[i];
+			}
+		delete[] old;
+	}
+	return true;
+}
+
+/*********************************************************************************
+*******************Classification************************************************/
+
+void MissClassifier :: Access ( int setNo, int block, bool hit, bool allocate )
+{
+	setAccesses[setNo] ++;
+	bool first = FirstTouch ( block );
+	
+	int entry;
+	int slot = FindSlot ( block, entry );
+	bool fullyAssociativeHit = ( slot != -1 );
+	if ( fullyAssociativeHit == true )
+	{
+		Unlink ( slot );
+		PushFront ( slot );
+	}
+	else if ( allocate == true || hit == true )
+	{
+		if ( used < capacity )
+			slot = used ++;
+		else
+		{
+			// Evict the least recently used; its block leaves the hash
+			slot = tail;
+			int victimEntry;
+			FindSlot ( slotBlock[slot], victimEntry );
+			Unhash ( victimEntry );
+			Unlink ( slot );
+			FindSlot ( block, entry );	// the hole may have moved it
+		}
+		slotBlock[slot] = block;
+		lruHash[entry] = slot;
+		PushFront ( slot );
+	}
+	
+	if ( hit == true ) return;
+	setMisses[setNo] ++;
+	if ( first == true )
+		misses[MISS_COMPULSORY] ++;
+	else if ( fullyAssociativeHit == false )
+		misses[MISS_CAPACITY] ++;
+	else
+		misses[MISS_CONFLICT] ++;
+}
+
+void MissClassifier :: Evict ( int setNo )
+{
+	setEvictions[setNo] ++;
+}
+
+const char * MissClassifier :: Name ( MissKind kind )
+{
+	switch ( kind )
+	{
+	case MISS_COMPULSORY: return "compulsory";
+	case MISS_CAPACITY: return "capacity";
+	case MISS_CONFLICT: return "conflict";
+	default: return "?";
+	};
+}
+
+/*********************************************************************************
+*******************Statistics****************************************************/
+
+// One character a cell, from ' ' for no misses to '@' for the most.
+void MissClassifier :: HeatMap ( )
+{
+	static const char shades[] = " .:-=+*#%@";
+	int perCell = ( noOfSets + HEAT_MAP_CELLS - 1 ) / HEAT_MAP_CELLS;
+	int cells = ( noOfSets + perCell - 1 ) / perCell;
+	word_64 most = 0;
+	for ( int c = 0; c < cells; c++ )
+	{
+		word_64 sum = 0;
+		for ( int s = c * perCell; s < noOfSets && s < ( c + 1 ) * perCell; s++ )
+			sum += setMisses[s];
+		if ( sum > most ) most = sum;
+	}
+	
+	cout << "\nMisses per set ( " << perCell << ( perCell == 1 ? " set" : " sets" )
+		<< " a cell, ' ' none to '@' " << most << " ) :";
+	for ( int c = 0; c < cells; c++ )
+	{
+		if ( c % HEAT_MAP_WIDTH == 0 )
+			cout << "\n" << setw ( 8 ) << c * perCell << " |";
+		word_64 sum = 0;
+		for ( int s = c * perCell; s < noOfSets && s < ( c + 1 ) * perCell; s++ )
+			sum += setMisses[s];
+		cout << shades[( most != 0 ) ? ( sum * 9 + most - 1 ) / most : 0];
+		if ( c % HEAT_MAP_WIDTH == HEAT_MAP_WIDTH - 1 || c == cells - 1 )
+			cout << "|";
+	}
+}
+
+void MissClassifier :: HotSets ( )
+{
+	int hot[HOT_SETS];
+	int noOfHot = 0;
+	for ( int s = 0; s < noOfSets; s++ )
+	{
+		if ( setMisses[s] == 0 ) continue;
+		int i = ( noOfHot < HOT_SETS ) ? noOfHot ++ : HOT_SETS;
+		while ( i > 0 && setMisses[hot[i - 1]] < setMisses[s] )
+		{
+			if ( i < HOT_SETS ) hot[i] = hot[i - 1];
+			i --;
+		}
+		if ( i < HOT_SETS ) hot[i] = s;
+	}
+	if ( noOfHot == 0 ) return;
+	cout << "\nSets with the most misses :";
+	for ( int i = 0; i < noOfHot; i++ )
+		cout << "\n  set " << hot[i] << " : " << setAccesses[hot[i]] << " accesses, "
+			<< setMisses[hot[i]] << " misses, " << setEvictions[hot[i]] << " evictions";
+}
+
+void MissClassifier :: Statistics ( )
+{
+	word_64 total = 0;
+	for ( int k = 0; k < NO_OF_MISS_KINDS; k++ )
+		total += misses[k];
+	cout << "\n\nMisses by cause ( against a fully associative LRU cache of "
+		<< capacity << " blocks ) :";
+	for ( int k = 0; k < NO_OF_MISS_KINDS; k++ )
+		cout << "\n  " << Name ( static_cast<MissKind>(k) ) << " : " << misses[k]
+			<< " ( " << (( total != 0 ) ? 
+				100.0 * static_cast<double>(misses[k]) / total : 0) << "% )";
+	if ( noOfSets < 2 ) return;
+	
+	word_64 accesses = 0, evictions = 0, mostAccesses = 0, mostEvictions = 0;
+	for ( int s = 0; s < noOfSets; s++ )
+	{
+		accesses += setAccesses[s];
+		evictions += setEvictions[s];
+		if ( setAccesses[s] > mostAccesses ) mostAccesses = setAccesses[s];
+		if ( setEvictions[s] > mostEvictions ) mostEvictions = setEvictions[s];
+	}
+	cout << "\nPer set, mean and most : " 
+		<< static_cast<double>(accesses) / noOfSets << " and " << mostAccesses << " accesses, "
+		<< static_cast<double>(evictions) / noOfSets << " and " << mostEvictions << " evictions";
+	HeatMap ( );
+	HotSets ( );
+	cout << flush;
+}
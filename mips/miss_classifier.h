@@ -0,0 +1,90 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __MISS_CLASSIFIER_H
+# define __MISS_CLASSIFIER_H
+
+# include "../include/instruction.h"
+
+# define HEAT_MAP_WIDTH 64	// cells a row
+# define HEAT_MAP_CELLS 1024	// beyond this, neighbouring sets share a cell
+# define HOT_SETS 8		// listed by their misses
+
+// The three Cs ( Hill ): a miss on a block never touched before is
+// compulsory; otherwise it is a capacity miss if a fully associative
+// LRU cache of the same size would miss too, and a conflict miss if
+// that cache would have hit.
+enum MissKind { MISS_COMPULSORY, MISS_CAPACITY, MISS_CONFLICT, NO_OF_MISS_KINDS };
+
+// Tells the misses of a cache apart by their cause, and keeps the
+// accesses, misses and evictions of each of its sets.  The fully
+// associative cache is a list in LRU order with a hash over its blocks;
+// the blocks touched are kept in a hash set of their own, which grows.
+class MissClassifier
+{
+private:
+	int noOfSets;
+	int capacity;		// blocks
+	
+	// Fully associative LRU
+	int * slotBlock;	// -1 for a free slot
+	int * newer;		// the list, most recent at head, -1 at the ends
+	int * older;
+	int head, tail;
+	int used;
+	int * lruHash;		// slots, -1 for an empty entry; linear probing
+	int lruHashSize;	// a power of two
+	int FindSlot ( int block, int & entry );	// the slot, or -1 and
+						// the empty entry for it
+	void Unhash ( int entry );	// shifts the probe sequence back over it
+	void Unlink ( int slot );
+	void PushFront ( int slot );
+	
+	// Blocks touched
+	int * touched;		// open addressing, -1 for an empty entry
+	int touchedSize;	// a power of two
+	int noOfTouched;
+	bool FirstTouch ( int block );	// adds it if it is new
+	
+	word_64 misses[NO_OF_MISS_KINDS];
+	word_64 * setAccesses;
+	word_64 * setMisses;
+	word_64 * setEvictions;
+	
+	void HeatMap ( );
+	void HotSets ( );
+public:
+	MissClassifier ( int sets, int blocks );
+	void AtExit ( );
+	
+	// Every demand access, once the cache knows whether it hit.  A miss
+	// that does not allocate ( a write miss under no-write-allocate )
+	// does not go into the fully associative cache either.
+	void Access ( int setNo, int block, bool hit, bool allocate );
+	void Evict ( int setNo );
+	
+	static const char * Name ( MissKind kind );
+	void Statistics ( );
+};
+
+# endif
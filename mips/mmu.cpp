@@ -0,0 +1,432 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "mmu.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+/********************************************************************
+ * PageTable
+ ********************************************************************/
+
+PageTable :: PageTable ( MainMemory * m, int pageSize )
+{
+	mem = m;
+	pageBits = 0;
+	while ( ( 1 << pageBits ) < pageSize || ( 1 << pageBits ) < MIN_PAGE_SIZE )
+		pageBits ++;
+	while ( ( 1 << pageBits ) > MAX_PAGE_SIZE )
+		pageBits --;
+	if ( ( 1 << pageBits ) != pageSize )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ PageTable ] Pages are " << ( 1 << pageBits ) 
+			<< " bytes, a power of two from " << MIN_PAGE_SIZE << " to "
+			<< MAX_PAGE_SIZE << reset << flush;
+		sem_post ( cout_mutex );
+	}
+	leafBits = pageBits - 2;	// 4 byte entries
+	
+	// Only whole pages are mapped, the tables being in the last ones
+	u_word_32 pages = static_cast<u_word_32>( mem -> Size ( ) >> pageBits );
+	noOfRootEntries = ( pages + ( 1 << leafBits ) - 1 ) >> leafBits;
+	int rootPages = ( noOfRootEntries * 4 + PageSize ( ) - 1 ) >> pageBits;
+	base = ( pages - rootPages - noOfRootEntries ) << pageBits;
+	root = base;
+	
+	for ( int r = 0; r < noOfRootEntries; r++ )
+	{
+		word_32 leaf = base + ( rootPages + r ) * PageSize ( );
+		mem -> Poke ( root + r * 4, leaf | PTE_VALID );
+		for ( u_word_32 l = 0; l < ( 1U << leafBits ); l++ )
+		{
+			u_word_32 pg = ( static_cast<u_word_32>(r) << leafBits ) + l;
+			mem -> Poke ( leaf + l * 4, 
+				( pg < pages ) ? ( ( pg << pageBits ) | PTE_VALID ) : 0 );
+		}
+	}
+}
+
+int PageTable :: PageBits ( )
+{
+	return pageBits;
+}
+
+int PageTable :: PageSize ( )
+{
+	return 1 << pageBits;
+}
+
+word_32 PageTable :: Base ( )
+{
+	return base;
+}
+
+bool PageTable :: RootEntry ( u_word_32 page, word_32 & address )
+{
+	u_word_32 index = page >> leafBits;
+	if ( index >= static_cast<u_word_32>( noOfRootEntries ) ) return false;
+	address = root + index * 4;
+	return true;
+}
+
+word_32 PageTable :: LeafEntry ( word_32 rootEntry, u_word_32 page )
+{
+	return ( rootEntry & ~PTE_VALID ) + ( page & ( ( 1U << leafBits ) - 1 ) ) * 4;
+}
+
+bool PageTable :: Probe ( word_32 virtualAddress, word_32 & physicalAddress )
+{
+	u_word_32 page = static_cast<u_word_32>( virtualAddress ) >> pageBits;
+	word_32 entry, address;
+	if ( RootEntry ( page, address ) == false ) return false;
+	if ( mem -> Peek ( address, entry ) == false || ( entry & PTE_VALID ) == 0 )
+		return false;
+	if ( mem -> Peek ( LeafEntry ( entry, page ), entry ) == false || 
+			( entry & PTE_VALID ) == 0 )
+		return false;
+	physicalAddress = ( entry & ~( PageSize ( ) - 1 ) ) | 
+		( virtualAddress & ( PageSize ( ) - 1 ) );
+	return true;
+}
+
+/********************************************************************
+ * Tlb
+ ********************************************************************/
+
+Tlb :: Tlb ( int entries, int assoc )
+{
+	associativity = ( assoc < 1 ) ? 1 : assoc;
+	noOfSets = entries / associativity;
+	if ( noOfSets < 1 ) noOfSets = 1;
+	
+	page = new u_word_32 [ Entries ( ) ];
+	frame = new u_word_32 [ Entries ( ) ];
+	valid = new bool [ Entries ( ) ];
+	lastUse = new word_64 [ Entries ( ) ];
+	for ( int e = 0; e < Entries ( ); e++ )
+	{
+		valid[e] = false;
+		lastUse[e] = 0;
+	}
+	useClock = 0;
+}
+
+int Tlb :: Entries ( )
+{
+	return noOfSets * associativity;
+}
+
+int Tlb :: Associativity ( )
+{
+	return associativity;
+}
+
+bool Tlb :: Lookup ( u_word_32 pg, u_word_32 & frm )
+{
+	int first = ( pg % noOfSets ) * associativity;
+	for ( int e = first; e < first + associativity; e++ )
+		if ( valid[e] == true && page[e] == pg )
+		{
+			lastUse[e] = ++ useClock;
+			frm = frame[e];
+			return true;
+		}
+	return false;
+}
+
+void Tlb :: Insert ( u_word_32 pg, u_word_32 frm )
+{
+	int first = ( pg % noOfSets ) * associativity;
+	int victim = first;
+	for ( int e = first; e < first + associativity; e++ )
+	{
+		if ( valid[e] == false )
+		{
+			victim = e;
+			break;
+		}
+		if ( lastUse[e] < lastUse[victim] ) victim = e;
+	}
+	page[victim] = pg;
+	frame[victim] = frm;
+	valid[victim] = true;
+	lastUse[victim] = ++ useClock;
+}
+
+void Tlb :: AtExit ( )
+{
+	delete[] page;
+	delete[] frame;
+	delete[] valid;
+	delete[] lastUse;
+}
+
+/********************************************************************
+ * MmuPort
+ ********************************************************************/
+
+MmuPort :: MmuPort ( Mmu * m, Cache * c, int r )
+{
+	mmu = m;
+	cache = c;
+	requester = r;
+}
+
+void MmuPort :: Statistics ( )
+{
+	mmu -> Statistics ( requester );
+	cache -> Statistics ( );
+}
+
+bool MmuPort :: Totals ( word_64 & accesses, word_64 & hits )
+{
+	return cache -> Totals ( accesses, hits );
+}
+
+// The data side holds the lock over its cache access too, as the
+// instruction side's walks go through the same cache.
+bool MmuPort :: Read ( word_32 address, word_32 & result, int noOfBytes )
+{
+	word_32 physical;
+	int walk;
+	mmu -> Lock ( );
+	if ( mmu -> Translate ( requester, address, physical, clock, walk ) == false )
+	{
+		mmu -> Unlock ( );
+		return false;
+	}
+	if ( requester != REQUESTER_DATA ) mmu -> Unlock ( );
+	
+	cache -> SetClock ( clock + walk );
+	cache -> SetPC ( accessPC );
+	bool ret = cache -> Read ( physical, result, noOfBytes );
+	lastLatency = walk + cache -> LastLatency ( );
+	lastOccupancy = walk + cache -> LastOccupancy ( );
+	if ( requester == REQUESTER_DATA ) mmu -> Unlock ( );
+	AccountAccess ( );
+	return ret;
+}
+
+bool MmuPort :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+{
+	word_32 physical;
+	if ( mmu -> Probe ( address, physical ) == false ) return false;
+	return cache -> Read_nofetch ( physical, result, noOfBytes );
+}
+
+bool MmuPort :: Write ( word_32 address, word_32 value, int noOfBytes )
+{
+	word_32 physical;
+	int walk;
+	mmu -> Lock ( );
+	if ( mmu -> Translate ( requester, address, physical, clock, walk ) == false )
+	{
+		mmu -> Unlock ( );
+		return false;
+	}
+	if ( requester != REQUESTER_DATA ) mmu -> Unlock ( );
+	
+	cache -> SetClock ( clock + walk );
+	cache -> SetPC ( accessPC );
+	bool ret = cache -> Write ( physical, value, noOfBytes );
+	lastLatency = walk + cache -> LastLatency ( );
+	lastOccupancy = walk + cache -> LastOccupancy ( );
+	if ( requester == REQUESTER_DATA ) mmu -> Unlock ( );
+	AccountAccess ( );
+	return ret;
+}
+
+// Nothing above a port moves lines, but the interface has them; a line
+// never crosses a page, so the first word's translation does for all.
+bool MmuPort :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	word_32 physical;
+	if ( mmu -> Probe ( address, physical ) == false ) return false;
+	cache -> SetClock ( clock );
+	bool ret = cache -> ReadBlock ( physical, data, noOfWords, first, arrival );
+	lastLatency = cache -> LastLatency ( );
+	lastOccupancy = cache -> LastOccupancy ( );
+	return ret;
+}
+
+bool MmuPort :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	word_32 physical;
+	if ( mmu -> Probe ( address, physical ) == false ) return false;
+	cache -> SetClock ( clock );
+	bool ret = cache -> WriteBlock ( physical, data, noOfWords );
+	lastLatency = cache -> LastLatency ( );
+	lastOccupancy = cache -> LastOccupancy ( );
+	return ret;
+}
+
+void MmuPort :: CleanEviction ( word_32 address, word_32 * data, int noOfWords )
+{
+	word_32 physical;
+	if ( mmu -> Probe ( address, physical ) == true )
+		cache -> CleanEviction ( physical, data, noOfWords );
+}
+
+void MmuPort :: Lock ( )
+{
+	mmu -> Lock ( );
+}
+
+void MmuPort :: Unlock ( )
+{
+	mmu -> Unlock ( );
+}
+
+void MmuPort :: AtExit ( )
+{
+	cache -> AtExit ( );
+	mmu -> AtExit ( );
+}
+
+/********************************************************************
+ * Mmu
+ ********************************************************************/
+
+Mmu :: Mmu ( PageTable * pt, Cache * dc, Cache * ic, int dtlbEntries, int dtlbAssoc,
+	int itlbEntries, int itlbAssoc )
+{
+	table = pt;
+	walkCache = dc;
+	tlb[REQUESTER_DATA] = new Tlb ( dtlbEntries, dtlbAssoc );
+	tlb[REQUESTER_INSTRUCTION] = new Tlb ( itlbEntries, itlbAssoc );
+	port[REQUESTER_DATA] = new MmuPort ( this, dc, REQUESTER_DATA );
+	port[REQUESTER_INSTRUCTION] = new MmuPort ( this, ic, REQUESTER_INSTRUCTION );
+	
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+		lookups[r] = hits[r] = walkCycles[r] = walkReads[r] = faults[r] = 0;
+	released = 0;
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init ( &attr );
+	pthread_mutexattr_settype ( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init ( &mutex, &attr );
+	pthread_mutexattr_destroy ( &attr );
+}
+
+Cache * Mmu :: Port ( int requester )
+{
+	return port[requester];
+}
+
+void Mmu :: Lock ( )
+{
+	pthread_mutex_lock ( &mutex );
+}
+
+void Mmu :: Unlock ( )
+{
+	pthread_mutex_unlock ( &mutex );
+}
+
+// Reads the root entry, then the leaf entry, each through the data cache
+// once the one before it has arrived.  Returns the cycles taken, or -1 
+// if the data cache could not take a read ( it is retried with the 
+// access ) and -2 if the page is not mapped.
+int Mmu :: Walk ( int requester, u_word_32 page, u_word_32 & frame, int now )
+{
+	word_32 address, entry;
+	int cycles = 0;
+	if ( table -> RootEntry ( page, address ) == false ) return -2;
+	
+	for ( int step = 0; step < PAGE_TABLE_LEVELS; step++ )
+	{
+		if ( step > 0 ) address = table -> LeafEntry ( entry, page );
+		walkCache -> SetClock ( now + cycles );
+		if ( walkCache -> Read ( address, entry, 4 ) == false ) return -1;
+		cycles += walkCache -> LastLatency ( );
+		walkReads[requester] ++;
+		if ( ( entry & PTE_VALID ) == 0 ) return -2;
+	}
+	frame = static_cast<u_word_32>( entry ) >> table -> PageBits ( );
+	return cycles;
+}
+
+bool Mmu :: Translate ( int requester, word_32 virtualAddress, 
+	word_32 & physicalAddress, int now, int & cycles )
+{
+	u_word_32 page = static_cast<u_word_32>( virtualAddress ) >> table -> PageBits ( );
+	u_word_32 frame;
+	cycles = 0;
+	if ( tlb[requester] -> Lookup ( page, frame ) == true )
+		hits[requester] ++;
+	else
+	{
+		cycles = Walk ( requester, page, frame, now );
+		if ( cycles == -2 ) faults[requester] ++;
+		if ( cycles < 0 ) return false;
+		tlb[requester] -> Insert ( page, frame );
+		walkCycles[requester] += cycles;
+	}
+	lookups[requester] ++;
+	physicalAddress = ( frame << table -> PageBits ( ) ) | 
+		( virtualAddress & ( table -> PageSize ( ) - 1 ) );
+	return true;
+}
+
+bool Mmu :: Probe ( word_32 virtualAddress, word_32 & physicalAddress )
+{
+	return table -> Probe ( virtualAddress, physicalAddress );
+}
+
+void Mmu :: Statistics ( int requester )
+{
+	Tlb * t = tlb[requester];
+	word_64 walks = lookups[requester] - hits[requester];
+	cout << green << "\n[ Mmu::Statistics ] " << Cache::RequesterName ( requester )
+		<< " TLB : " << t -> Entries ( ) << " entries, " << t -> Associativity ( )
+		<< "-way, " << table -> PageSize ( ) << " byte pages, reach "
+		<< t -> Entries ( ) * table -> PageSize ( ) << " bytes" << reset
+		<< "\nTranslations : " << lookups[requester]
+		<< "\nTLB hits : " << hits[requester]
+		<< "\nTLB hit ratio : " << ( ( lookups[requester] != 0 ) ? 
+			static_cast<double>( hits[requester] ) / lookups[requester] : 0 )
+		<< "\nPage walks : " << walks << " ( " << walkReads[requester]
+		<< " page table entries read through the data cache )"
+		<< "\nWalk cycles : " << walkCycles[requester] << ", average "
+		<< ( ( walks != 0 ) ? static_cast<double>( walkCycles[requester] ) / walks : 0 )
+		<< " per walk";
+	if ( faults[requester] != 0 )
+		cout << red << "\nUnmapped accesses : " << faults[requester] << reset;
+	cout << flush;
+}
+
+void Mmu :: AtExit ( )
+{
+	if ( ++ released < NO_OF_REQUESTERS ) return;
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+		tlb[r] -> AtExit ( );
+	pthread_mutex_destroy ( &mutex );
+}
@@ -0,0 +1,161 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __MMU_H
+# define __MMU_H
+
+# include "memory.h"
+
+# include <pthread.h>
+
+# define MIN_PAGE_SIZE 256
+# define MAX_PAGE_SIZE 65536
+# define MAX_TLB_ENTRIES 4096
+
+# define PTE_VALID 1		// in a root entry and a leaf entry alike
+# define PAGE_TABLE_LEVELS 2
+
+// The page table the simulator sets up for the guest, which runs with
+// no operating system: a two-level radix table at the top of main memory
+// that maps every page of main memory onto itself.  A leaf table fills a
+// page, and a root entry holds the address of a leaf table; a leaf entry
+// holds the frame number above the page offset.  The guest gets the same
+// addresses with or without an MMU, only the timing changes.
+class PageTable
+{
+private:
+	MainMemory * mem;
+	int pageBits;
+	int leafBits;		// index bits of a leaf table
+	word_32 root;		// address of the root table
+	int noOfRootEntries;
+	word_32 base;		// lowest address the tables take
+public:
+	PageTable ( MainMemory * m, int pageSize );	// rounded to a power of two
+	int PageBits ( );
+	int PageSize ( );
+	word_32 Base ( );
+	
+	// Addresses of the page table entries read by a walk for virtual page
+	// 'page': the root entry, then the leaf entry once the root entry is
+	// known.  False if the page lies outside the table.
+	bool RootEntry ( u_word_32 page, word_32 & address );
+	word_32 LeafEntry ( word_32 rootEntry, u_word_32 page );
+	
+	// Translates by reading the tables directly, off the timing; false
+	// for an unmapped page.
+	bool Probe ( word_32 virtualAddress, word_32 & physicalAddress );
+};
+
+// A set associative, LRU translation lookaside buffer.
+class Tlb
+{
+private:
+	int noOfSets, associativity;
+	u_word_32 * page;
+	u_word_32 * frame;
+	bool * valid;
+	word_64 * lastUse;
+	word_64 useClock;
+public:
+	Tlb ( int entries, int assoc );	// entries is rounded down to a multiple of assoc
+	int Entries ( );
+	int Associativity ( );
+	bool Lookup ( u_word_32 pg, u_word_32 & frm );
+	void Insert ( u_word_32 pg, u_word_32 frm );
+	void AtExit ( );
+};
+
+class Mmu;
+
+// What one side of the pipeline accesses in place of its cache: the
+// address is translated, through the TLB or a walk of the page table,
+// and the cache is then accessed with the physical address.  A walk adds
+// its cycles in front of the cache's latency, so the fetch or the MEM
+// stage stalls for it; a TLB hit is taken to overlap the cache access.
+class MmuPort : public Cache
+{
+private:
+	Mmu * mmu;
+	Cache * cache;
+	int requester;
+public:
+	MmuPort ( Mmu * m, Cache * c, int r );
+	
+	void Statistics ( );	// those of the TLB, then those of the cache
+	bool Totals ( word_64 & accesses, word_64 & hits );	// the cache's
+	bool Read ( word_32 address, word_32 & result, int noOfBytes );
+	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes );
+	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	void CleanEviction ( word_32 address, word_32 * data, int noOfWords );
+	void Lock ( );		// the MMU's
+	void Unlock ( );
+	void AtExit ( );	// the cache's AtExit, and the MMU's after both ports'
+};
+
+// An I-TLB and a D-TLB over a PageTable.  Walks read the page table
+// entries through the data cache, on behalf of either side.
+class Mmu
+{
+private:
+	PageTable * table;
+	Cache * walkCache;
+	Tlb * tlb[NO_OF_REQUESTERS];
+	MmuPort * port[NO_OF_REQUESTERS];
+	
+	// The fetch and MEM stage threads both walk through the data cache.
+	// Recursive, as LL, SC and the store buffer hold it across an access;
+	// it is always taken before the bus lock, which a walk's reads take.
+	pthread_mutex_t mutex;
+	
+	word_64 lookups[NO_OF_REQUESTERS];
+	word_64 hits[NO_OF_REQUESTERS];
+	word_64 walkCycles[NO_OF_REQUESTERS];
+	word_64 walkReads[NO_OF_REQUESTERS];	// page table entries read
+	word_64 faults[NO_OF_REQUESTERS];	// walks that found no mapping
+	int released;		// ports through with their AtExit ( )
+	
+	int Walk ( int requester, u_word_32 page, u_word_32 & frame, int now );
+public:
+	Mmu ( PageTable * pt, Cache * dc, Cache * ic, int dtlbEntries, int dtlbAssoc,
+		int itlbEntries, int itlbAssoc );
+	
+	Cache * Port ( int requester );
+	
+	// Translates for an access at clock 'now', with the lock held; cycles
+	// is set to those spent walking.  False if the walk could not be made
+	// or found no mapping.
+	bool Translate ( int requester, word_32 virtualAddress, 
+		word_32 & physicalAddress, int now, int & cycles );
+	bool Probe ( word_32 virtualAddress, word_32 & physicalAddress );
+	void Lock ( );
+	void Unlock ( );
+	
+	void Statistics ( int requester );
+	void AtExit ( );	// once both ports have called it
+};
+
+# endif
@@ -0,0 +1,105 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "multicore.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+MultiCore :: MultiCore ( CoherenceBus * cb, int q )
+{
+	bus = cb;
+	noOfCores = 0;
+	quantum = ( q > 0 ) ? q : 1;
+	
+	pthread_mutex_init ( &barrierMutex, NULL );
+	pthread_cond_init ( &barrierCond, NULL );
+	barrierCount = 0;
+	barrierGeneration = 0;
+}
+
+void MultiCore :: AtExit ( )
+{
+	for ( int i = 1; i < noOfCores; i++ )
+		core[i] -> CloseSemaphores ( );
+	bus -> AtExit ( );
+	pthread_cond_destroy ( &barrierCond );
+	pthread_mutex_destroy ( &barrierMutex );
+}
+
+int MultiCore :: AddCore ( Processor * p )
+{
+	if ( noOfCores == MAX_CORES ) return -1;
+	core[noOfCores] = p;
+	return noOfCores ++;
+}
+
+void* coreThread ( void * pobj )
+{
+	Processor * p = reinterpret_cast<Processor*> (pobj);
+	p -> Execute ( );
+	return NULL;
+}
+
+void MultiCore :: Execute ( )
+{
+	for ( int i = 1; i < noOfCores; i++ )
+		pthread_create ( &hostThread[i], NULL, &::coreThread, core[i] );
+	
+	core[0] -> Execute ( );	// Never returns
+}
+
+void MultiCore :: Barrier ( int clk )
+{
+	if ( clk % quantum != 0 ) return;
+	
+	pthread_mutex_lock ( &barrierMutex );
+	int generation = barrierGeneration;
+	if ( ++ barrierCount == noOfCores )
+	{
+		barrierCount = 0;
+		barrierGeneration ++;
+		pthread_cond_broadcast ( &barrierCond );
+	}
+	else
+		while ( generation == barrierGeneration )
+			pthread_cond_wait ( &barrierCond, &barrierMutex );
+	pthread_mutex_unlock ( &barrierMutex );
+}
+
+void MultiCore :: Statistics ( )
+{
+	// Called from core 0's prompt, the other cores are at the barrier
+	// or about to reach it, so their counters are steady enough.
+	cout << gray << "\n" << noOfCores << " cores, quantum of " 
+		<< quantum << " cycles" << reset << flush;
+	for ( int i = 0; i < noOfCores; i++ )
+	{
+		core[i] -> Statistics ( );
+		core[i] -> CacheStatistics ( );
+	}
+	bus -> Statistics ( );
+}
@@ -0,0 +1,69 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Several in-order cores sharing the MainMemory through private L1
+ * caches kept coherent by a CoherenceBus.  Each core is simulated by
+ * its own set of host threads ( a clock manager and five stages ); the
+ * clock managers meet at a barrier every 'quantum' cycles so that no core
+ * runs far ahead of the others.  Core 0 runs on the calling thread and
+ * owns the 'mips >' prompt.
+ */
+
+# ifndef __MULTICORE_H
+# define __MULTICORE_H
+
+# include "processor.h"
+# include "coherence_bus.h"
+
+# include <pthread.h>
+
+class MultiCore
+{
+private:
+	Processor * core[MAX_CORES];
+	int noOfCores;
+	CoherenceBus * bus;
+	
+	int quantum;
+	pthread_mutex_t barrierMutex;
+	pthread_cond_t barrierCond;
+	int barrierCount;
+	int barrierGeneration;
+	
+	pthread_t hostThread[MAX_CORES];
+	friend void* coreThread ( void * );
+public:
+	MultiCore ( CoherenceBus * cb, int q );
+	void AtExit ( );	// Cleans up all but core 0, which cleans itself
+	
+	// Adds a core, in order; returns its number or -1 if there is no room.
+	int AddCore ( Processor * p );
+	
+	void Execute ( );	// Starts the cores, the calling thread runs core 0
+	void Barrier ( int clk );	// Called by each core after every clock
+	
+	void Statistics ( );
+};
+
+# endif
@@ -0,0 +1,1263 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "ooo_processor.h"
+
+# include <iostream>
+using std::cout;
+using std::cin;
+using std::flush;
+
+# include <iomanip>
+using std::setw;
+
+# include <cstdlib>
+
+# include "../include/color.h"
+
+extern sem_t * cout_mutex;	// Defined in main.cpp
+// The out-of-order model runs on a single thread, but the caches
+// print under cout_mutex, so we keep using it for consistency.
+
+# define PREG_ZERO 0	// Physical register permanently holding $zero
+
+void OOO_RobEntry :: Initialise ( )
+{
+	valid = false;
+	seq = 0;
+	PC = 0;
+	inst.iV = 0;
+	uopClass = OOO_NOP;
+	for ( int i = 0; i < 2; i++ )
+	{
+		srcArch[i] = srcPhys[i] = -1;
+		dstArch[i] = dstPhys[i] = oldPhys[i] = -1;
+		result[i] = 0;
+	}
+	Imm = 0;
+	inIQ = issued = completed = false;
+	completeCycle = 0;
+	predNPC = actualNPC = 0;
+	lsqIndex = -1;
+}
+
+/**********************************************************************************
+**********************Constructor and Destructor functions************************/
+
+OOOProcessor :: OOOProcessor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm,
+	int robsz, int wid, int iqsz, int lsqsz )
+{
+	mem = m;
+	dataCache = dc;
+	scratchpad = NULL;
+	shadows = NULL;
+	lastLoadLatency = 1;
+	instrCache = ic;
+	pman = pm;
+	requestProgramTermination = false;
+	blockUpdate = false;
+	
+	robSize = ( robsz > 0 ) ? robsz : OOO_DEFAULT_ROB_SIZE;
+	width = ( wid > 0 ) ? wid : OOO_DEFAULT_WIDTH;
+	if ( width > OOO_MAX_WIDTH ) width = OOO_MAX_WIDTH;
+	iqSize = ( iqsz > 0 ) ? iqsz : OOO_DEFAULT_IQ_SIZE;
+	lsqSize = ( lsqsz > 0 ) ? lsqsz : OOO_DEFAULT_LSQ_SIZE;
+	
+	// Every ROB entry may hold up to two destinations (MULT / DIV)
+	noOfPhysRegs = OOO_ARCH_REGS + 2 * robSize;
+	physValue = new word_32 [noOfPhysRegs];
+	physReady = new bool [noOfPhysRegs];
+	freeList = new int [noOfPhysRegs];
+	freeCount = 0;
+	for ( int i = 0; i < noOfPhysRegs; i++ )
+	{
+		physValue[i] = 0;
+		physReady[i] = true;
+		if ( i >= OOO_ARCH_REGS )
+			freeList[freeCount++] = i;
+	}
+	for ( int i = 0; i < OOO_ARCH_REGS; i++ )
+		mapTable[i] = retireMap[i] = i;
+	
+	rob = new OOO_RobEntry [robSize];
+	for ( int i = 0; i < robSize; i++ )
+		rob[i].Initialise ( );
+	robHead = robTail = robCount = 0;
+	nextSeq = 0;
+	
+	iq = new int [iqSize];
+	iqTried = new bool [iqSize];
+	for ( int i = 0; i < iqSize; i++ )
+		iq[i] = -1;
+	iqCount = 0;
+	
+	lsq = new OOO_LsqEntry [lsqSize];
+	for ( int i = 0; i < lsqSize; i++ )
+		lsq[i].valid = false;
+	lsqHead = lsqTail = lsqCount = 0;
+	
+	linkValid = false;
+	linkAddress = 0;
+	
+	fetchPC = SYSTEM_START_ADDRESS;
+	fetchBlocked = false;
+	fetchBufferSize = 2 * width;
+	fetchBufferPC = new u_word_32 [fetchBufferSize];
+	fetchBufferInst = new Inst [fetchBufferSize];
+	fetchBufferNPC = new u_word_32 [fetchBufferSize];
+	fetchBufferHead = fetchBufferCount = 0;
+	
+	cycles = 0;
+	retiredInstructions = fetchedInstructions = 0;
+	squashedInstructions = mispredictions = 0;
+	robOccupancySum = 0;
+	robOccupancyMax = 0;
+	for ( int i = 0; i < OOO_STALL_REASONS; i++ )
+		stallCycles[i] = 0;
+	
+	continueCount = 0;
+	for ( int i = 0; i < BREAKPOINTARRAYSIZE; i++ )
+		breakPointArray[i] = -1;
+}
+
+OOOProcessor :: ~OOOProcessor ( )
+{
+	AtExit ( );
+}
+
+void OOOProcessor :: AtExit ( )
+{
+	delete [] physValue;
+	delete [] physReady;
+	delete [] freeList;
+	delete [] rob;
+	delete [] iq;
+	delete [] iqTried;
+	delete [] lsq;
+	delete [] fetchBufferPC;
+	delete [] fetchBufferInst;
+	delete [] fetchBufferNPC;
+	physValue = NULL; physReady = NULL; freeList = NULL;
+	rob = NULL; iq = NULL; iqTried = NULL; lsq = NULL;
+	fetchBufferPC = NULL; fetchBufferInst = NULL; fetchBufferNPC = NULL;
+}
+
+void OOOProcessor :: Terminate ( )
+{
+	requestProgramTermination = true;
+}
+
+void OOOProcessor :: SetScratchpad ( Scratchpad * sp )
+{
+	scratchpad = sp;
+}
+
+void OOOProcessor :: SetShadows ( ShadowSet * s )
+{
+	if ( s != NULL && s -> Active ( ) )
+		shadows = s;
+}
+
+bool OOOProcessor :: ReadMem ( word_32 address, word_32 & result, int noOfBytes, 
+	u_word_32 pc )
+{
+	lastLoadLatency = 1;
+	if ( scratchpad != NULL && scratchpad -> Serves ( address ) )
+		return scratchpad -> Read ( address, result, noOfBytes );
+	if ( scratchpad != NULL )
+		scratchpad -> Bypassed ( );
+	
+	dataCache -> SetClock ( cycles );	// for the MSHRs
+	dataCache -> SetPC ( pc );		// and the prefetcher
+	bool ok = dataCache -> Read ( address, result, noOfBytes );
+	lastLoadLatency = dataCache -> LastLatency ( );
+	if ( ok && shadows != NULL )
+		shadows -> Record ( SHADOW_SOURCE_DATA, SHADOW_LOAD, address, 0, noOfBytes, 
+			pc, static_cast<int>( cycles ) );
+	return ok;
+}
+
+bool OOOProcessor :: WriteMem ( word_32 address, word_32 value, int noOfBytes, 
+	u_word_32 pc )
+{
+	if ( blockUpdate == true ) return true;
+	// Return telling the processor that memory was updated but
+	// actually do not update memory if blockUpdate is true;
+	if ( scratchpad != NULL && scratchpad -> Serves ( address ) )
+		return scratchpad -> Write ( address, value, noOfBytes );
+	if ( scratchpad != NULL )
+		scratchpad -> Bypassed ( );
+	dataCache -> SetClock ( cycles );
+	dataCache -> SetPC ( pc );
+	if ( dataCache -> Write ( address, value, noOfBytes ) == false )
+		return false;
+	if ( shadows != NULL )
+		shadows -> Record ( SHADOW_SOURCE_DATA, SHADOW_STORE, address, value, 
+			noOfBytes, pc, static_cast<int>( cycles ) );
+	return true;
+}
+
+/*********************************************************************************
+*******************Decode and rename helpers*************************************/
+
+// Fills in the class, the architectural sources and destinations and the
+// immediate of a ROB entry, from its instruction.
+// Returns false for instructions that the model does not know.
+bool OOOProcessor :: Decode ( OOO_RobEntry & e )
+{
+	Inst & in = e.inst;
+	e.uopClass = OOO_ALU;
+	
+	if ( in.iV == 0 )
+	{
+		e.uopClass = OOO_NOP;
+		return true;
+	}
+	
+	switch ( in.noF.op )
+	{
+	case OP_ZERO:
+		switch ( in.rF.funct )
+		{
+		case FUNCT_ADD: case FUNCT_AND: case FUNCT_NOR: case FUNCT_OR:
+		case FUNCT_SUB: case FUNCT_XOR: case FUNCT_SLT:
+		case FUNCT_SLLV: case FUNCT_SRAV: case FUNCT_SRLV:
+			e.srcArch[0] = in.rF.rs;
+			e.srcArch[1] = in.rF.rt;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_SLL: case FUNCT_SRA: case FUNCT_SRL:
+			e.Imm = in.rF.shamt;
+			e.srcArch[1] = in.rF.rt;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_DIV: case FUNCT_MULT:
+			e.srcArch[0] = in.rF.rs;
+			e.srcArch[1] = in.rF.rt;
+			e.dstArch[0] = REG_LO;
+			e.dstArch[1] = REG_HI;
+			break;
+		case FUNCT_JR:
+			e.uopClass = OOO_JUMPREG;
+			e.srcArch[0] = in.rF.rs;
+			break;
+		case FUNCT_JALR:
+			e.uopClass = OOO_JUMPREG;
+			e.srcArch[0] = in.rF.rs;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_MFHI:
+			e.srcArch[0] = REG_HI;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_MFLO:
+			e.srcArch[0] = REG_LO;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_MTHI:
+			e.srcArch[0] = in.rF.rs;
+			e.dstArch[0] = REG_HI;
+			break;
+		case FUNCT_MTLO:
+			e.srcArch[0] = in.rF.rs;
+			e.dstArch[0] = REG_LO;
+			break;
+		case FUNCT_SYSCALL:
+			e.uopClass = OOO_JUMP;
+			e.dstArch[0] = 31;
+			break;
+		case FUNCT_RDIN:
+			e.uopClass = OOO_IO;
+			e.srcArch[1] = in.rF.rt;
+			e.dstArch[0] = in.rF.rd;
+			break;
+		case FUNCT_RDOUT:
+			e.uopClass = OOO_IO;
+			e.srcArch[0] = in.rF.rs;
+			e.srcArch[1] = in.rF.rt;
+			break;
+		default:
+			return false;
+		};
+		break;
+		
+	case OP_ONE:	// BGEZ / BLTZ
+		e.uopClass = OOO_BRANCH;
+		e.srcArch[0] = in.iF.rs;
+		e.Imm = in.iF.imm * 4;
+		break;
+		
+	case OP_ADDI: case OP_ANDI: case OP_ORI: case OP_XORI: case OP_SLTI:
+		e.srcArch[0] = in.iF.rs;
+		e.dstArch[0] = in.iF.rt;
+		e.Imm = in.iF.imm;
+		break;
+		
+	case OP_LUI:
+		e.srcArch[1] = in.iF.rt;
+		e.dstArch[0] = in.iF.rt;
+		e.Imm = in.iF.imm << 16;
+		break;
+		
+	case OP_BEQ: case OP_BNE:
+		e.uopClass = OOO_BRANCH;
+		e.srcArch[0] = in.iF.rs;
+		e.srcArch[1] = in.iF.rt;
+		e.Imm = in.iF.imm * 4;
+		break;
+		
+	case OP_BGTZ: case OP_BLEZ:
+		e.uopClass = OOO_BRANCH;
+		e.srcArch[0] = in.iF.rs;
+		e.Imm = in.iF.imm * 4;
+		break;
+		
+	case OP_J:
+		e.uopClass = OOO_JUMP;
+		break;
+		
+	case OP_JAL:
+		e.uopClass = OOO_JUMP;
+		e.dstArch[0] = 31;
+		break;
+		
+	case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU: case OP_LL:
+		e.uopClass = OOO_LOAD;
+		e.srcArch[0] = in.iF.rs;
+		e.dstArch[0] = in.iF.rt;
+		e.Imm = in.iF.imm;
+		break;
+		
+	case OP_SW: case OP_SB: case OP_SH:
+		e.uopClass = OOO_STORE;
+		e.srcArch[0] = in.iF.rs;
+		e.srcArch[1] = in.iF.rt;
+		e.Imm = in.iF.imm;
+		break;
+		
+	case OP_SC:
+		e.uopClass = OOO_STORE;
+		e.srcArch[0] = in.iF.rs;
+		e.srcArch[1] = in.iF.rt;
+		e.dstArch[0] = in.iF.rt;	// 1 if stored, 0 if not
+		e.Imm = in.iF.imm;
+		break;
+		
+	case OP_DIN:
+		e.uopClass = OOO_IO;
+		e.dstArch[0] = in.iF.rt;
+		e.Imm = in.iF.imm;
+		break;
+		
+	case OP_DOUT:
+		e.uopClass = OOO_IO;
+		e.srcArch[0] = in.iF.rs;
+		e.Imm = in.iF.imm;
+		break;
+		
+	default:
+		return false;
+	};
+	
+	// Writes to $zero are discarded, so they need no physical register.
+	for ( int i = 0; i < 2; i++ )
+		if ( e.dstArch[i] == 0 )
+			e.dstArch[i] = -1;
+	return true;
+}
+
+int OOOProcessor :: AllocPhys ( )
+{
+	if ( freeCount == 0 ) return -1;
+	return freeList[--freeCount];
+}
+
+bool OOOProcessor :: SourcesReady ( OOO_RobEntry & e )
+{
+	for ( int i = 0; i < 2; i++ )
+		if ( e.srcPhys[i] != -1 && physReady[e.srcPhys[i]] == false )
+			return false;
+	return true;
+}
+
+word_32 OOOProcessor :: SourceValue ( OOO_RobEntry & e, int i )
+{
+	if ( e.srcPhys[i] == -1 ) return 0;
+	return physValue[e.srcPhys[i]];
+}
+
+/*********************************************************************************
+*******************Pipeline steps************************************************/
+
+void OOOProcessor :: Fetch ( )
+{
+	for ( int n = 0; n < width; n++ )
+	{
+		if ( fetchBlocked == true || fetchBufferCount == fetchBufferSize )
+			return;
+		
+		Inst inst;
+		instrCache -> SetClock ( cycles );
+		instrCache -> SetPC ( fetchPC );
+		if ( instrCache -> Read ( fetchPC, inst.iV, 4 ) == false )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ Fetch ] PC fetch failed, will try again in next clock"
+				<< reset << flush;
+			sem_post ( cout_mutex );
+			return;
+		}
+		if ( shadows != NULL )
+			shadows -> Record ( SHADOW_SOURCE_FETCH, SHADOW_FETCH, fetchPC, 0, 4,
+				fetchPC, static_cast<int>( cycles ) );
+		
+		// Pre-decode just enough to know where to fetch from next
+		u_word_32 npc = fetchPC + 4;
+		bool endGroup = false;
+		if ( inst.iV != 0 )
+		{
+			switch ( inst.noF.op )
+			{
+			case OP_J: case OP_JAL:
+				npc = inst.jF.tAddr * 4;
+				break;
+			case OP_ZERO:
+				if ( inst.rF.funct == FUNCT_SYSCALL )
+					npc = SYSCALL_HANDLER_ADDRESS;
+				else if ( inst.rF.funct == FUNCT_JR || inst.rF.funct == FUNCT_JALR )
+				{
+					fetchBlocked = true;	// Until the target is known
+					endGroup = true;
+				}
+				break;
+			case OP_ONE: case OP_BEQ: case OP_BNE: case OP_BGTZ: case OP_BLEZ:
+				// Backward taken, forward not taken
+				if ( inst.iF.imm < 0 )
+					npc = fetchPC + 4 + inst.iF.imm * 4;
+				break;
+			};
+		}
+		
+		int slot = ( fetchBufferHead + fetchBufferCount ) % fetchBufferSize;
+		fetchBufferPC[slot] = fetchPC;
+		fetchBufferInst[slot] = inst;
+		fetchBufferNPC[slot] = npc;
+		fetchBufferCount ++;
+		fetchedInstructions ++;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Fetch ] PC = " << fetchPC << ", Instruction = " 
+			<< inst.iV << flush;
+		sem_post ( cout_mutex );
+		
+		if ( npc != fetchPC + 4 ) endGroup = true;	// One taken branch per cycle
+		fetchPC = npc;
+		if ( endGroup == true ) return;
+	}
+}
+
+void OOOProcessor :: Dispatch ( )
+{
+	if ( fetchBufferCount == 0 )
+	{
+		stallCycles[ fetchBlocked ? OOO_STALL_INDIRECT : OOO_STALL_FETCH_EMPTY ] ++;
+		return;
+	}
+	
+	for ( int n = 0; n < width && fetchBufferCount > 0; n++ )
+	{
+		OOO_RobEntry e;
+		e.Initialise ( );
+		e.PC = fetchBufferPC[fetchBufferHead];
+		e.inst = fetchBufferInst[fetchBufferHead];
+		e.predNPC = fetchBufferNPC[fetchBufferHead];
+		
+		if ( Decode ( e ) == false )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ Dispatch ] Unknown instruction " << e.inst.iV
+				<< " at PC = " << e.PC << ", treating as NOP" << reset << flush;
+			sem_post ( cout_mutex );
+			e.Initialise ( );
+			e.PC = fetchBufferPC[fetchBufferHead];
+			e.inst.iV = 0;
+			e.predNPC = fetchBufferNPC[fetchBufferHead];
+		}
+		
+		bool needsIQ = ( e.uopClass != OOO_NOP && e.uopClass != OOO_JUMP );
+		bool needsLSQ = ( e.uopClass == OOO_LOAD || e.uopClass == OOO_STORE );
+		int needsPhys = ( e.dstArch[0] != -1 ? 1 : 0 ) + ( e.dstArch[1] != -1 ? 1 : 0 );
+		
+		int reason = -1;
+		if ( robCount == robSize ) reason = OOO_STALL_ROB_FULL;
+		else if ( needsIQ && iqCount == iqSize ) reason = OOO_STALL_IQ_FULL;
+		else if ( needsLSQ && lsqCount == lsqSize ) reason = OOO_STALL_LSQ_FULL;
+		else if ( needsPhys > freeCount ) reason = OOO_STALL_NO_PREG;
+		if ( reason != -1 )
+		{
+			if ( n == 0 ) stallCycles[reason] ++;
+			return;
+		}
+		
+		fetchBufferHead = ( fetchBufferHead + 1 ) % fetchBufferSize;
+		fetchBufferCount --;
+		
+		// Rename
+		for ( int i = 0; i < 2; i++ )
+		{
+			if ( e.srcArch[i] == -1 ) e.srcPhys[i] = -1;
+			else if ( e.srcArch[i] == 0 ) e.srcPhys[i] = PREG_ZERO;
+			else e.srcPhys[i] = mapTable[e.srcArch[i]];
+		}
+		for ( int i = 0; i < 2; i++ )
+		{
+			if ( e.dstArch[i] == -1 ) continue;
+			e.oldPhys[i] = mapTable[e.dstArch[i]];
+			e.dstPhys[i] = AllocPhys ( );
+			physReady[e.dstPhys[i]] = false;
+			mapTable[e.dstArch[i]] = e.dstPhys[i];
+		}
+		
+		e.valid = true;
+		e.seq = nextSeq ++;
+		int index = robTail;
+		
+		if ( needsLSQ )
+		{
+			e.lsqIndex = lsqTail;
+			lsq[lsqTail].valid = true;
+			lsq[lsqTail].isStore = ( e.uopClass == OOO_STORE );
+			lsq[lsqTail].robIndex = index;
+			lsq[lsqTail].addressReady = false;
+			lsq[lsqTail].dataReady = false;
+			lsq[lsqTail].noOfBytes = Processor::AccessSize ( e.inst.noF.op );
+			lsqTail = ( lsqTail + 1 ) % lsqSize;
+			lsqCount ++;
+		}
+		
+		if ( needsIQ )
+		{
+			for ( int i = 0; i < iqSize; i++ )
+				if ( iq[i] == -1 )
+				{
+					iq[i] = index;
+					break;
+				}
+			iqCount ++;
+			e.inIQ = true;
+		}
+		else
+		{
+			// NOPs and direct jumps were fully resolved by fetch
+			if ( e.uopClass == OOO_JUMP && e.dstArch[0] != -1 )
+			{
+				physValue[e.dstPhys[0]] = e.PC + 4;
+				physReady[e.dstPhys[0]] = true;
+			}
+			e.actualNPC = e.predNPC;
+			e.issued = e.completed = true;
+			e.completeCycle = cycles;
+		}
+		
+		rob[index] = e;
+		robTail = ( robTail + 1 ) % robSize;
+		robCount ++;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Dispatch ] PC = " << e.PC << " -> ROB[" << index << "]" << flush;
+		sem_post ( cout_mutex );
+	}
+}
+
+// Performs the operation of a ROB entry whose sources are ready.
+// Returns false if the entry could not execute this cycle.
+bool OOOProcessor :: Execute ( int robIndex )
+{
+	OOO_RobEntry & e = rob[robIndex];
+	word_32 A = SourceValue ( e, 0 );
+	word_32 B = SourceValue ( e, 1 );
+	word_64 HiLoBuffer;
+	int latency = OOO_ALU_LATENCY;
+	
+	e.actualNPC = e.PC + 4;
+	
+	switch ( e.uopClass )
+	{
+	case OOO_LOAD:
+		return ExecuteLoad ( robIndex );
+		
+	case OOO_STORE:
+		if ( e.inst.noF.op == OP_SC )
+		{
+			// The outcome depends on the link, which only a retired LL
+			// sets, so SC is done by the oldest instruction, like I/O.
+			if ( robIndex != robHead ) return false;
+			bool success = linkValid && linkAddress == A + e.Imm;
+			if ( success && WriteMem ( A + e.Imm, B, 4, e.PC ) == false )
+				return false;	// Try again in next clock
+			linkValid = false;
+			e.result[0] = success ? 1 : 0;
+			lsq[e.lsqIndex].noOfBytes = 0;	// Nothing left for Retire
+		}
+		lsq[e.lsqIndex].address = A + e.Imm;
+		lsq[e.lsqIndex].addressReady = true;
+		lsq[e.lsqIndex].data = B;
+		lsq[e.lsqIndex].dataReady = true;
+		latency = OOO_STORE_LATENCY;
+		break;
+		
+	case OOO_IO:
+		// Devices are only touched by the oldest instruction
+		if ( robIndex != robHead ) return false;
+		if ( e.inst.noF.op == OP_DIN )
+			pman -> Read ( e.Imm, e.result[0] );
+		else if ( e.inst.noF.op == OP_DOUT )
+			pman -> Write ( e.Imm, A );
+		else if ( e.inst.rF.funct == FUNCT_RDIN )
+			pman -> Read ( B, e.result[0] );
+		else	// FUNCT_RDOUT
+			pman -> Write ( B, A );
+		break;
+		
+	case OOO_JUMPREG:
+		e.actualNPC = A;
+		e.result[0] = e.PC + 4;		// JALR link
+		break;
+		
+	case OOO_BRANCH:
+		{
+			bool taken = false;
+			switch ( e.inst.noF.op )
+			{
+			case OP_ONE:	taken = ( e.inst.iF.rt == 1 ) ? ( A >= 0 ) : ( A < 0 ); break;
+			case OP_BEQ:	taken = ( A == B ); break;
+			case OP_BNE:	taken = ( A != B ); break;
+			case OP_BGTZ:	taken = ( A > 0 ); break;
+			case OP_BLEZ:	taken = ( A <= 0 ); break;
+			};
+			if ( taken ) e.actualNPC = e.PC + 4 + e.Imm;
+		}
+		break;
+		
+	case OOO_ALU:
+		if ( e.inst.noF.op == OP_ZERO )
+		{
+			switch ( e.inst.rF.funct )
+			{
+			case FUNCT_ADD:  e.result[0] = A + B; break;
+			case FUNCT_AND:  e.result[0] = A & B; break;
+			case FUNCT_NOR:  e.result[0] = ~ ( A | B ); break;
+			case FUNCT_OR:   e.result[0] = A | B; break;
+			case FUNCT_SUB:  e.result[0] = A - B; break;
+			case FUNCT_XOR:  e.result[0] = A ^ B; break;
+			case FUNCT_SLT:  e.result[0] = ( A < B ) ? 1 : 0; break;
+			case FUNCT_SLL:  e.result[0] = B << e.Imm; break;
+			case FUNCT_SLLV: e.result[0] = B << A; break;
+			case FUNCT_SRA:  e.result[0] = B >> e.Imm; break;
+			case FUNCT_SRAV: e.result[0] = B >> A; break;
+			case FUNCT_SRL:
+				e.result[0] = static_cast<u_word_32>(B) >> static_cast<u_word_32>(e.Imm);
+				break;
+			case FUNCT_SRLV:
+				e.result[0] = static_cast<u_word_32>(B) >> static_cast<u_word_32>(A);
+				break;
+			case FUNCT_DIV:
+				// A wrong path DIV may see a zero divisor; it is squashed
+				// before it retires, so just avoid trapping the host.
+				e.result[0] = ( B != 0 ) ? A / B : 0;	// quotient
+				e.result[1] = ( B != 0 ) ? A % B : 0;	// remainder
+				break;
+			case FUNCT_MULT:
+				HiLoBuffer = static_cast<word_64>(A) * static_cast<word_64>(B);
+				e.result[0] = static_cast<word_32>(HiLoBuffer & 0x00000000ffffffff);
+				e.result[1] = static_cast<word_32>((HiLoBuffer >>32) & 0x00000000ffffffff);
+				break;
+			case FUNCT_MFHI: case FUNCT_MFLO: case FUNCT_MTHI: case FUNCT_MTLO:
+				e.result[0] = A;
+				break;
+			};
+		}
+		else switch ( e.inst.noF.op )
+		{
+		case OP_ADDI: e.result[0] = A + e.Imm; break;
+		case OP_ANDI: e.result[0] = A & e.Imm; break;
+		case OP_ORI:  e.result[0] = A | e.Imm; break;
+		case OP_XORI: e.result[0] = A ^ e.Imm; break;
+		case OP_SLTI: e.result[0] = ( A < e.Imm ) ? 1 : 0; break;
+		case OP_LUI:  e.result[0] = ( B & 0x0000ffff ) | e.Imm; break;
+		};
+		break;
+		
+	default:
+		break;
+	};
+	
+	e.issued = true;
+	e.completeCycle = cycles + latency;
+	return true;
+}
+
+// A load may only read memory once every older store has a known address.
+// The youngest older store to the same address forwards its data.
+bool OOOProcessor :: ExecuteLoad ( int robIndex )
+{
+	OOO_RobEntry & e = rob[robIndex];
+	OOO_LsqEntry & l = lsq[e.lsqIndex];
+	
+	l.address = SourceValue ( e, 0 ) + e.Imm;
+	l.addressReady = true;
+	
+	int i = e.lsqIndex;
+	while ( i != lsqHead )
+	{
+		i = ( i - 1 + lsqSize ) % lsqSize;
+		OOO_LsqEntry & s = lsq[i];
+		if ( s.isStore == false ) continue;
+		if ( s.addressReady == false )
+		{
+			stallCycles[OOO_STALL_MEM_ORDER] ++;
+			return false;
+		}
+		bool overlaps = ( s.address < l.address + l.noOfBytes ) &&
+			( l.address < s.address + s.noOfBytes );
+		if ( overlaps == false ) continue;
+		if ( s.address == l.address && s.noOfBytes == l.noOfBytes && s.dataReady )
+		{
+			e.result[0] = Processor::LoadValue ( e.inst.noF.op, s.data );
+			l.data = e.result[0];
+			l.dataReady = true;
+			e.issued = true;
+			e.completeCycle = cycles + OOO_LOAD_LATENCY;
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Issue ] " << Processor::MemOpName ( e.inst.noF.op ) 
+				<< " at PC = " << e.PC << " forwarded " << e.result[0]
+				<< " from the store queue" << flush;
+			sem_post ( cout_mutex );
+			return true;
+		}
+		stallCycles[OOO_STALL_MEM_ORDER] ++;
+		return false;	// Wait for the store to retire
+	}
+	
+	if ( ReadMem ( l.address, e.result[0], l.noOfBytes, e.PC ) == false )
+	{
+		// Possibly a wrong path load; the value is never used if so.
+		e.result[0] = 0;
+	}
+	e.result[0] = Processor::LoadValue ( e.inst.noF.op, e.result[0] );
+	l.data = e.result[0];
+	l.dataReady = true;
+	e.issued = true;
+	// A miss adds its latency beyond that of a hit; the caches are
+	// taken to accept another access every clock.
+	e.completeCycle = cycles + OOO_LOAD_LATENCY + lastLoadLatency - 1;
+	return true;
+}
+
+void OOOProcessor :: Issue ( )
+{
+	for ( int i = 0; i < iqSize; i++ )
+		iqTried[i] = false;
+	
+	int issuedCount = 0;
+	while ( issuedCount < width )
+	{
+		// Pick the oldest ready entry that has not been tried this cycle
+		int best = -1;
+		for ( int i = 0; i < iqSize; i++ )
+		{
+			if ( iq[i] == -1 || iqTried[i] == true ) continue;
+			if ( SourcesReady ( rob[iq[i]] ) == false ) continue;
+			if ( best == -1 || rob[iq[i]].seq < rob[iq[best]].seq ) best = i;
+		}
+		if ( best == -1 ) return;
+		iqTried[best] = true;
+		
+		int robIndex = iq[best];
+		if ( Execute ( robIndex ) == false )
+			continue;	// Stays in the issue queue for the next clock
+		
+		iq[best] = -1;
+		iqCount --;
+		rob[robIndex].inIQ = false;
+		issuedCount ++;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Issue ] ROB[" << robIndex << "] PC = " << rob[robIndex].PC << flush;
+		sem_post ( cout_mutex );
+	}
+}
+
+void OOOProcessor :: Writeback ( )
+{
+	// Walk in program order so that the oldest mispredict wins
+	for ( int n = 0, i = robHead; n < robCount; n++, i = ( i + 1 ) % robSize )
+	{
+		OOO_RobEntry & e = rob[i];
+		if ( e.issued == false || e.completed == true || e.completeCycle > cycles )
+			continue;
+		
+		for ( int d = 0; d < 2; d++ )
+			if ( e.dstPhys[d] != -1 )
+			{
+				physValue[e.dstPhys[d]] = e.result[d];
+				physReady[e.dstPhys[d]] = true;
+			}
+		e.completed = true;
+		
+		if ( e.uopClass == OOO_JUMPREG )
+		{
+			// Fetch was held since this instruction, so nothing to squash
+			fetchPC = e.actualNPC;
+			fetchBlocked = false;
+			
+			sem_wait ( cout_mutex );
+			cout << skyblue << "\n[ Writeback ] JR at PC = " << e.PC
+				<< " resolved to " << e.actualNPC << reset << flush;
+			sem_post ( cout_mutex );
+		}
+		else if ( e.uopClass == OOO_BRANCH && e.actualNPC != e.predNPC )
+		{
+			mispredictions ++;
+			
+			sem_wait ( cout_mutex );
+			cout << skyblue << "\n[ Writeback ] Branch at PC = " << e.PC
+				<< " mispredicted, refetching from " << e.actualNPC 
+				<< reset << flush;
+			sem_post ( cout_mutex );
+			
+			Squash ( i );
+			fetchPC = e.actualNPC;
+			return;		// Everything younger is gone
+		}
+	}
+}
+
+// Removes every instruction younger than rob[robIndex], undoing their renames
+void OOOProcessor :: Squash ( int robIndex )
+{
+	while ( robTail != ( robIndex + 1 ) % robSize )
+	{
+		robTail = ( robTail - 1 + robSize ) % robSize;
+		robCount --;
+		OOO_RobEntry & e = rob[robTail];
+		
+		for ( int d = 1; d >= 0; d-- )
+			if ( e.dstArch[d] != -1 )
+			{
+				mapTable[e.dstArch[d]] = e.oldPhys[d];
+				physReady[e.dstPhys[d]] = true;
+				freeList[freeCount++] = e.dstPhys[d];
+			}
+		
+		if ( e.inIQ == true )
+			for ( int i = 0; i < iqSize; i++ )
+				if ( iq[i] == robTail )
+				{
+					iq[i] = -1;
+					iqCount --;
+					break;
+				}
+		
+		if ( e.lsqIndex != -1 )
+		{
+			lsqTail = ( lsqTail - 1 + lsqSize ) % lsqSize;
+			lsq[lsqTail].valid = false;
+			lsqCount --;
+		}
+		
+		if ( e.inst.iV != 0 ) squashedInstructions ++;
+		e.Initialise ( );
+	}
+	
+	squashedInstructions += fetchBufferCount;
+	fetchBufferHead = fetchBufferCount = 0;
+	fetchBlocked = false;
+}
+
+void OOOProcessor :: Retire ( )
+{
+	for ( int n = 0; n < width && robCount > 0; n++ )
+	{
+		OOO_RobEntry & e = rob[robHead];
+		
+		if ( e.completed == false )
+		{
+			if ( n == 0 )
+			{
+				switch ( e.uopClass )
+				{
+				case OOO_LOAD:		stallCycles[OOO_STALL_HEAD_LOAD] ++; break;
+				case OOO_STORE:		stallCycles[OOO_STALL_HEAD_STORE] ++; break;
+				case OOO_BRANCH:
+				case OOO_JUMPREG:	stallCycles[OOO_STALL_HEAD_BRANCH] ++; break;
+				case OOO_IO:		stallCycles[OOO_STALL_HEAD_IO] ++; break;
+				default:		stallCycles[OOO_STALL_HEAD_ALU] ++; break;
+				};
+			}
+			return;
+		}
+		
+		if ( e.inst.noF.op == OP_LL )
+		{
+			linkValid = true;
+			linkAddress = lsq[e.lsqIndex].address;
+		}
+		
+		if ( e.uopClass == OOO_STORE && lsq[e.lsqIndex].noOfBytes > 0 )
+		{
+			OOO_LsqEntry & s = lsq[e.lsqIndex];
+			if ( WriteMem ( s.address, s.data, s.noOfBytes, e.PC ) == false )
+			{
+				sem_wait ( cout_mutex );
+				cout << red << "\n[ Retire ] SW to " << s.address
+					<< " failed, will try again in next clock" << reset << flush;
+				sem_post ( cout_mutex );
+				if ( n == 0 ) stallCycles[OOO_STALL_HEAD_STORE] ++;
+				return;
+			}
+		}
+		
+		for ( int d = 0; d < 2; d++ )
+			if ( e.dstArch[d] != -1 )
+			{
+				retireMap[e.dstArch[d]] = e.dstPhys[d];
+				freeList[freeCount++] = e.oldPhys[d];
+				
+				sem_wait ( cout_mutex );
+				cout << violet << "\n[ Retire ] r" << e.dstArch[d] << " = "
+					<< physValue[e.dstPhys[d]] << reset << flush;
+				sem_post ( cout_mutex );
+			}
+		
+		if ( e.lsqIndex != -1 )
+		{
+			lsq[lsqHead].valid = false;
+			lsqHead = ( lsqHead + 1 ) % lsqSize;
+			lsqCount --;
+		}
+		
+		if ( e.inst.iV != 0 ) retiredInstructions ++;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Retire ] PC = " << e.PC << flush;
+		sem_post ( cout_mutex );
+		
+		e.Initialise ( );
+		robHead = ( robHead + 1 ) % robSize;
+		robCount --;
+	}
+}
+
+void OOOProcessor :: OneCycle ( )
+{
+	Retire ( );
+	Writeback ( );
+	Issue ( );
+	Dispatch ( );
+	Fetch ( );
+	if ( scratchpad != NULL )
+		scratchpad -> Clock ( static_cast<int>( cycles ) );
+	if ( shadows != NULL )
+		shadows -> Clock ( );
+	
+	robOccupancySum += robCount;
+	if ( robCount > robOccupancyMax ) robOccupancyMax = robCount;
+	cycles ++;
+}
+
+void OOOProcessor :: Execute ( )
+{
+	do
+	{
+		Clock ( );
+		OneCycle ( );
+	} while ( true );
+}
+
+/*********************************************************************************
+*******************User interface************************************************/
+// Same commands as Processor :: Clock ( ), see pclock.cpp.
+// Registers shown are the retired (architectural) values.
+
+void OOOProcessor :: Clock ( )
+{
+	if ( requestProgramTermination == true )
+	{
+		int cout_mutex_value;
+		if ( sem_getvalue ( cout_mutex, &cout_mutex_value ) == -1 )
+			cout << red << "\nError polling the value of cout_mutex"
+				<< reset << flush;
+		else
+			cout << gray << "\nThe value of cout_mutex at closing = "
+				<< cout_mutex_value << gray << flush;
+			
+		sem_close ( cout_mutex );
+		sem_unlink ( "/coutmutex" );
+		
+		if ( scratchpad != NULL )
+			scratchpad -> AtExit ( );
+		if ( shadows != NULL )
+			shadows -> AtExit ( );
+		dataCache -> AtExit ( );
+		instrCache -> AtExit ( );
+		pman -> AtExit ( );
+		AtExit ( );
+		
+		cout << "\n\n" << flush;
+		std::exit ( -99 );
+	}
+	
+	cout << blue << "\n[** Clock: " << cycles << " **] Executed..." << reset << flush;
+	
+	if ( continueCount > 0 )
+	{
+		continueCount --;
+		for ( int i = 0; i < BREAKPOINTARRAYSIZE; i++ )
+		{
+			if ( static_cast<word_32>(fetchPC) == breakPointArray[i] )
+			{
+				continueCount = 0;
+				break;
+			}
+		}
+	}
+	else if ( continueCount < 0 )
+	{
+		cout << red << "\n[** Clock: " << cycles 
+			<< " **] negative continue count, resetting" 
+			<< reset << flush;
+		continueCount = 0;
+	}
+	
+	cout << "\n" << flush;
+	
+	if ( continueCount == 0 )
+	{
+		char ch;
+		do
+		{
+			cout << blue << "\nmips > " << reset << flush;
+			cin >> ch;
+			switch ( ch )
+			{
+			case 'p':	// small p
+				cout << blue << "\nRegister Values are printed below." 
+					<< reset << flush;
+				for ( int i = 0; i < 32 ; i++ )
+				{
+					cout << "\n  r" << setw (2) << i << ": value = " 
+						<< physValue[retireMap[i]] << flush;
+				}
+				cout << "\n  Lo : value = " << physValue[retireMap[REG_LO]] << flush;
+				cout << "\n  Hi : value = " << physValue[retireMap[REG_HI]] << flush;
+				cout << "\n  PC : value = " << fetchPC << flush;
+				break;
+
+			case 'P':	// capital P
+				cout << blue << "\nNon-zero Register Values"
+					<< " are printed below."
+					<< reset << flush;
+				for ( int i = 0; i < 32 ; i++ )
+				{
+					if ( physValue[retireMap[i]] != 0 )
+						cout << "\n  r" << setw (2) << i 
+							<< ": value = " 
+							<< physValue[retireMap[i]] << flush;
+				}
+				if ( physValue[retireMap[REG_LO]] != 0 ) 
+					cout << "\n  Lo : value = " << physValue[retireMap[REG_LO]] << flush;
+				if ( physValue[retireMap[REG_HI]] != 0 ) 
+					cout << "\n  Hi : value = " << physValue[retireMap[REG_HI]] << flush;
+				cout << "\n  PC : value = " << fetchPC << flush;	
+						// PC is always printed
+				break;
+
+			case 'q':
+				Terminate ( );
+
+			case 'h':
+			case '?':
+				cout << blue
+					<< "\nCommands:"
+					<< "\n  h or ?       show this help"
+					<< "\n  n            execute one clock cycle"
+					<< "\n  c <number>   execute <number> clock cycles"
+					<< "\n  p            print all registers"
+					<< "\n  P            print non-zero registers"
+					<< "\n  m <addr>     display memory word at <addr>"
+					<< "\n  d <addr>     display data cache word at <addr>"
+					<< "\n  i <addr>     display instruction cache word at <addr>"
+					<< "\n  s            display core and cache statistics"
+					<< "\n  b <i> <addr> set breakpoint i (0-15) to <addr> (use -1 to clear)"
+					<< "\n  B            list breakpoints"
+					<< "\n  q            quit"
+					<< reset << flush;
+				break;
+
+			case 'n':
+				break;	// Do nothing... Avoid going into "default"
+
+			case 'm': {
+				int address;
+				cin >> address;
+
+				word_32 result;
+				if ( mem -> Read ( address, result, 4 ) == true )
+					cout << blue << "\nMemory[" << address << "] = " 
+						<< result << " " 
+						<< static_cast<char>(result) 
+						<< reset << flush;
+				else cout << red << "\nMemory read failed" << reset << flush;
+
+				break;
+				}
+
+			case 'd': {
+				int address;
+				cin >> address;
+
+				word_32 result;
+				if ( dataCache -> Read_nofetch ( address, result, 4 ) 
+						== true )
+					cout << blue << "\ndataCache[" << address << "] = " 
+						<< result << reset << flush;
+				else cout << red << "\ndataCache read missed" 
+					<< reset << flush;
+
+				break;
+				}
+
+			case 'i': {
+				int address;
+				cin >> address;
+
+				word_32 result;
+				if ( instrCache -> Read_nofetch ( address, result, 4 ) 
+						== true )
+					cout << blue << "\ninstrCache[" << address << "] = " 
+						<< result << reset << flush;
+				else cout << red << "\ninstrCache read missed" 
+					<< reset << flush;
+
+				break;
+				}
+
+			case 's':
+				Statistics ( );
+				if ( scratchpad != NULL )
+				{
+					cout << blue << "\nScratchpad Statistics : " << reset << flush;
+					scratchpad -> Statistics ( );
+				}
+				cout << blue << "\ndataCache Statistics : " 
+					<< reset << flush;
+				dataCache -> Statistics ( );
+				cout << blue << "\ninstrCache Statistics : " 
+					<< reset << flush;
+				instrCache -> Statistics ( );
+				if ( shadows != NULL )
+					shadows -> Statistics ( dataCache, instrCache, mem );
+				break;
+				
+			case 'c': cin >> continueCount;
+				break;
+				
+			case 'b':{
+				int breakPointIndex;
+				cin >> breakPointIndex;
+				cin >> breakPointArray[breakPointIndex];
+				break;
+				}
+				
+			case 'B':
+				cout << blue << "\n[** Clock: " << cycles 
+					<< " **] The break points are listed below\n"
+					<< reset << flush;
+				for ( int i = 0; i < BREAKPOINTARRAYSIZE; i ++ )
+					if ( breakPointArray[i] != -1 )
+						cout << "\t" << i << "\t" 
+							<< breakPointArray[i] << "\n";
+				cout << flush;
+				break;
+
+			default:
+				cout << red << "\n[** Clock: " << cycles 
+					<< " **] Unrecognised command,"
+					<< " Ignoring... " << reset << flush;
+				continueCount = 0;
+				break;
+			};
+		}
+		while ( ch != 'q' && ch != 'n' && ch != 'c' );
+	}
+}
+
+/*********************************************************************************
+*******************Statistics****************************************************/
+
+const char * OOOProcessor :: StallReasonName ( int reason )
+{
+	switch ( reason )
+	{
+	case OOO_STALL_ROB_FULL:	return "dispatch: ROB full";
+	case OOO_STALL_IQ_FULL:		return "dispatch: issue queue full";
+	case OOO_STALL_LSQ_FULL:	return "dispatch: load/store queue full";
+	case OOO_STALL_NO_PREG:		return "dispatch: no free physical register";
+	case OOO_STALL_FETCH_EMPTY:	return "dispatch: nothing fetched";
+	case OOO_STALL_INDIRECT:	return "dispatch: fetch held by JR/JALR";
+	case OOO_STALL_HEAD_ALU:	return "retire: ALU op at head";
+	case OOO_STALL_HEAD_LOAD:	return "retire: load at head";
+	case OOO_STALL_HEAD_STORE:	return "retire: store at head";
+	case OOO_STALL_HEAD_BRANCH:	return "retire: branch at head";
+	case OOO_STALL_HEAD_IO:		return "retire: device access at head";
+	case OOO_STALL_MEM_ORDER:	return "issue: load waiting on older store";
+	};
+	return "unknown";
+}
+
+void OOOProcessor :: Statistics ( )
+{
+	sem_wait ( cout_mutex );
+	cout << gray << "\nOut-of-order core ( ROB " << robSize << ", width " << width
+		<< ", IQ " << iqSize << ", LSQ " << lsqSize << " )"
+		<< "\n  Cycles                 : " << cycles
+		<< "\n  Instructions retired   : " << retiredInstructions
+		<< "\n  Instructions fetched   : " << fetchedInstructions
+		<< "\n  Instructions squashed  : " << squashedInstructions
+		<< "\n  Branch mispredictions  : " << mispredictions;
+	if ( cycles > 0 )
+		cout << "\n  IPC                    : " 
+			<< static_cast<double>(retiredInstructions) / cycles
+			<< "\n  Average ROB occupancy  : " 
+			<< static_cast<double>(robOccupancySum) / cycles;
+	cout << "\n  Maximum ROB occupancy  : " << robOccupancyMax
+		<< "\n  Stall cycles by reason :";
+	for ( int i = 0; i < OOO_STALL_REASONS; i++ )
+		if ( stallCycles[i] != 0 )
+			cout << "\n    " << setw (40) << std::left << StallReasonName ( i )
+				<< std::right << stallCycles[i];
+	cout << reset << flush;
+	sem_post ( cout_mutex );
+}
@@ -0,0 +1,230 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An out-of-order timing model of the same MIPS-like core.
+ * It runs next to the 5-stage in-order Processor, on the same binaries,
+ * using the same Cache hierarchy and PortManager.
+ *
+ * The model renames the 32 GPRs plus Hi and Lo onto a physical register
+ * file, dispatches into a reorder buffer, an issue queue and a load/store
+ * queue, and retires in program order.  Stores and device accesses only
+ * touch memory / devices at retirement, so retirement is precise.
+ * Conditional branches are predicted backward-taken / forward-not-taken,
+ * and the machine is squashed back to the branch on a mispredict.
+ * JR / JALR stall fetch until they resolve.
+ *
+ * Unlike Processor, the whole model runs on the calling thread; there
+ * are no stage threads because stages are evaluated in reverse order
+ * within one call to OneCycle ( ).
+ */
+
+# ifndef __OOO_PROCESSOR_H
+# define __OOO_PROCESSOR_H
+
+# include "memory.h"
+# include "portmanager.h"
+# include "../include/opcodes.h"
+
+# include <semaphore.h>
+
+# include "processor.h"	// For SYSTEM_START_ADDRESS, REG_HI, REG_LO etc.
+
+# define OOO_ARCH_REGS		34	// 32 GPRs + Hi + Lo
+# define OOO_MAX_WIDTH		8
+
+// Default sizes, overridden through the constructor
+# define OOO_DEFAULT_ROB_SIZE	32
+# define OOO_DEFAULT_WIDTH	2
+# define OOO_DEFAULT_IQ_SIZE	16
+# define OOO_DEFAULT_LSQ_SIZE	16
+
+// Execution latencies, in cycles.  These match the single cycle EX and MEM
+// stages of the in-order pipeline so that the two models are comparable.
+# define OOO_ALU_LATENCY	1
+# define OOO_LOAD_LATENCY	1
+# define OOO_STORE_LATENCY	1
+
+enum OOOUopClass { OOO_NOP, OOO_ALU, OOO_LOAD, OOO_STORE, OOO_BRANCH,
+	OOO_JUMP, OOO_JUMPREG, OOO_IO };
+
+// Reasons for which no instruction could be dispatched or retired.
+enum OOOStallReason { OOO_STALL_ROB_FULL, OOO_STALL_IQ_FULL, OOO_STALL_LSQ_FULL,
+	OOO_STALL_NO_PREG, OOO_STALL_FETCH_EMPTY, OOO_STALL_INDIRECT,
+	OOO_STALL_HEAD_ALU, OOO_STALL_HEAD_LOAD, OOO_STALL_HEAD_STORE,
+	OOO_STALL_HEAD_BRANCH, OOO_STALL_HEAD_IO, OOO_STALL_MEM_ORDER,
+	OOO_STALL_REASONS };
+
+class OOO_RobEntry
+{
+public:
+	bool valid;
+	word_64 seq;		// Program order, used for age comparisons.
+	u_word_32 PC;
+	Inst inst;
+	OOOUopClass uopClass;
+	
+	int srcArch[2];		// -1 if unused
+	int srcPhys[2];
+	int dstArch[2];		// -1 if unused
+	int dstPhys[2];
+	int oldPhys[2];		// Mapping to be freed at retirement
+	
+	word_32 Imm;
+	word_32 result[2];	// Values for dstPhys[0] / dstPhys[1]
+	
+	bool inIQ;
+	bool issued;
+	bool completed;
+	word_64 completeCycle;
+	
+	u_word_32 predNPC;	// Where fetch went after this instruction
+	u_word_32 actualNPC;
+	
+	int lsqIndex;		// -1 if not a memory instruction
+	
+	void Initialise ( );
+};
+
+class OOO_LsqEntry
+{
+public:
+	bool valid;
+	bool isStore;
+	int robIndex;
+	bool addressReady;
+	word_32 address;
+	int noOfBytes;
+	bool dataReady;
+	word_32 data;
+};
+
+class OOOProcessor
+{
+private:
+	// Configuration
+	int robSize;
+	int width;		// fetch, dispatch, issue and retire width
+	int iqSize;
+	int lsqSize;
+	int noOfPhysRegs;
+	
+	// Architectural and physical state
+	int mapTable [OOO_ARCH_REGS];	// speculative rename map
+	int retireMap [OOO_ARCH_REGS];	// architectural (retired) map
+	word_32 * physValue;
+	bool * physReady;
+	int * freeList;
+	int freeCount;
+	
+	OOO_RobEntry * rob;
+	int robHead, robTail, robCount;
+	word_64 nextSeq;
+	
+	int * iq;		// rob indices, -1 if free
+	bool * iqTried;		// scratch for Issue ( )
+	int iqCount;
+	
+	OOO_LsqEntry * lsq;
+	int lsqHead, lsqTail, lsqCount;
+	
+	// Front end
+	u_word_32 fetchPC;
+	bool fetchBlocked;	// set after a JR / JALR until it resolves
+	u_word_32 * fetchBufferPC;
+	Inst * fetchBufferInst;
+	u_word_32 * fetchBufferNPC;
+	int fetchBufferHead, fetchBufferCount, fetchBufferSize;
+	
+	MainMemory * mem;
+	Cache * dataCache;
+	Cache * instrCache;
+	Scratchpad * scratchpad;	// NULL if there is none
+	ShadowSet * shadows;		// likewise
+	int lastLoadLatency;	// of the last ReadMem
+	PortManager * pman;
+	
+	bool blockUpdate;	// Same meaning as in Processor
+	
+	// LL / SC.  This core runs a single thread on its own, so the link
+	// set by a retiring LL can only be consumed by an SC.
+	bool linkValid;
+	word_32 linkAddress;
+	bool requestProgramTermination;
+	
+	// Statistics
+	word_64 cycles;
+	word_64 retiredInstructions;
+	word_64 fetchedInstructions;
+	word_64 squashedInstructions;
+	word_64 mispredictions;
+	word_64 robOccupancySum;
+	int robOccupancyMax;
+	word_64 stallCycles [OOO_STALL_REASONS];
+	
+	// Stepping control, as in Processor
+	int continueCount;
+	word_32 breakPointArray[BREAKPOINTARRAYSIZE];
+	
+	// Pipeline steps, called in reverse order from OneCycle ( )
+	void Retire ( );
+	void Writeback ( );
+	void Issue ( );
+	void Dispatch ( );
+	void Fetch ( );
+	
+	bool Decode ( OOO_RobEntry & e );
+	bool Execute ( int robIndex );
+	bool ExecuteLoad ( int robIndex );
+	void Squash ( int robIndex );
+	
+	int AllocPhys ( );
+	bool SourcesReady ( OOO_RobEntry & e );
+	word_32 SourceValue ( OOO_RobEntry & e, int i );
+	
+	void OneCycle ( );
+	void Clock ( );	// The user interface, same commands as Processor
+	
+	static const char * StallReasonName ( int reason );
+public:
+	OOOProcessor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm,
+		int robsz = OOO_DEFAULT_ROB_SIZE, int wid = OOO_DEFAULT_WIDTH,
+		int iqsz = OOO_DEFAULT_IQ_SIZE, int lsqsz = OOO_DEFAULT_LSQ_SIZE );
+	~OOOProcessor ( );
+	void AtExit ( );
+	
+	void Terminate ( );
+	void SetScratchpad ( Scratchpad * sp );	// Same as in Processor
+	void SetShadows ( ShadowSet * s );	// likewise
+	void Execute ( );	// Runs the simulation loop, never returns
+	
+	// Same semantics as the Processor functions of the same name; pc is
+	// that of the load or store, for the cache's prefetcher.
+	bool ReadMem ( word_32 address, word_32 & result, int noOfBytes, 
+		u_word_32 pc );
+	bool WriteMem ( word_32 address, word_32 value, int noOfBytes, u_word_32 pc );
+	
+	void Statistics ( );
+};
+
+# endif
@@ -22,6 +22,7 @@
  */
 
 # include "processor.h"
+# include "multicore.h"
 
 # include <iostream>
 using std::cout;
@@ -49,6 +50,11 @@ void Processor :: Clock ( int clk )
 {	
 	if ( requestProgramTermination == true )
 	{
+		// SIGTERM ends the whole program, so the shadows have to finish,
+		// and the trace be written out, before the stages are stopped.
+		if ( shadows != NULL )
+			shadows -> AtExit ( );
+		
 		for ( int i = 0; i < 5; i++ )
 			pthread_kill (stagethread[i],SIGTERM);
 			
@@ -67,6 +73,12 @@ void Processor :: Clock ( int clk )
 		// the various destructors don't get invoked...
 		// Therefore, instead of a destructor, we have provided
 		// an 'AtExit()' functions wherever applicable
+		if ( system != NULL )
+			system -> AtExit ( );	// The other cores and the bus
+		if ( storeBuffer != NULL )
+			storeBuffer -> AtExit ( );
+		if ( scratchpad != NULL )
+			scratchpad -> AtExit ( );
 		dataCache -> AtExit ( );
 		instrCache -> AtExit ( );
 		pman -> AtExit ( );
@@ -76,13 +88,35 @@ void Processor :: Clock ( int clk )
 		std::exit ( -99 );
 	}
 	
+	// The store buffer gets the data cache in the clock that just ended
+	// if Stage3 left it free, and the DMA engine after that.
+	DrainStoreBuffer ( );
+	if ( scratchpad != NULL )
+	{
+		LockMemory ( );
+		scratchpad -> Clock ( cycles );
+		UnlockMemory ( );
+	}
+	if ( shadows != NULL )
+		shadows -> Clock ( );
+	
+	cycles = clk;
 	cout << blue << "\n[** Clock: " << clk << " **] Executed..." << reset << flush;
 	
+	// A taken branch that leaves the last extra EX stage this clock moves
+	// its thread's PC now, which flushes the younger stages behind it.
+	if ( exExtra > 0 && outLatch[4].finished == true 
+			&& outLatch[3].finished == true 
+			&& exTail[exExtra - 1].redirect == true )
+		ResolveBranch ( clk );
+	
 	for ( int i = 0; i < 5; i++ )
 		if ( flushStage[i] == true )
 		{
 			cout << blue << "\n[** Clock: " << clk << " **] Flushing stage "
 				<< i << reset << flush;
+			if ( outLatch[i].inst.iV != 0 )
+				ctx[outLatch[i].thread].flushedInstructions ++;
 			inLatch[i].Initialise ( );
 			inLatch[i].finished = true;
 			outLatch[i].Initialise ( );
@@ -91,19 +125,35 @@ void Processor :: Clock ( int clk )
 	
 	if ( outLatch[4].finished == true )
 	{
+		// The extra MEM and EX stages never stall, they move on
+		// whenever the stage after them does.
+		Latch & memOut = ( memExtra > 0 ) ? memTail[0] : inLatch[4];
+		if ( memExtra > 0 )
+		{
+			LatchCopy ( inLatch[4], memTail[memExtra - 1] );
+			ShiftTail ( memTail, memExtra );
+		}
+		
 		if ( outLatch[3].finished == true )
 		{
 			//cout << "\n[** Clock: " << clk 
 			//	<< " **] inLatch[4] <- outLatch[3]"
 			//	<< flush;
-			LatchCopy ( inLatch[4], outLatch[3] );
+			LatchCopy ( memOut, outLatch[3] );
+			
+			Latch & exOut = ( exExtra > 0 ) ? exTail[0] : inLatch[3];
+			if ( exExtra > 0 )
+			{
+				LatchCopy ( inLatch[3], exTail[exExtra - 1] );
+				ShiftTail ( exTail, exExtra );
+			}
 			
 			if ( outLatch[2].finished == true )
 			{
 				//cout << "\n[** Clock: " << clk 
 				//	<< " **] inLatch[3] <- outLatch[2]"
 				//	<< flush;
-				LatchCopy ( inLatch[3], outLatch[2] );
+				LatchCopy ( exOut, outLatch[2] );
 				
 				if ( outLatch[1].finished == true )
 				{
@@ -120,14 +170,21 @@ void Processor :: Clock ( int clk )
 						LatchCopy ( inLatch[1], outLatch[0] );
 						inLatch[0].Initialise ( );
 						
-						NPCfrom = NOT_WRITTEN;
 		// If pipeline was stalled at ID, but a branch in EX had completed, then
 		// the NPCreg value should be preserved.  NPCfrom is updated only if 
 		// there were no stalls.
-						PCreg = NPCreg;
+		// Threads that neither fetched nor branched keep their PC.
+						for ( int t = 0; t < noOfThreads; t++ )
+							if ( ctx[t].NPCfrom != NOT_WRITTEN )
+							{
+								ctx[t].NPCfrom = NOT_WRITTEN;
+								ctx[t].PCreg = ctx[t].NPCreg;
+							}
+						fetchThread = NextFetchThread ( );
 					}
 					else
 					{
+						ifStallCycles ++;
 						cout << blue << "\n[** Clock: " << clk 
 							<< " **] inLatch[1].Initialise ( )"
 							<< reset << flush;
@@ -136,6 +193,8 @@ void Processor :: Clock ( int clk )
 				}
 				else
 				{
+					idStallCycles ++;
+					ctx[inLatch[1].thread].idStallCycles ++;
 					cout << blue << "\n[** Clock: " << clk 
 						<< " **] inLatch[2].Initialise ( )"
 						<< reset << flush;
@@ -145,17 +204,20 @@ void Processor :: Clock ( int clk )
 			else
 			{
 				cout << blue << "\n[** Clock: " << clk 
-					<< " **] inLatch[3].Initialise ( )"
+					<< ( exExtra > 0 ? " **] exTail[0].Initialise ( )" 
+						: " **] inLatch[3].Initialise ( )" )
 					<< reset << flush;
-				inLatch[3].Initialise ( );
+				exOut.Initialise ( );
 			}
 		}
 		else
 		{
+			memStallCycles ++;
 			cout << blue << "\n[** Clock: " << clk 
-				<< " **] inLatch[4].Initialise ( )"
+				<< ( memExtra > 0 ? " **] memTail[0].Initialise ( )" 
+					: " **] inLatch[4].Initialise ( )" )
 				<< reset << flush;
-			inLatch[4].Initialise ( );
+			memOut.Initialise ( );
 		}
 	}
 	
@@ -163,6 +225,7 @@ void Processor :: Clock ( int clk )
 	{
 		outLatch[i].Initialise ( );
 		flushStage[i] = false;
+		stageDone[i] = false;
 	}
 	// The above is required because latchcopy from inlatch to outlatch
 	// happens only once the stage thread got a chance to run
@@ -172,7 +235,7 @@ void Processor :: Clock ( int clk )
 		continueCount --;
 		for ( int i = 0; i < BREAKPOINTARRAYSIZE; i++ )
 		{
-			if ( PCreg == breakPointArray[i] )
+			if ( ctx[fetchThread].PCreg == static_cast<u_word_32>(breakPointArray[i]) )
 			{
 				continueCount = 0;
 				break;
@@ -189,7 +252,9 @@ void Processor :: Clock ( int clk )
 	
 	cout << "\n" << flush;
 	
-	if ( continueCount == 0 )
+	// Only core 0 talks to the user; the other cores run on until the
+	// next quantum barrier and wait there for core 0 to catch up.
+	if ( continueCount == 0 && coreId == 0 )
 	{
 		char ch;
 		do
@@ -201,31 +266,43 @@ void Processor :: Clock ( int clk )
 			case 'p':	// small p
 				cout << blue << "\nRegister Values are printed below." 
 					<< reset << flush;
-				for ( int i = 0; i < 32 ; i++ )
+				for ( int t = 0; t < noOfThreads; t++ )
 				{
-					cout << "\n  r" << setw (2) << i << ": value = " 
-						<< reg[i] << flush;
+					ThreadContext & c = ctx[t];
+					if ( noOfThreads > 1 )
+						cout << blue << "\n Thread " << t << reset << flush;
+					for ( int i = 0; i < 32 ; i++ )
+					{
+						cout << "\n  r" << setw (2) << i << ": value = " 
+							<< c.reg[i] << flush;
+					}
+					cout << "\n  Lo : value = " << c.Lo << flush;
+					cout << "\n  Hi : value = " << c.Hi << flush;
+					cout << "\n  PC : value = " << c.PCreg << flush;
 				}
-				cout << "\n  Lo : value = " << Lo << flush;
-				cout << "\n  Hi : value = " << Hi << flush;
-				cout << "\n  PC : value = " << PCreg << flush;
 				break;
 
 			case 'P':	// capital P
 				cout << blue << "\nNon-zero Register Values"
 					<< " are printed below."
 					<< reset << flush;
-				for ( int i = 0; i < 32 ; i++ )
+				for ( int t = 0; t < noOfThreads; t++ )
 				{
-					if ( reg[i]!= 0 )
-						cout << "\n  r" << setw (2) << i 
-							<< ": value = " 
-							<< reg[i] << flush;
+					ThreadContext & c = ctx[t];
+					if ( noOfThreads > 1 )
+						cout << blue << "\n Thread " << t << reset << flush;
+					for ( int i = 0; i < 32 ; i++ )
+					{
+						if ( c.reg[i]!= 0 )
+							cout << "\n  r" << setw (2) << i 
+								<< ": value = " 
+								<< c.reg[i] << flush;
+					}
+					if ( c.Lo != 0 ) cout << "\n  Lo : value = " << c.Lo << flush;
+					if ( c.Hi != 0 ) cout << "\n  Hi : value = " << c.Hi << flush;
+					cout << "\n  PC : value = " << c.PCreg << flush;	
+							// PC is always printed
 				}
-				if ( Lo != 0 ) cout << "\n  Lo : value = " << Lo << flush;
-				if ( Hi != 0 ) cout << "\n  Hi : value = " << Hi << flush;
-				cout << "\n  PC : value = " << PCreg << flush;	
-						// PC is always printed
 				break;
 
 			case 'q':
@@ -244,7 +321,7 @@ void Processor :: Clock ( int clk )
 					<< "\n  m <addr>     display memory word at <addr>"
 					<< "\n  d <addr>     display data cache word at <addr>"
 					<< "\n  i <addr>     display instruction cache word at <addr>"
-					<< "\n  s            display cache statistics"
+					<< "\n  s            display core and cache statistics"
 					<< "\n  b <i> <addr> set breakpoint i (0-15) to <addr> (use -1 to clear)"
 					<< "\n  B            list breakpoints"
 					<< "\n  q            quit"
@@ -300,12 +377,13 @@ void Processor :: Clock ( int clk )
 				}
 
 			case 's':
-				cout << blue << "\ndataCache Statistics : " 
-					<< reset << flush;
-				dataCache -> Statistics ( );
-				cout << blue << "\ninstrCache Statistics : " 
-					<< reset << flush;
-				instrCache -> Statistics ( );
+				if ( system != NULL )
+					system -> Statistics ( );
+				else
+				{
+					Statistics ( );
+					CacheStatistics ( );
+				}
 				break;
 				
 			case 'c': cin >> continueCount;
@@ -340,3 +418,43 @@ void Processor :: Clock ( int clk )
 		while ( ch != 'q' && ch != 'n' && ch != 'c' );
 	}
 }
+
+// Redirects the thread of the branch in the last extra EX stage and
+// flushes that thread's instructions in the extra EX stages before it;
+// the flushStage loop clears EX, ID and the fetch.
+void Processor :: ResolveBranch ( int clk )
+{
+	Latch & branch = exTail[exExtra - 1];
+	int thread = branch.thread;
+	
+	cout << blue << "\n[** Clock: " << clk << " **] Branch at " << branch.PC
+		<< " resolved, fetching from " << branch.redirectPC 
+		<< reset << flush;
+	
+	for ( int i = 0; i < exExtra - 1; i++ )
+		if ( exTail[i].thread == thread && exTail[i].inst.iV != 0 )
+		{
+			ctx[thread].flushedInstructions ++;
+			exTail[i].Initialise ( );
+		}
+	if ( inLatch[2].thread == thread )
+		flushStage[2] = true;
+	if ( inLatch[1].thread == thread )
+		flushStage[1] = true;
+	if ( fetchThread == thread )
+		flushStage[0] = true;
+	
+	// The PC moves at once: with ID stalled on another thread, the clock
+	// would not take NPCreg now and the fetch would repeat the wrong path.
+	ctx[thread].PCreg = branch.redirectPC;
+	ctx[thread].NPCfrom = NOT_WRITTEN;
+	branch.redirect = false;
+}
+
+// Moves every instruction in a run of extra stages one stage on; the
+// caller has already copied out the last one and fills in the first.
+void Processor :: ShiftTail ( Latch * tail, int length )
+{
+	for ( int i = length - 1; i > 0; i-- )
+		LatchCopy ( tail[i], tail[i - 1] );
+}
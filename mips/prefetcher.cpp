@@ -0,0 +1,107 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "prefetcher.h"
+
+Prefetcher :: Prefetcher ( )
+{
+	Initialise ( PREFETCH_NONE, 0 );
+}
+
+void Prefetcher :: Initialise ( PrefetchKind k, int n )
+{
+	kind = k;
+	degree = ( n > 0 ) ? n : 1;
+	for ( int i = 0; i < STRIDE_TABLE_SIZE; i++ )
+		table[i].valid = false;
+}
+
+PrefetchKind Prefetcher :: Kind ( )
+{
+	return kind;
+}
+
+int Prefetcher :: Degree ( )
+{
+	return degree;
+}
+
+const char * Prefetcher :: Name ( PrefetchKind k )
+{
+	switch ( k )
+	{
+	case PREFETCH_NONE: return "none";
+	case PREFETCH_NEXT_LINE: return "next-N-line";
+	case PREFETCH_STRIDE: return "PC-indexed stride";
+	case PREFETCH_STREAM: return "stream buffer";
+	default: return "?";
+	};
+}
+
+int Prefetcher :: Candidates ( int blockTag, word_32 pc, bool trigger, int * out )
+{
+	int n = 0;
+	switch ( kind )
+	{
+	case PREFETCH_NEXT_LINE:
+		if ( trigger == true )
+			for ( int i = 1; i <= degree; i++ )
+				out[n++] = blockTag + i;
+		break;
+		
+	case PREFETCH_STRIDE:
+		{
+			Prefetcher_StrideEntry & e = table[( pc / 4 ) % STRIDE_TABLE_SIZE];
+			if ( e.valid == false || e.pc != pc )
+			{
+				e.valid = true;
+				e.pc = pc;
+				e.lastBlock = blockTag;
+				e.stride = 0;
+				e.confidence = 0;
+				break;
+			}
+			int stride = blockTag - e.lastBlock;
+			if ( stride == 0 ) break;	// Still in the same block
+			if ( stride == e.stride )
+			{
+				if ( e.confidence < STRIDE_CONFIDENCE ) e.confidence ++;
+			}
+			else
+			{
+				e.stride = stride;
+				e.confidence = 0;
+			}
+			e.lastBlock = blockTag;
+			if ( e.confidence >= STRIDE_CONFIDENCE )
+				for ( int i = 1; i <= degree; i++ )
+					if ( blockTag + i * stride >= 0 )
+						out[n++] = blockTag + i * stride;
+		}
+		break;
+		
+	default:	// The stream buffer is run by the cache
+		break;
+	};
+	return n;
+}
@@ -0,0 +1,69 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __PREFETCHER_H
+# define __PREFETCHER_H
+
+# include "../include/instruction.h"
+
+// Hardware prefetchers a SimpleCache may have.  The next-N-line and stride
+// prefetchers put the blocks they predict in the cache itself; a stream
+// buffer keeps them aside until a miss asks for one ( see SimpleCache ).
+enum PrefetchKind { PREFETCH_NONE, PREFETCH_NEXT_LINE, PREFETCH_STRIDE, 
+		PREFETCH_STREAM, NO_OF_PREFETCH_KINDS };
+
+# define STRIDE_TABLE_SIZE 64	// entries of the PC-indexed stride table
+# define STRIDE_CONFIDENCE 2	// repeats of a stride before it is trusted
+
+class Prefetcher_StrideEntry
+{
+public:
+	word_32 pc;
+	int lastBlock;
+	int stride;		// in blocks
+	int confidence;
+	bool valid;
+};
+
+class Prefetcher
+{
+private:
+	PrefetchKind kind;
+	int degree;	// lines ahead, or the depth of the stream buffer
+	Prefetcher_StrideEntry table[STRIDE_TABLE_SIZE];
+public:
+	Prefetcher ( );
+	void Initialise ( PrefetchKind k, int n );
+	
+	PrefetchKind Kind ( );
+	int Degree ( );
+	static const char * Name ( PrefetchKind k );
+	
+	// Called after every demand access to the block by the instruction at
+	// pc.  trigger is set on a miss and on the first use of a prefetched
+	// block.  Puts the blocks to prefetch in out ( room for Degree ( ) ),
+	// and returns how many.
+	int Candidates ( int blockTag, word_32 pc, bool trigger, int * out );
+};
+
+# endif
@@ -22,12 +22,14 @@
  */
 
 # include "processor.h"
+# include "multicore.h"
 
 # include <iostream>
 using std::cout;
 using std::flush;
 
 # include <cstdlib>
+# include <cstdio>
 
 # include <fcntl.h>
 # include <signal.h>
@@ -37,30 +39,74 @@ using std::flush;
 /**********************************************************************************
 **********************Constructor and Destructor functions************************/
 
-Processor :: Processor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm )
+void ThreadContext :: Initialise ( int threadNo, u_word_32 startAddress )
+{
+	for ( int i = 0; i < 32 ; i++ )
+		reg[i] = 0;
+	reg[REG_THREAD_ID] = threadNo;
+	Hi = Lo = 0;
+	
+	PCreg = startAddress;
+	NPCreg = startAddress;
+	NPCfrom = NOT_WRITTEN;
+	
+	retiredInstructions = 0;
+	idStallCycles = 0;
+	flushedInstructions = 0;
+}
+
+Processor :: Processor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm,
+		int threads, FetchPolicy policy, CoherenceBus * cb, MultiCore * sys, int core )
 {
 	mem = m;
 	dataCache = dc;
 	instrCache = ic;
+	storeBuffer = NULL;
+	scratchpad = NULL;
+	shadows = NULL;
 	pman = pm;
+	bus = ( cb != NULL ) ? cb : new CoherenceBus ( 4 );
+	system = sys;
+	coreId = core;
 	requestProgramTermination = false;
 	blockUpdate = false;
 	
-	for ( int i = 0; i < 32 ; i++ )
-		reg[i] = 0;
-	Hi = Lo = 0;
+	if ( threads < 1 ) threads = 1;
+	if ( threads > MAX_HW_THREADS ) threads = MAX_HW_THREADS;
+	noOfThreads = threads;
+	fetchThread = 0;
+	fetchPolicy = policy;
+	for ( int t = 0; t < MAX_HW_THREADS; t++ )
+		ctx[t].Initialise ( coreId * noOfThreads + t, SYSTEM_START_ADDRESS );
 	
 	for ( int i = 0; i < 5; i++ )
 	{
 		inLatch[i].Initialise ( );
 		outLatch[i].Initialise ( );
 		flushStage[i] = false;
+		stageDone[i] = false;
+	}
+	accessReadyAt = 0;
+	fetchReadyAt = -1;
+	fetchPC = 0;
+	fetchPendingThread = 0;
+	fetchInst = 0;
+	exExtra = memExtra = 0;
+	for ( int i = 0; i < MAX_SUBSTAGES - 1; i++ )
+	{
+		exTail[i].Initialise ( );
+		memTail[i].Initialise ( );
 	}
-	PCreg = SYSTEM_START_ADDRESS;
 	
 	continueCount = 0;
 	for ( int i = 0; i < BREAKPOINTARRAYSIZE; i++ )
 		breakPointArray[i] = -1;
+	
+	cycles = 0;
+	retiredInstructions = 0;
+	ifStallCycles = 0;
+	idStallCycles = 0;
+	memStallCycles = 0;
 }
 
 Processor :: ~Processor ( )
@@ -74,7 +120,11 @@ void Processor :: AtExit ( )
 		pthread_kill ( stagethread[i], SIGKILL );
 	
 	// Kill all the threads before closing semaphores.
-	
+	CloseSemaphores ( );
+}
+
+void Processor :: CloseSemaphores ( )
+{
 	for ( int i = 0; i < 5; i++ )
 	{
 		int stagesem_value;
@@ -106,13 +156,27 @@ void Processor :: AtExit ( )
 			<< pc_mutex_value << reset << flush;
 	sem_close ( pc_mutex );
 	
-	sem_unlink ( "/clocksem" );
-	sem_unlink ( "/stagesem1" );
-	sem_unlink ( "/stagesem2" );
-	sem_unlink ( "/stagesem3" );
-	sem_unlink ( "/stagesem4" );
-	sem_unlink ( "/stagesem5" );
-	sem_unlink ( "/pcmutex" );
+	char name[SEMNAMESIZE];
+	SemaphoreName ( name, "/clocksem" ); sem_unlink ( name );
+	SemaphoreName ( name, "/stagesem1" ); sem_unlink ( name );
+	SemaphoreName ( name, "/stagesem2" ); sem_unlink ( name );
+	SemaphoreName ( name, "/stagesem3" ); sem_unlink ( name );
+	SemaphoreName ( name, "/stagesem4" ); sem_unlink ( name );
+	SemaphoreName ( name, "/stagesem5" ); sem_unlink ( name );
+	SemaphoreName ( name, "/pcmutex" ); sem_unlink ( name );
+}
+
+void Processor :: SemaphoreName ( char * name, const char * base )
+{
+	if ( coreId == 0 )
+		std::snprintf ( name, SEMNAMESIZE, "%s", base );
+	else
+		std::snprintf ( name, SEMNAMESIZE, "%s_core%d", base, coreId );
+}
+
+int Processor :: LinkId ( int thread )
+{
+	return coreId * MAX_HW_THREADS + thread;
 }
 
 void Processor :: Terminate ( )
@@ -120,6 +184,201 @@ void Processor :: Terminate ( )
 	requestProgramTermination = true;
 }
 
+void Processor :: SetThreadStart ( int thread, u_word_32 address )
+{
+	if ( thread < 0 || thread >= noOfThreads ) return;
+	ctx[thread].PCreg = ctx[thread].NPCreg = address;
+}
+
+void Processor :: SetPipelineDepth ( int exStages, int memStages )
+{
+	if ( exStages < 1 ) exStages = 1;
+	if ( exStages > MAX_SUBSTAGES ) exStages = MAX_SUBSTAGES;
+	if ( memStages < 1 ) memStages = 1;
+	if ( memStages > MAX_SUBSTAGES ) memStages = MAX_SUBSTAGES;
+	exExtra = exStages - 1;
+	memExtra = memStages - 1;
+}
+
+void Processor :: SetStoreBuffer ( int entries )
+{
+	if ( entries > 0 )
+		storeBuffer = new StoreBuffer ( entries );
+}
+
+void Processor :: SetScratchpad ( Scratchpad * sp )
+{
+	scratchpad = sp;
+}
+
+void Processor :: SetShadows ( ShadowSet * s )
+{
+	if ( s != NULL && s -> Active ( ) )
+		shadows = s;
+}
+
+int Processor :: AccessSize ( int op )
+{
+	switch ( op )
+	{
+	case OP_LB: case OP_LBU: case OP_SB:
+		return 1;
+	case OP_LH: case OP_LHU: case OP_SH:
+		return 2;
+	default:
+		return 4;
+	};
+}
+
+const char * Processor :: MemOpName ( int op )
+{
+	switch ( op )
+	{
+	case OP_LB: return "LB";
+	case OP_LBU: return "LBU";
+	case OP_LH: return "LH";
+	case OP_LHU: return "LHU";
+	case OP_SB: return "SB";
+	case OP_SH: return "SH";
+	case OP_SW: return "SW";
+	default: return "LW";
+	};
+}
+
+word_32 Processor :: LoadValue ( int op, word_32 value )
+{
+	switch ( op )
+	{
+	case OP_LB:
+		return static_cast<signed char>( value & 0xff );
+	case OP_LBU:
+		return value & 0xff;
+	case OP_LH:
+		return static_cast<short>( value & 0xffff );
+	case OP_LHU:
+		return value & 0xffff;
+	default:
+		return value;
+	};
+}
+
+void Processor :: Statistics ( )
+{
+	cout << gray << "\nIn-order 5-stage core";
+	if ( system != NULL )
+		cout << " " << coreId;
+	if ( noOfThreads > 1 )
+		cout << ", " << noOfThreads << " hardware threads, "
+			<< ( fetchPolicy == FETCH_ROUND_ROBIN ? "round-robin" : "stall-aware" )
+			<< " fetch";
+	if ( exExtra > 0 || memExtra > 0 )
+		cout << ", " << 5 + exExtra + memExtra << " stages ( " 
+			<< 1 + exExtra << " EX, " << 1 + memExtra << " MEM )";
+	cout << "\n  Cycles                 : " << cycles
+		<< "\n  Instructions retired   : " << retiredInstructions;
+	if ( cycles > 0 )
+		cout << "\n  IPC                    : " 
+			<< static_cast<double>(retiredInstructions) / cycles;
+	cout << "\n  IF stall cycles        : " << ifStallCycles
+		<< "\n  ID stall cycles        : " << idStallCycles
+		<< "\n  MEM stall cycles       : " << memStallCycles;
+	
+	word_64 flushed = 0;
+	for ( int t = 0; t < noOfThreads; t++ )
+		flushed += ctx[t].flushedInstructions;
+	cout << "\n  Flushed instructions   : " << flushed;
+	
+	if ( noOfThreads > 1 )
+		for ( int t = 0; t < noOfThreads; t++ )
+		{
+			cout << "\n  Thread " << t << " : retired " << ctx[t].retiredInstructions;
+			if ( cycles > 0 )
+				cout << ", IPC " 
+					<< static_cast<double>(ctx[t].retiredInstructions) / cycles;
+			cout << ", ID stalls " << ctx[t].idStallCycles
+				<< ", flushed " << ctx[t].flushedInstructions;
+		}
+	cout << reset << flush;
+	
+	if ( storeBuffer != NULL )
+		storeBuffer -> Statistics ( );
+}
+
+void Processor :: CacheStatistics ( )
+{
+	if ( scratchpad != NULL )
+	{
+		cout << blue << "\nScratchpad Statistics : " << reset << flush;
+		scratchpad -> Statistics ( );
+	}
+	cout << blue << "\ndataCache Statistics : " 
+		<< reset << flush;
+	dataCache -> Statistics ( );
+	cout << blue << "\ninstrCache Statistics : " 
+		<< reset << flush;
+	instrCache -> Statistics ( );
+	if ( shadows != NULL )
+		shadows -> Statistics ( dataCache, instrCache, mem );
+}
+
+/*********************************************************************************
+*******************Hardware thread selection*************************************/
+
+// True if fetching from 'thread' in this clock would likely fetch an
+// instruction that gets flushed or that stalls in ID: the thread has a
+// load or a control transfer in ID, or a branch resolved by EX in EX or
+// in one of the extra EX stages, at whose end it is resolved.
+bool Processor :: ThreadMayStall ( int thread )
+{
+	if ( inLatch[1].thread == thread && inLatch[1].inst.iV != 0 )
+	{
+		switch ( inLatch[1].inst.noF.op )
+		{
+		case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+		case OP_LL: case OP_SC: case OP_DIN:
+		case OP_J: case OP_JAL: case OP_ONE: case OP_BEQ: case OP_BNE:
+		case OP_BGTZ: case OP_BLEZ:
+			return true;
+		case OP_ZERO:
+			switch ( inLatch[1].inst.rF.funct )
+			{
+			case FUNCT_RDIN: case FUNCT_JR: case FUNCT_JALR: case FUNCT_SYSCALL:
+				return true;
+			};
+			break;
+		};
+	}
+	for ( int i = -1; i < exExtra; i++ )
+	{
+		Latch & l = ( i < 0 ) ? inLatch[2] : exTail[i];
+		if ( l.thread != thread || l.inst.iV == 0 ) continue;
+		switch ( l.inst.noF.op )
+		{
+		case OP_BEQ: case OP_BNE:
+			return true;
+		case OP_ZERO:
+			if ( l.inst.rF.funct == FUNCT_JR ||
+					l.inst.rF.funct == FUNCT_JALR )
+				return true;
+			break;
+		};
+	}
+	return false;
+}
+
+int Processor :: NextFetchThread ( )
+{
+	if ( fetchPolicy == FETCH_STALL_AWARE )
+		for ( int i = 1; i <= noOfThreads; i++ )
+		{
+			int t = ( fetchThread + i ) % noOfThreads;
+			if ( ThreadMayStall ( t ) == false )
+				return t;
+		}
+	// Round robin, or every thread is likely to stall anyway.
+	return ( fetchThread + 1 ) % noOfThreads;
+}
+
 
 
 /*******************************************************************************
@@ -137,6 +396,7 @@ void* stage0 ( void * pobj )
 		sem_wait ( p -> stagesem[0] );
 		
 		p -> Stage0 ( );
+		p -> stageDone[0] = true;
 		
 		sem_post ( p -> clocksem );
 		
@@ -154,6 +414,7 @@ void* stage1 ( void * pobj )
 		sem_wait ( p -> stagesem[1] );
 		
 		p -> Stage1 ( );
+		p -> stageDone[1] = true;
 		
 		sem_post ( p -> clocksem );
 		
@@ -171,6 +432,7 @@ void* stage2 ( void * pobj )
 		sem_wait ( p -> stagesem[2] );
 		
 		p -> Stage2 ( );
+		p -> stageDone[2] = true;
 		
 		sem_post ( p -> clocksem );
 		
@@ -188,6 +450,7 @@ void* stage3 ( void * pobj )
 		sem_wait ( p -> stagesem[3] );
 		
 		p -> Stage3 ( );
+		p -> stageDone[3] = true;
 		
 		sem_post ( p -> clocksem );
 		
@@ -205,6 +468,7 @@ void* stage4 ( void * pobj )
 		sem_wait ( p -> stagesem[4] );
 		
 		p -> Stage4 ( );
+		p -> stageDone[4] = true;
 		
 		sem_post ( p -> clocksem );
 		
@@ -219,53 +483,62 @@ void* stage4 ( void * pobj )
 
 void Processor :: Execute ( )
 {
-	clocksem = sem_open ( "/clocksem", O_CREAT | O_EXCL, O_RDWR, 5 );
+	char name[SEMNAMESIZE];
+	
+	SemaphoreName ( name, "/clocksem" );
+	clocksem = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 5 );
 	if ( clocksem == NULL )
 	{
-		sem_unlink ( "/clocksem" );
-		clocksem = sem_open ( "/clocksem", O_CREAT, O_RDWR, 5 );
+		sem_unlink ( name );
+		clocksem = sem_open ( name, O_CREAT, O_RDWR, 5 );
 	}
 	
-	pc_mutex = sem_open ( "/pcmutex", O_CREAT | O_EXCL, O_RDWR, 1 );
+	SemaphoreName ( name, "/pcmutex" );
+	pc_mutex = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 1 );
 	if ( pc_mutex == NULL )
 	{
-		sem_unlink ( "/pcmutex" );
-		pc_mutex = sem_open ( "/pcmutex", O_CREAT, O_RDWR, 1 );
+		sem_unlink ( name );
+		pc_mutex = sem_open ( name, O_CREAT, O_RDWR, 1 );
 	}
 	
-	stagesem[0] = sem_open ( "/stagesem1", O_CREAT | O_EXCL, O_RDWR, 0 );
+	SemaphoreName ( name, "/stagesem1" );
+	stagesem[0] = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 0 );
 	if ( stagesem[0] == NULL )
 	{
-		sem_unlink ( "/stagesem1" );
-		stagesem[0] = sem_open ( "/stagesem1", O_CREAT, O_RDWR, 0 );
+		sem_unlink ( name );
+		stagesem[0] = sem_open ( name, O_CREAT, O_RDWR, 0 );
 	}
 	
-	stagesem[1] = sem_open ( "/stagesem2", O_CREAT | O_EXCL, O_RDWR, 0 );
+	SemaphoreName ( name, "/stagesem2" );
+	stagesem[1] = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 0 );
 	if ( stagesem[1] == NULL )
 	{
-		sem_unlink ( "/stagesem2" );
-		stagesem[1] = sem_open ( "/stagesem2", O_CREAT, O_RDWR, 0 );
+		sem_unlink ( name );
+		stagesem[1] = sem_open ( name, O_CREAT, O_RDWR, 0 );
 	}
 	
-	stagesem[2] = sem_open ( "/stagesem3", O_CREAT | O_EXCL, O_RDWR, 0 );
+	SemaphoreName ( name, "/stagesem3" );
+	stagesem[2] = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 0 );
 	if ( stagesem[2] == NULL )
 	{
-		sem_unlink ( "/stagesem3" );
-		stagesem[2] = sem_open ( "/stagesem3", O_CREAT, O_RDWR, 0 );
+		sem_unlink ( name );
+		stagesem[2] = sem_open ( name, O_CREAT, O_RDWR, 0 );
 	}
 	
-	stagesem[3] = sem_open ( "/stagesem4", O_CREAT | O_EXCL, O_RDWR, 0 );
+	SemaphoreName ( name, "/stagesem4" );
+	stagesem[3] = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 0 );
 	if ( stagesem[3] == NULL )
 	{
-		sem_unlink ( "/stagesem4" );
-		stagesem[3] = sem_open ( "/stagesem4", O_CREAT, O_RDWR, 0 );
+		sem_unlink ( name );
+		stagesem[3] = sem_open ( name, O_CREAT, O_RDWR, 0 );
 	}
 	
-	stagesem[4] = sem_open ( "/stagesem5", O_CREAT | O_EXCL, O_RDWR, 0 );
+	SemaphoreName ( name, "/stagesem5" );
+	stagesem[4] = sem_open ( name, O_CREAT | O_EXCL, O_RDWR, 0 );
 	if ( stagesem[4] == NULL )
 	{
-		sem_unlink ( "/stagesem5" );
-		stagesem[4] = sem_open ( "/stagesem5", O_CREAT, O_RDWR, 0 );
+		sem_unlink ( name );
+		stagesem[4] = sem_open ( name, O_CREAT, O_RDWR, 0 );
 	}
 	
 	if ( clocksem == NULL || pc_mutex == NULL || stagesem[0] == NULL ||
@@ -297,6 +570,10 @@ void Processor :: ExecutionThread ( )
 		Clock( clock_count ++ );
 		// Note that clock count is incremented
 		
+		if ( system != NULL )
+			system -> Barrier ( clock_count );
+			// Keeps the cores within a quantum of each other.
+		
 		for ( int i = 0; i < 5; i++ )
 			sem_post ( stagesem[i] );
 	
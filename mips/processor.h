@@ -27,6 +27,10 @@
 # include "memory.h"
 # include "portmanager.h"
 # include "latch.h"
+# include "coherence_bus.h"
+# include "store_buffer.h"
+# include "scratchpad.h"
+# include "shadow.h"
 # include "../include/opcodes.h"
 
 # include <pthread.h>
@@ -40,9 +44,31 @@
 
 # define BREAKPOINTARRAYSIZE 16
 
-class Processor
+# define MAX_HW_THREADS 4
+# define REG_THREAD_ID 26	// $k0 holds the hardware thread number at start
+				// ( numbered across all the cores )
+
+# define SEMNAMESIZE 32
+
+// The EX and MEM stages may each be split into up to MAX_SUBSTAGES
+// pipeline stages.  The stage threads do the work in the first one, the
+// others only carry the instruction along; the result counts as ready
+// at the end of the last one.
+# define MAX_SUBSTAGES 4
+
+// Outcome of looking for a register in the extra EX or MEM stages.
+enum TailForward { TAIL_NONE, TAIL_FORWARDED, TAIL_UNAVAILABLE };
+
+class MultiCore;
+
+// How Stage0 picks the hardware thread to fetch from in each clock.
+enum FetchPolicy { FETCH_ROUND_ROBIN, FETCH_STALL_AWARE };
+
+// The architectural state of one hardware thread.  All threads share
+// the pipeline, the caches and the memory.
+class ThreadContext
 {
-private:
+public:
 	word_32 reg[32];
 	word_32 Hi, Lo;		// numbers REG_HI & REG_LO will be used to 
 				// address these registers
@@ -51,14 +77,50 @@ private:
 	u_word_32 NPCreg;
 	PCWritingStage NPCfrom;
 	
+	// Per thread statistics
+	word_64 retiredInstructions;
+	word_64 idStallCycles;		// clocks this thread's instruction sat in ID
+	word_64 flushedInstructions;	// fetched on a wrong path and discarded
+	
+	void Initialise ( int threadNo, u_word_32 startAddress );
+};
+
+class Processor
+{
+private:
+	ThreadContext ctx[MAX_HW_THREADS];
+	int noOfThreads;
+	int fetchThread;	// The thread Stage0 fetches from in this clock
+	FetchPolicy fetchPolicy;
+	
 	bool flushStage[5];
+	bool stageDone[5];	// set when the stage thread is through for this clock
 	
 	MainMemory * mem;
 	Cache * dataCache;
 	Cache * instrCache;
+	StoreBuffer * storeBuffer;	// NULL if stores write the cache in MEM
+	Scratchpad * scratchpad;	// NULL if there is none
+	ShadowSet * shadows;		// likewise
+	
+	// Cache timing.  The caches carry out every access at once and report
+	// when it completes; Stage3 and Stage0 hold their instruction until
+	// then.  A fetch that is waited for is dropped if the thread's PC moves.
+	int accessReadyAt;	// completion clock of ReadMem / WriteMem / StoreMem
+	bool MemoryDone ( bool started );
+	int fetchReadyAt;	// -1 if no fetch is outstanding
+	u_word_32 fetchPC;
+	int fetchPendingThread;
+	word_32 fetchInst;
 	
 	PortManager * pman;
 	
+	// Multi-core support.  Every core has a bus, which holds the LL/SC
+	// links; a lone core simply owns one with no caches attached.
+	CoherenceBus * bus;
+	MultiCore * system;	// NULL when running as the only core
+	int coreId;
+	
 	Latch inLatch [5];
 	Latch outLatch [5];
 	/** 
@@ -67,6 +129,19 @@ private:
 	 * use.
 	**/
 	
+	// The extra EX stages sit between outLatch[2] and inLatch[3], the 
+	// extra MEM stages between outLatch[3] and inLatch[4].  Index 0 is
+	// the youngest.
+	Latch exTail [MAX_SUBSTAGES - 1];
+	Latch memTail [MAX_SUBSTAGES - 1];
+	int exExtra, memExtra;		// number of extra stages in use
+	
+	TailForward ForwardFromTail ( Latch * tail, int length, bool memStages,
+		int thread, int regNumber, word_32 & value );
+	bool FetchUnavailable ( RegisterFetchTarget target, bool noFail );
+	void ShiftTail ( Latch * tail, int length );
+	void ResolveBranch ( int clk );	// see Clock ( )
+	
 	// NOTE: The following booleans are flags...
 	bool blockUpdate;	// This is set when mem/reg updates should no
 				// longer be allowed to happen.
@@ -81,23 +156,60 @@ private:
 	sem_t * stagesem[5];
 	sem_t * pc_mutex;
 	
+	// Core 0 uses the plain semaphore names, other cores append their id.
+	void SemaphoreName ( char * name, const char * base );
+	
 	// The following variables are used for the stepping 
 	// and controlling the execution of the user program
 	// on our simulated processor.
 	int continueCount;
 	word_32 breakPointArray[BREAKPOINTARRAYSIZE];
+	
+	// Statistics, shown by the 's' command along with the caches.
+	int cycles;			// updated by Clock ( )
+	word_64 retiredInstructions;	// non-NOP instructions past Stage4
+	word_64 ifStallCycles;		// clocks lost to a failed fetch
+	word_64 idStallCycles;		// clocks lost to an ID stall
+	word_64 memStallCycles;		// clocks MEM held its instruction
+	
+	// Picks the thread to fetch from after the pipeline advanced.
+	int NextFetchThread ( );
+	bool ThreadMayStall ( int thread );
 public:
 	//bool SingleStep;  // TODO
 	//bool Pause;       // TODO
 
 	// TODO Cleanup so that comments are always before what they document
-	Processor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm );
+	Processor ( MainMemory * m, Cache * dc, Cache * ic, PortManager * pm,
+		int threads = 1, FetchPolicy policy = FETCH_ROUND_ROBIN,
+		CoherenceBus * cb = NULL, MultiCore * sys = NULL, int core = 0 );
 	~Processor ( );  // calls AtExit (); note that this destructor is never invoked.
 	void AtExit ( ); // Destroys the threads.
 	
 	void Terminate ( ); // Oversees Termination of program in case of error.
 	
+	// Makes a thread start at the entry point of its own program image,
+	// instead of at SYSTEM_START_ADDRESS.  Call before Execute ( ).
+	void SetThreadStart ( int thread, u_word_32 address );
+	
+	// Splits EX and MEM into the given number of stages ( 1 to 
+	// MAX_SUBSTAGES each ).  Call before Execute ( ).
+	void SetPipelineDepth ( int exStages, int memStages );
+	
+	// Puts a store buffer of the given size between Stage3 and the data
+	// cache ( 0 for none ).  Call before Execute ( ).
+	void SetStoreBuffer ( int entries );
+	
+	// Gives the core a scratchpad, which loads and stores reach ahead of
+	// the data cache and the store buffer.  Call before Execute ( ).
+	void SetScratchpad ( Scratchpad * sp );
+	
+	// Shows the shadow hierarchies every access that reaches this core's
+	// caches.  Call before Execute ( ).
+	void SetShadows ( ShadowSet * s );
+	
 	void Execute ( ); // Creates the threads and starts ExecutionThread
+	void CloseSemaphores ( ); // Closes and unlinks this core's semaphores
 	void ExecutionThread ( );
 		// Manages the clock for the processor.
 		// Executes the oneClock ( ) function within an infinite loop.
@@ -120,16 +232,42 @@ public:
 	// The foll two functions provide a simple abstraction for memory access.
 	// also can be used to aid in preventing memory write when 
 	// implementing hardware exceptions...
-	bool ReadMem ( word_32 address, word_32 & result, int noOfBytes );
+	bool ReadMem ( word_32 address, word_32 & result, int noOfBytes,
+		int thread = 0 );
 	bool WriteMem ( word_32 address, word_32 value, int noOfBytes );
 	
+	// SW goes through StoreMem, which uses the store buffer if there is
+	// one; WriteMem always writes the cache ( SC needs that ).
+	bool StoreMem ( word_32 address, word_32 value, int noOfBytes, int thread );
+	void DrainStoreBuffer ( );	// Called once every clock
+	
 	// Abstracts away the process of updating the NPC register.
 	void UpdatePC_Stage1 ( word_32 value, PCUpdateType updateType );
 	void UpdatePC_Stage2 ( word_32 value, PCUpdateType updateType );
 	
 	// Critical section in the above two functions...
 	// Also used by stage 0 to update pc.
-	void PC_update_control ( word_32 value, int stage );
+	void PC_update_control ( word_32 value, int stage, int thread );
+	
+	// Loads and stores of bytes, half words and words: the bytes each
+	// accesses, its mnemonic, and the register value a load gives for
+	// what it read ( sign or zero extended ).
+	static int AccessSize ( int op );
+	static const char * MemOpName ( int op );
+	static word_32 LoadValue ( int op, word_32 value );
+	
+	// Prints cycles, retired instructions and IPC, per thread and overall.
+	void Statistics ( );
+	void CacheStatistics ( );	// ... and those of this core's caches
+	
+	// Identifies the hardware thread holding an LL/SC link on the bus.
+	int LinkId ( int thread );
+	
+	// The data cache's lock, then the bus lock, held over LL, SC and the
+	// store buffer's drain.  Always in that order: a page walk holds the
+	// first while its reads through the data cache take the second.
+	void LockMemory ( );
+	void UnlockMemory ( );
 	
 	// Each of the following is spawned as different
 	// threads by the constructor of this class.
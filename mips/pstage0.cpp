@@ -39,16 +39,47 @@ void Processor :: Stage0 ( )
 	// Note the invariant that inLatch[0] is a constant for all practical 
 	// purposes.
 	
-	if ( instrCache -> Read ( PCreg, outLatch[0].inst.iV, 4 ) == true )
+	u_word_32 PCreg = ctx[fetchThread].PCreg;
+	
+	// A fetch still in flight for another PC is dropped; the instruction
+	// cache stays busy with it all the same.
+	if ( fetchReadyAt != -1 && 
+			( fetchPC != PCreg || fetchPendingThread != fetchThread ) )
+		fetchReadyAt = -1;
+	if ( fetchReadyAt == -1 )
 	{
+		instrCache -> SetPC ( PCreg );
+		fetchReadyAt = instrCache -> TimedRead ( PCreg, fetchInst, 4, cycles );
+		if ( shadows != NULL && fetchReadyAt != -1 )
+			shadows -> Record ( SHADOW_SOURCE_FETCH, SHADOW_FETCH, PCreg, 0, 4, 
+				PCreg, cycles );
+		fetchPC = PCreg;
+		fetchPendingThread = fetchThread;
+	}
+	
+	if ( fetchReadyAt != -1 && cycles >= fetchReadyAt )
+	{
+		fetchReadyAt = -1;
+		outLatch[0].inst.iV = fetchInst;
 		outLatch[0].PC = PCreg;
+		outLatch[0].thread = fetchThread;
 	
-		PC_update_control ( PCreg + 4, 0 );
+		PC_update_control ( PCreg + 4, 0, fetchThread );
 	
 		outLatch[0].finished = true;
 		sem_wait ( cout_mutex );
 		cout << "\n[ Stage0 ] PC to fetch = " << PCreg << ", Instruction = " 
-			<< outLatch[0].inst.iV << flush;
+			<< outLatch[0].inst.iV;
+		if ( noOfThreads > 1 ) cout << ", Thread = " << fetchThread;
+		cout << flush;
+		sem_post ( cout_mutex );
+	}
+	else if ( fetchReadyAt != -1 )
+	{
+		outLatch[0].finished = false;
+		sem_wait ( cout_mutex );
+		cout << gray << "\n[ Stage0 ] PC fetch waits for memory till clock "
+			<< fetchReadyAt << reset << flush;
 		sem_post ( cout_mutex );
 	}
 	else
@@ -61,8 +92,11 @@ void Processor :: Stage0 ( )
 	}
 }
 
-void Processor :: PC_update_control ( word_32 value, int stage )
+void Processor :: PC_update_control ( word_32 value, int stage, int thread )
 {
+	u_word_32 & NPCreg = ctx[thread].NPCreg;
+	PCWritingStage & NPCfrom = ctx[thread].NPCfrom;
+	
 	sem_wait ( pc_mutex );
 	
 	switch ( stage )
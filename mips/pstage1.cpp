@@ -758,7 +758,7 @@ void Processor :: Stage1 ( )
 		sem_post ( cout_mutex );
 		break;
 		
-	case OP_LW:
+	case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
 		outLatch[1].resultStage = RESULT_AT_MEM;
 
 		outLatch[1].Imm = outLatch[1].inst.iF.imm;
@@ -769,13 +769,14 @@ void Processor :: Stage1 ( )
 		outLatch[1].targReg = outLatch[1].inst.iF.rt;
 
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage1 ] LW Memory[" << outLatch[1].inst.iF.imm
+		cout << "\n[ Stage1 ] " << MemOpName ( outLatch[1].inst.iF.op )
+			<< " Memory[" << outLatch[1].inst.iF.imm
 			<< " + (r"<< outLatch[1].inst.iF.rs << ")] -> r"
 			<< outLatch[1].inst.iF.rt << flush;
 		sem_post ( cout_mutex );
 		break;
 	
-	case OP_SW:
+	case OP_SW: case OP_SB: case OP_SH:
 		outLatch[1].resultStage = NORESULT;
 		
 		// Note that here rt contains the source and rs the destination
@@ -790,12 +791,50 @@ void Processor :: Stage1 ( )
 		else outLatch[1].finished = false;	// Not necessary.
 		
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage1 ] SW Memory[" << outLatch[1].inst.iF.imm
+		cout << "\n[ Stage1 ] " << MemOpName ( outLatch[1].inst.iF.op )
+			<< " Memory[" << outLatch[1].inst.iF.imm
 			<< " + (r"<< outLatch[1].inst.iF.rs << ")] <- r"
 			<< outLatch[1].inst.iF.rt << flush;
 		sem_post ( cout_mutex );
 		break;
 		
+	case OP_LL:
+		outLatch[1].resultStage = RESULT_AT_MEM;
+
+		outLatch[1].Imm = outLatch[1].inst.iF.imm;
+		if ( RegisterFetch ( ALU_A, outLatch[1].inst.iF.rs ) )
+			outLatch[1].finished = true;
+		else outLatch[1].finished = false;	// Not necessary.
+
+		outLatch[1].targReg = outLatch[1].inst.iF.rt;
+
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage1 ] LL Memory[" << outLatch[1].inst.iF.imm
+			<< " + (r"<< outLatch[1].inst.iF.rs << ")] -> r"
+			<< outLatch[1].inst.iF.rt << " and link" << flush;
+		sem_post ( cout_mutex );
+		break;
+	
+	case OP_SC:
+		// Like SW, except that rt also receives the outcome ( 1 if 
+		// stored, 0 if the link was broken ), which is known in MEM.
+		outLatch[1].resultStage = RESULT_AT_MEM;
+		
+		outLatch[1].Imm = outLatch[1].inst.iF.imm;
+		if ( RegisterFetch ( ALU_A, outLatch[1].inst.iF.rs ) &&
+			RegisterFetch ( ALU_B, outLatch[1].inst.iF.rt, true ) )
+			outLatch[1].finished = true;
+		else outLatch[1].finished = false;	// Not necessary.
+		
+		outLatch[1].targReg = outLatch[1].inst.iF.rt;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage1 ] SC Memory[" << outLatch[1].inst.iF.imm
+			<< " + (r"<< outLatch[1].inst.iF.rs << ")] <- r"
+			<< outLatch[1].inst.iF.rt << " if linked" << flush;
+		sem_post ( cout_mutex );
+		break;
+		
 	case OP_DIN:
 		outLatch[1].resultStage = RESULT_AT_MEM;
 		
@@ -833,6 +872,14 @@ void Processor :: Stage1 ( )
 bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, bool noFail )
 {
 	word_32 fetchResult;
+	int thread = outLatch[1].thread;	// Only forward within the same thread
+	
+	word_32 exTailValue = 0, memTailValue = 0;
+	TailForward exTailResult = ForwardFromTail ( exTail, exExtra, false,
+		thread, regNumber, exTailValue );
+	TailForward memTailResult = ForwardFromTail ( memTail, memExtra, true,
+		thread, regNumber, memTailValue );
+	
 	if ( regNumber == 0 )
 	{
 		sem_wait ( cout_mutex );
@@ -841,7 +888,8 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 		sem_post ( cout_mutex );
 		fetchResult = 0;
 	}
-	else if ( inLatch[2].targReg == regNumber && inLatch[2].resultStage == RESULT_AT_ID)
+	else if ( inLatch[2].thread == thread
+			&& inLatch[2].targReg == regNumber && inLatch[2].resultStage == RESULT_AT_ID)
 	{
 		sem_wait ( cout_mutex );
 		cout << violet << "\n[ Stage1:RegisterFetch ] Result from current EX-IDRes" 
@@ -849,30 +897,19 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 		sem_post ( cout_mutex );
 		fetchResult = inLatch[2].IDRes;
 	}
-	else if ( ( inLatch[2].targReg == regNumber || inLatch[2].targReg2 == regNumber )
+	else if ( inLatch[2].thread == thread
+			&& ( inLatch[2].targReg == regNumber || inLatch[2].targReg2 == regNumber )
 			&& inLatch[2].resultStage == RESULT_AT_MEM )
 	{
-		sem_wait ( cout_mutex );
-		cout << violet << "\n[ Stage1:RegisterFetch ] Result unavailable" 
-			<< reset << flush;
-		sem_post ( cout_mutex );
-		if ( noFail == false )
-			return false;	// Will only get result in next clock
-		else 
-		{
-			sem_wait ( cout_mutex );
-			cout << violet << "\n[ Stage1:RegisterFetch ] " 
-				<< "will forward while in Stage2"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-			outLatch[1].dataFetchIncomplete = true;
-			outLatch[1].FetchFailedFor = target;
-			return true;
-		}
+		return FetchUnavailable ( target, noFail );
 	}
-	else if ( ( inLatch[2].targReg == regNumber || inLatch[2].targReg2 == regNumber )
+	else if ( inLatch[2].thread == thread
+			&& ( inLatch[2].targReg == regNumber || inLatch[2].targReg2 == regNumber )
 			&& inLatch[2].resultStage == RESULT_AT_EX )
 	{
+		if ( exExtra > 0 )	// Computed only at the end of the last EX stage
+			return FetchUnavailable ( target, noFail );
+		
 		// Have to wait till result has been computed
 		while ( outLatch[2].finished == false )
 			sched_yield ( );	
@@ -897,7 +934,20 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 			fetchResult = outLatch[2].ALUOutputHi;
 		}
 	}
-	else if ( inLatch[3].targReg == regNumber 
+	else if ( exTailResult == TAIL_UNAVAILABLE )
+	{
+		return FetchUnavailable ( target, noFail );
+	}
+	else if ( exTailResult == TAIL_FORWARDED )
+	{
+		sem_wait ( cout_mutex );
+		cout << violet << "\n[ Stage1:RegisterFetch ] Result from an extra EX stage" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		fetchResult = exTailValue;
+	}
+	else if ( inLatch[3].thread == thread
+			&& inLatch[3].targReg == regNumber 
 			&& inLatch[3].resultStage == RESULT_AT_ID )
 	{
 		sem_wait ( cout_mutex );
@@ -907,7 +957,8 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 		sem_post ( cout_mutex );
 		fetchResult = inLatch[3].IDRes;
 	}
-	else if ( ( inLatch[3].targReg == regNumber || inLatch[3].targReg2 == regNumber )
+	else if ( inLatch[3].thread == thread
+			&& ( inLatch[3].targReg == regNumber || inLatch[3].targReg2 == regNumber )
 			&& inLatch[3].resultStage == RESULT_AT_EX )
 	{
 		// result has already been computed in the previous clock
@@ -930,13 +981,19 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 			fetchResult = inLatch[3].ALUOutputHi;
 		}
 	}
-	else if ( inLatch[3].targReg == regNumber 
+	else if ( inLatch[3].thread == thread
+			&& inLatch[3].targReg == regNumber 
 			&& inLatch[3].resultStage == RESULT_AT_MEM )
 	{
+		if ( memExtra > 0 )	// Loaded only at the end of the last MEM stage
+			return FetchUnavailable ( target, noFail );
+		
 		// Have to wait till result has been computed
-		while ( outLatch[3].finished == false )
+		while ( stageDone[3] == false )
 			sched_yield ( );	
 				// Relinquish processor instead of busywaiting.
+		if ( outLatch[3].finished == false )	// Still waiting for memory
+			return FetchUnavailable ( target, noFail );
 		
 		sem_wait ( cout_mutex );
 		cout << violet << "\n[ Stage1:RegisterFetch ]"
@@ -945,6 +1002,18 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 		sem_post ( cout_mutex );
 		fetchResult = outLatch[3].LMD;
 	}
+	else if ( memTailResult == TAIL_UNAVAILABLE )
+	{
+		return FetchUnavailable ( target, noFail );
+	}
+	else if ( memTailResult == TAIL_FORWARDED )
+	{
+		sem_wait ( cout_mutex );
+		cout << violet << "\n[ Stage1:RegisterFetch ] Result from an extra MEM stage" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		fetchResult = memTailValue;
+	}
 	else	// first wait for write register stage to complete, then read the register
 	{
 		while ( outLatch[4].finished == false )
@@ -959,13 +1028,13 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 		switch ( regNumber )
 		{
 		case REG_LO:
-			fetchResult = Lo;
+			fetchResult = ctx[thread].Lo;
 			break;
 		case REG_HI:
-			fetchResult = Hi;
+			fetchResult = ctx[thread].Hi;
 			break;
 		default:
-			fetchResult = reg[regNumber];
+			fetchResult = ctx[thread].reg[regNumber];
 			break;
 		};
 	}
@@ -997,86 +1066,109 @@ bool Processor :: RegisterFetch ( RegisterFetchTarget target, int regNumber, boo
 	return true;
 }
 
-void Processor :: UpdatePC_Stage1 ( word_32 value, PCUpdateType updateType )
+// An instruction in an extra EX stage has its ALU result only once it
+// reaches the last one, and no load data yet.  One in an extra MEM stage
+// has its ALU result, and its load data once it reaches the last one.
+TailForward Processor :: ForwardFromTail ( Latch * tail, int length, bool memStages,
+	int thread, int regNumber, word_32 & value )
 {
-	switch ( updateType )
+	for ( int i = 0; i < length; i++ )	// youngest first
 	{
-	case PC_ABSOLUTE:
-		if ( PCreg == value )
+		Latch & l = tail[i];
+		if ( l.thread != thread || l.inst.iV == 0 ) continue;
+		bool last = ( i == length - 1 );
+		
+		if ( l.targReg == regNumber && l.resultStage == RESULT_AT_ID )
 		{
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage1:UpdatePC ]"
-				<< " instruction already in IF stage"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-			return;
+			value = l.IDRes;
+			return TAIL_FORWARDED;
 		}
-		else
+		if ( ( l.targReg == regNumber || l.targReg2 == regNumber )
+				&& l.resultStage == RESULT_AT_EX )
 		{
-			while ( outLatch[2].finished == false )
-				sched_yield ( );
-			sem_wait ( pc_mutex );
-			if ( flushStage[1] == true )
-			{
-				sem_wait ( cout_mutex );
-				cout << skyblue << "\n[ Stage1:UpdatePC ]"
-					<< " this stage was flushed by"
-					<< " stage2, disallowing execution" 
-					<< reset << flush;
-				sem_post ( cout_mutex );
-				
-				sem_post ( pc_mutex );
-				return;
-			}
-			sem_post ( pc_mutex );
-			flushStage[0] = true;
-			PC_update_control ( value, 1 );
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage1:UpdatePC ]"
-				<< " updated NPC with absolute address"
-				<< reset << flush;
-			sem_post ( cout_mutex );
+			if ( memStages == false && last == false )
+				return TAIL_UNAVAILABLE;
+			value = ( l.targReg == regNumber ) ? l.ALUOutput : l.ALUOutputHi;
+			return TAIL_FORWARDED;
 		}
-		break;
-	case PC_RELATIVE:
-		value = value + PCreg;
-		if ( PCreg == value )
+		if ( l.targReg == regNumber && l.resultStage == RESULT_AT_MEM )
 		{
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage1:UpdatePC ]"
-				<< " instruction already in IF stage"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-			return;
+			if ( memStages == false || last == false )
+				return TAIL_UNAVAILABLE;
+			value = l.LMD;
+			return TAIL_FORWARDED;
 		}
-		else
-		{
-			while ( outLatch[2].finished == false )
-				sched_yield ( );
-			sem_wait ( pc_mutex );
-			if ( flushStage[1] == true )
-			{
-				sem_wait ( cout_mutex );
-				cout << skyblue << "\n[ Stage1:UpdatePC ]"
-					<< " this stage was flushed by"
-					<< " stage2, disallowing execution" 
-					<< reset << flush;
-				sem_post ( cout_mutex );
-				
-				sem_post ( pc_mutex );
-				return;
-			}
-			sem_post ( pc_mutex );
-			flushStage[0] = true;
-			PC_update_control ( value, 1 );
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage1:UpdatePC ]"
-				<< " updated NPC with relative address"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-		break;
-	};
+	}
+	return TAIL_NONE;
+}
+
+// The result the ID stage needs will not be ready by the end of this clock.
+// In the 5-stage pipeline, an instruction that needs the value only in 
+// MEM may go ahead and pick it up from MEM while in EX; with extra stages
+// that is no longer one clock away, so it simply waits in ID.
+bool Processor :: FetchUnavailable ( RegisterFetchTarget target, bool noFail )
+{
+	sem_wait ( cout_mutex );
+	cout << violet << "\n[ Stage1:RegisterFetch ] Result unavailable" 
+		<< reset << flush;
+	sem_post ( cout_mutex );
+	if ( noFail == false || exExtra > 0 || memExtra > 0 )
+		return false;	// Will only get result in a later clock
+	
+	sem_wait ( cout_mutex );
+	cout << violet << "\n[ Stage1:RegisterFetch ] " 
+		<< "will forward while in Stage2"
+		<< reset << flush;
+	sem_post ( cout_mutex );
+	outLatch[1].dataFetchIncomplete = true;
+	outLatch[1].FetchFailedFor = target;
+	return true;
+}
+
+void Processor :: UpdatePC_Stage1 ( word_32 value, PCUpdateType updateType )
+{
+	// With several hardware threads, Stage0 may be fetching for another
+	// thread.  Only the fetch of this instruction's own thread is flushed,
+	// and relative targets are taken from this instruction's PC.
+	int thread = outLatch[1].thread;
+	
+	if ( updateType == PC_RELATIVE )
+		value = value + outLatch[1].PC + 4;
+	
+	if ( ctx[thread].PCreg == static_cast<u_word_32>(value) )
+	{
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage1:UpdatePC ]"
+			<< " instruction already in IF stage"
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return;
+	}
+	
+	while ( outLatch[2].finished == false )
+		sched_yield ( );
+	sem_wait ( pc_mutex );
+	if ( flushStage[1] == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage1:UpdatePC ]"
+			<< " this stage was flushed by"
+			<< " stage2, disallowing execution" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		
+		sem_post ( pc_mutex );
+		return;
+	}
+	sem_post ( pc_mutex );
+	if ( fetchThread == thread )
+		flushStage[0] = true;
+	PC_update_control ( value, 1, thread );
+	
+	sem_wait ( cout_mutex );
+	cout << skyblue << "\n[ Stage1:UpdatePC ]"
+		<< ( updateType == PC_ABSOLUTE ? " updated NPC with absolute address"
+			: " updated NPC with relative address" )
+		<< reset << flush;
+	sem_post ( cout_mutex );
 }
@@ -480,17 +480,17 @@ void Processor :: Stage2 ( )
 		sem_post ( cout_mutex );
 		break;
 		
-	case OP_LW:
+	case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
 		outLatch[2].ALUOutput = outLatch[2].A + outLatch[2].Imm;
 		outLatch[2].finished = true;
 		
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage2 ] LW ALUOutput / Memory address = " 
+		cout << "\n[ Stage2 ] " << MemOpName ( outLatch[2].inst.iF.op ) << " ALUOutput / Memory address = " 
 			<< outLatch[2].ALUOutput << flush;
 		sem_post ( cout_mutex );
 		break;
 		
-	case OP_SW:
+	case OP_SW: case OP_SB: case OP_SH:
 		outLatch[2].ALUOutput = outLatch[2].A + outLatch[2].Imm;
 		if ( outLatch[2].dataFetchIncomplete == true )
 		{
@@ -502,7 +502,34 @@ void Processor :: Stage2 ( )
 		else outLatch[2].finished = true;
 		
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage2 ] SW ALUOutput / Memory address = "
+		cout << "\n[ Stage2 ] " << MemOpName ( outLatch[2].inst.iF.op ) << " ALUOutput / Memory address = "
+			<< outLatch[2].ALUOutput << flush;
+		sem_post ( cout_mutex );
+		break;
+		
+	case OP_LL:
+		outLatch[2].ALUOutput = outLatch[2].A + outLatch[2].Imm;
+		outLatch[2].finished = true;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage2 ] LL ALUOutput / Memory address = " 
+			<< outLatch[2].ALUOutput << flush;
+		sem_post ( cout_mutex );
+		break;
+		
+	case OP_SC:
+		outLatch[2].ALUOutput = outLatch[2].A + outLatch[2].Imm;
+		if ( outLatch[2].dataFetchIncomplete == true )
+		{
+			if ( RegisterFetch_Stage2 ( ALU_B, outLatch[2].inst.iF.rt )
+					== true )
+				outLatch[2].finished = true;
+			else outLatch[2].finished = false;
+		}
+		else outLatch[2].finished = true;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage2 ] SC ALUOutput / Memory address = "
 			<< outLatch[2].ALUOutput << flush;
 		sem_post ( cout_mutex );
 		break;
@@ -536,6 +563,7 @@ void Processor :: Stage2 ( )
 bool Processor :: RegisterFetch_Stage2 ( RegisterFetchTarget target, int regNumber )
 {
 	word_32 fetchResult;
+	int thread = outLatch[2].thread;	// Only forward within the same thread
 	
 	// Please note that many of the cases have been commented out because,
 	// as per our design, these will never happen,  as all possible fetches
@@ -553,7 +581,8 @@ bool Processor :: RegisterFetch_Stage2 ( RegisterFetchTarget target, int regNumb
 		sem_post ( cout_mutex );
 		fetchResult = 0;
 	}	
-	else if ( inLatch[3].targReg == regNumber 
+	else if ( inLatch[3].thread == thread
+			&& inLatch[3].targReg == regNumber 
 			&& inLatch[3].resultStage == RESULT_AT_ID )
 	{
 		sem_wait ( cout_mutex );
@@ -563,7 +592,8 @@ bool Processor :: RegisterFetch_Stage2 ( RegisterFetchTarget target, int regNumb
 		sem_post ( cout_mutex );
 		fetchResult = inLatch[3].IDRes;
 	}
-	else if ( ( inLatch[3].targReg == regNumber || inLatch[3].targReg2 == regNumber )
+	else if ( inLatch[3].thread == thread
+			&& ( inLatch[3].targReg == regNumber || inLatch[3].targReg2 == regNumber )
 			&& inLatch[3].resultStage == RESULT_AT_EX )
 	{
 		// result has already been computed in the previous clock
@@ -586,13 +616,16 @@ bool Processor :: RegisterFetch_Stage2 ( RegisterFetchTarget target, int regNumb
 			fetchResult = inLatch[3].ALUOutputHi;
 		}
 	}
-	else*/ if ( inLatch[3].targReg == regNumber 
+	else*/ if ( inLatch[3].thread == thread
+			&& inLatch[3].targReg == regNumber 
 			&& inLatch[3].resultStage == RESULT_AT_MEM )
 	{
 		// Have to wait till result has been computed
-		while ( outLatch[3].finished == false )
+		while ( stageDone[3] == false )
 			sched_yield ( );	
 				// Relinquish processor instead of busywaiting.
+		if ( outLatch[3].finished == false )	// Still waiting for memory
+			return false;
 		
 		sem_wait ( cout_mutex );
 		cout << violet << "\n[ Stage2:RegisterFetch ]"
@@ -659,79 +692,63 @@ bool Processor :: RegisterFetch_Stage2 ( RegisterFetchTarget target, int regNumb
 
 void Processor :: UpdatePC_Stage2 ( word_32 value, PCUpdateType updateType )
 {
-	switch ( updateType )
+	// As in UpdatePC_Stage1, only the stages holding this instruction's
+	// own thread are flushed.
+	int thread = outLatch[2].thread;
+	
+	if ( updateType == PC_RELATIVE )
+		value = value + outLatch[2].PC + 4;
+	
+	// With extra EX stages the branch is only resolved when it leaves the
+	// last of them; Clock ( ) then moves the PC and flushes what was
+	// fetched behind it.
+	if ( exExtra > 0 )
 	{
-	case PC_ABSOLUTE:
-		if ( inLatch[1].PC == value )
-		{
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " instruction already in ID stage"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-			return;
-		}
-		else if ( /*inLatch[0].PC*/PCreg == value )
-		{
-			flushStage [1] = true;
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " instruction already in IF stage"
-				<< "; requesting flush for ID" 
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-		else
-		{
-			flushStage[1] = true;
-			flushStage[0] = true;
-			
-			PC_update_control ( value, 2 );
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " updated NPC with absolute address" 
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-		break;
-	case PC_RELATIVE:
-		value = value + PCreg - 4;
-		if ( inLatch[1].PC == value )
-		{
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " instruction already in ID stage"
-				<< reset << flush;
-			sem_post ( cout_mutex );
-			return;
-		}
-		else if ( /*inLatch[0].PC*/PCreg == value )
-		{
-			flushStage [1] = true;
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " instruction already in IF stage"
-				<< "; requesting flush for ID" 
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-		else
-		{
-			flushStage[1] = true;
+		outLatch[2].redirect = true;
+		outLatch[2].redirectPC = value;
+		
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage2:UpdatePC ]"
+			<< " taken, resolved at the end of EX"
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return;
+	}
+	
+	if ( inLatch[1].thread == thread && inLatch[1].PC == static_cast<u_word_32>(value) )
+	{
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage2:UpdatePC ]"
+			<< " instruction already in ID stage"
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return;
+	}
+	
+	if ( inLatch[1].thread == thread )
+		flushStage[1] = true;
+	
+	if ( ctx[thread].PCreg == static_cast<u_word_32>(value) )
+	{
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage2:UpdatePC ]"
+			<< " instruction already in IF stage"
+			<< "; requesting flush for ID" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+	else
+	{
+		if ( fetchThread == thread )
 			flushStage[0] = true;
-			
-			PC_update_control ( value, 2 );
-			
-			sem_wait ( cout_mutex );
-			cout << skyblue << "\n[ Stage2:UpdatePC ]"
-				<< " updated NPC with relative address" 
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-		break;
-	};
-}
 		
+		PC_update_control ( value, 2, thread );
+		
+		sem_wait ( cout_mutex );
+		cout << skyblue << "\n[ Stage2:UpdatePC ]"
+			<< ( updateType == PC_ABSOLUTE ? " updated NPC with absolute address"
+				: " updated NPC with relative address" )
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+}
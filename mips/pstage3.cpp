@@ -36,6 +36,7 @@ void Processor :: Stage3 ( )
 {
 	// Copy inLatch into outLatch... NowForth work with outLatch
 	LatchCopy ( outLatch[3], inLatch[3] );
+	dataCache -> SetPC ( outLatch[3].PC );	// for the prefetcher
 	
 	// Fisrt check for NOP
 	if ( outLatch[3].inst.iV == 0 )
@@ -370,42 +371,184 @@ void Processor :: Stage3 ( )
 		sem_post ( cout_mutex );
 		break;
 	
-	case OP_LW:
-		if ( ReadMem( outLatch[3].ALUOutput, outLatch[3].LMD, 4 ) == true )
+	case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+		if ( MemoryDone ( outLatch[3].memReadyAt == -1 &&
+				ReadMem( outLatch[3].ALUOutput, outLatch[3].LMD, 
+				AccessSize ( outLatch[3].inst.iF.op ),
+				outLatch[3].thread ) == true ) == true )
 		{
+			// Extending what was read again is harmless, should the
+			// instruction have waited for it here.
+			outLatch[3].LMD = LoadValue ( outLatch[3].inst.iF.op, outLatch[3].LMD );
 			outLatch[3].finished = true;
 			
 			sem_wait ( cout_mutex );
-			cout << "\n[ Stage3 ] LW read value = " << outLatch[3].LMD 
+			cout << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " read value = " << outLatch[3].LMD 
 				<< " from address " << outLatch[3].ALUOutput << flush;
 			sem_post ( cout_mutex );
 		}
+		else if ( outLatch[3].memReadyAt != -1 )
+		{
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << gray << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " waits for memory till clock "
+				<< outLatch[3].memReadyAt << reset << flush;
+			sem_post ( cout_mutex );
+		}
 		else 
 		{
 			outLatch[3].finished = false;
 			
 			sem_wait ( cout_mutex );
-			cout << "\n[ Stage3 ] LW read failed" << flush;
+			cout << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " read failed ( or cache busy )" << flush;
 			sem_post ( cout_mutex );
 		}
 		break;
 		
-	case OP_SW:
-		if ( WriteMem ( outLatch[3].ALUOutput, outLatch[3].B, 4 ) == true )
+	case OP_SW: case OP_SB: case OP_SH:
+		if ( MemoryDone ( outLatch[3].memReadyAt == -1 &&
+				StoreMem ( outLatch[3].ALUOutput, outLatch[3].B, 
+				AccessSize ( outLatch[3].inst.iF.op ),
+				outLatch[3].thread ) == true ) == true )
 		{
 			outLatch[3].finished = true;
 			
 			sem_wait ( cout_mutex );
-			cout << "\n[ Stage3 ] SW wrote value = " << outLatch[3].B 
+			cout << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " wrote value = " << outLatch[3].B 
 				<< " to address " << outLatch[3].ALUOutput << flush;
 			sem_post ( cout_mutex );
 		}
+		else if ( outLatch[3].memReadyAt != -1 )
+		{
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << gray << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " waits for memory till clock "
+				<< outLatch[3].memReadyAt << reset << flush;
+			sem_post ( cout_mutex );
+		}
 		else
 		{
 			outLatch[3].finished = false;
 			
 			sem_wait ( cout_mutex );
-			cout << "\n[ Stage3 ] SW write failed" << flush;
+			cout << "\n[ Stage3 ] " << MemOpName ( outLatch[3].inst.iF.op )
+				<< " write failed ( or store buffer full, or cache busy )" << flush;
+			sem_post ( cout_mutex );
+		}
+		break;
+		
+	case OP_LL:
+		if ( outLatch[3].memReadyAt == -1 )
+		{
+			LockMemory ( );	// The read and the link are one atomic step
+			if ( ReadMem( outLatch[3].ALUOutput, outLatch[3].LMD, 4, 
+					outLatch[3].thread ) == true )
+			{
+				bus -> Link ( LinkId ( outLatch[3].thread ), 
+					outLatch[3].ALUOutput );
+				MemoryDone ( true );
+			}
+			UnlockMemory ( );
+		}
+		if ( MemoryDone ( false ) == true )
+		{
+			outLatch[3].finished = true;
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] LL read value = " << outLatch[3].LMD 
+				<< " from address " << outLatch[3].ALUOutput << flush;
+			sem_post ( cout_mutex );
+		}
+		else if ( outLatch[3].memReadyAt != -1 )
+		{
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << gray << "\n[ Stage3 ] LL waits for memory till clock "
+				<< outLatch[3].memReadyAt << reset << flush;
+			sem_post ( cout_mutex );
+		}
+		else 
+		{
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] LL read failed" << flush;
+			sem_post ( cout_mutex );
+		}
+		break;
+		
+	case OP_SC:
+		if ( outLatch[3].memReadyAt != -1 )
+		{
+			// Decided and written on an earlier clock, LMD holds the outcome
+			outLatch[3].finished = MemoryDone ( false );
+			
+			sem_wait ( cout_mutex );
+			if ( outLatch[3].finished == true )
+				cout << "\n[ Stage3 ] SC done" << flush;
+			else
+				cout << gray << "\n[ Stage3 ] SC waits for memory till clock "
+					<< outLatch[3].memReadyAt << reset << flush;
+			sem_post ( cout_mutex );
+			break;
+		}
+		if ( storeBuffer != NULL && storeBuffer -> Empty ( ) == false )
+		{
+			// Older stores must be visible before SC decides anything.
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] SC waits for the store buffer to drain" << flush;
+			sem_post ( cout_mutex );
+			break;
+		}
+		LockMemory ( );	// So is the check of the link and the write
+		if ( bus -> LinkIntact ( LinkId ( outLatch[3].thread ), 
+				outLatch[3].ALUOutput ) == false )
+		{
+			bus -> StoreDone ( LinkId ( outLatch[3].thread ),
+				outLatch[3].ALUOutput, true, false );
+			UnlockMemory ( );
+			outLatch[3].LMD = 0;
+			accessReadyAt = cycles;
+			outLatch[3].finished = MemoryDone ( true );
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] SC failed, link to address " 
+				<< outLatch[3].ALUOutput << " broken" << flush;
+			sem_post ( cout_mutex );
+		}
+		else if ( WriteMem ( outLatch[3].ALUOutput, outLatch[3].B, 4 ) == true )
+		{
+			bus -> StoreDone ( LinkId ( outLatch[3].thread ),
+				outLatch[3].ALUOutput, true, true );
+			UnlockMemory ( );
+			outLatch[3].LMD = 1;
+			outLatch[3].finished = MemoryDone ( true );
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] SC wrote value = " << outLatch[3].B 
+				<< " to address " << outLatch[3].ALUOutput << flush;
+			if ( outLatch[3].finished == false )
+				cout << gray << ", waits for memory till clock "
+					<< outLatch[3].memReadyAt << reset << flush;
+			sem_post ( cout_mutex );
+		}
+		else
+		{
+			UnlockMemory ( );	// The link stays, try again next clock
+			outLatch[3].finished = false;
+			
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] SC write failed" << flush;
 			sem_post ( cout_mutex );
 		}
 		break;
@@ -436,15 +579,135 @@ void Processor :: Stage3 ( )
 }
 
 
-bool Processor :: ReadMem ( word_32 address, word_32 & result, int noOfBytes )
+bool Processor :: ReadMem ( word_32 address, word_32 & result, int noOfBytes,
+	int thread )
 {
-	return dataCache -> Read ( address, result, noOfBytes );
+	if ( scratchpad != NULL && scratchpad -> Serves ( address ) )
+	{
+		accessReadyAt = cycles;
+		return scratchpad -> Read ( address, result, noOfBytes );
+	}
+	
+	if ( storeBuffer != NULL )
+		switch ( storeBuffer -> Lookup ( address, result, noOfBytes, thread ) )
+		{
+		case SB_FORWARDED:
+			sem_wait ( cout_mutex );
+			cout << "\n[ Stage3 ] value = " << result << " for address "
+				<< address << " forwarded from the store buffer" << flush;
+			sem_post ( cout_mutex );
+			accessReadyAt = cycles;
+			return true;
+		case SB_CONFLICT:
+			return false;	// Wait for the store to drain
+		case SB_MISS:
+			break;
+		};
+	accessReadyAt = dataCache -> TimedRead ( address, result, noOfBytes, cycles );
+	if ( accessReadyAt == -1 ) return false;
+	if ( shadows != NULL )
+		shadows -> Record ( SHADOW_SOURCE_DATA, SHADOW_LOAD, address, 0, noOfBytes,
+			outLatch[3].PC, cycles );
+	if ( scratchpad != NULL )
+		scratchpad -> Bypassed ( );
+	return true;
 }
 
 bool Processor :: WriteMem ( word_32 address, word_32 value, int noOfBytes )
 {
+	accessReadyAt = cycles;
 	if ( blockUpdate == true ) return true;
 	// Return telling the processor that memory was updated but
 	// actually do not update memory if blockUpdate is true;
-	return dataCache -> Write ( address, value, noOfBytes );
+	if ( scratchpad != NULL && scratchpad -> Serves ( address ) )
+		return scratchpad -> Write ( address, value, noOfBytes );
+	accessReadyAt = dataCache -> TimedWrite ( address, value, noOfBytes, cycles );
+	if ( accessReadyAt == -1 ) return false;
+	if ( shadows != NULL )
+		shadows -> Record ( SHADOW_SOURCE_DATA, SHADOW_STORE, address, value, 
+			noOfBytes, outLatch[3].PC, cycles );
+	if ( scratchpad != NULL )
+		scratchpad -> Bypassed ( );
+	return true;
+}
+
+bool Processor :: StoreMem ( word_32 address, word_32 value, int noOfBytes, int thread )
+{
+	accessReadyAt = cycles;
+	if ( blockUpdate == true ) return true;	// Same as WriteMem
+	
+	if ( storeBuffer != NULL )
+	{
+		// The scratchpad is the core's own, its stores are not buffered.
+		if ( scratchpad != NULL && scratchpad -> Serves ( address ) )
+			return scratchpad -> Write ( address, value, noOfBytes );
+		return storeBuffer -> Insert ( address, value, noOfBytes, thread,
+			outLatch[3].PC );
+	}
+	
+	if ( WriteMem ( address, value, noOfBytes ) == false )
+		return false;
+	bus -> StoreDone ( LinkId ( thread ), address, false, true );
+	return true;
+}
+
+void Processor :: LockMemory ( )
+{
+	dataCache -> Lock ( );
+	bus -> Lock ( );
+}
+
+void Processor :: UnlockMemory ( )
+{
+	bus -> Unlock ( );
+	dataCache -> Unlock ( );
+}
+
+void Processor :: DrainStoreBuffer ( )
+{
+	if ( storeBuffer == NULL ) return;
+	
+	// A store takes the cycle after it left MEM to reach the cache, so
+	// the load right behind it is forwarded from the buffer.
+	bool drainable = storeBuffer -> Drainable ( );
+	storeBuffer -> Sample ( );
+	if ( drainable == false ) return;
+	
+	// Stores already in the buffer are older than anything blockUpdate
+	// is meant to suppress, so they always drain.  The links are broken
+	// when the store becomes visible, not when it was buffered.
+	StoreBuffer_Entry & e = storeBuffer -> Oldest ( );
+	LockMemory ( );
+	dataCache -> SetPC ( e.pc );
+	if ( dataCache -> TimedWrite ( e.address, e.value, e.noOfBytes, cycles ) != -1 )
+	{
+		bus -> StoreDone ( LinkId ( e.thread ), e.address, false, true );
+		UnlockMemory ( );
+		if ( scratchpad != NULL )
+			scratchpad -> Bypassed ( );
+		if ( shadows != NULL )
+			shadows -> Record ( SHADOW_SOURCE_DATA, SHADOW_STORE, e.address, 
+				e.value, e.noOfBytes, e.pc, cycles );
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ StoreBuffer ] drained value = " << e.value
+			<< " to address " << e.address << flush;
+		sem_post ( cout_mutex );
+		storeBuffer -> Remove ( );
+	}
+	else UnlockMemory ( );
+}
+
+// Called by Stage3 with whether it has just started the access of the
+// instruction in MEM.  The completion clock goes into inLatch[3] too, so
+// that the access is not repeated while the instruction waits there.
+bool Processor :: MemoryDone ( bool started )
+{
+	if ( started == true )
+	{
+		outLatch[3].memReadyAt = accessReadyAt;
+		inLatch[3].memReadyAt = accessReadyAt;
+		inLatch[3].LMD = outLatch[3].LMD;
+	}
+	return outLatch[3].memReadyAt != -1 && cycles >= outLatch[3].memReadyAt;
 }
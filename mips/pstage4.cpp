@@ -38,6 +38,12 @@ void Processor :: Stage4 ( )
 	// Copy inLatch into outLatch... NowForth work with outLatch
 	LatchCopy (outLatch[4], inLatch[4]);
 	
+	if ( outLatch[4].inst.iV != 0 )
+	{
+		retiredInstructions ++;
+		ctx[outLatch[4].thread].retiredInstructions ++;
+	}
+	
 	// Fisrt check for NOP
 	if ( outLatch[4].inst.iV == 0 )
 	{
@@ -429,21 +435,41 @@ void Processor :: Stage4 ( )
 		sem_post ( cout_mutex );
 		break;
 		
-	case OP_LW:
+	case OP_LW: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
 		RegisterWrite ( outLatch[4].targReg, LOAD );
 		outLatch[4].finished = true;
 		
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage4 ] LW stored " << outLatch[4].LMD 
+		cout << "\n[ Stage4 ] " << MemOpName ( outLatch[4].inst.iF.op ) << " stored " << outLatch[4].LMD 
 			<< " into r" << outLatch[4].targReg << flush;
 		sem_post ( cout_mutex );
 		break;
 		
-	case OP_SW:
+	case OP_SW: case OP_SB: case OP_SH:
+		outLatch[4].finished = true;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage4 ] " << MemOpName ( outLatch[4].inst.iF.op ) << " idle" << flush;
+		sem_post ( cout_mutex );
+		break;
+		
+	case OP_LL:
+		RegisterWrite ( outLatch[4].targReg, LOAD );
 		outLatch[4].finished = true;
 		
 		sem_wait ( cout_mutex );
-		cout << "\n[ Stage4 ] SW idle" << flush;
+		cout << "\n[ Stage4 ] LL stored " << outLatch[4].LMD 
+			<< " into r" << outLatch[4].targReg << flush;
+		sem_post ( cout_mutex );
+		break;
+		
+	case OP_SC:
+		RegisterWrite ( outLatch[4].targReg, LOAD );
+		outLatch[4].finished = true;
+		
+		sem_wait ( cout_mutex );
+		cout << "\n[ Stage4 ] SC stored outcome " << outLatch[4].LMD 
+			<< " into r" << outLatch[4].targReg << flush;
 		sem_post ( cout_mutex );
 		break;
 		
@@ -502,14 +528,14 @@ bool Processor :: RegisterWrite ( int regNumber, RegisterWriteSource source )
 		cout << violet << "\n[ Stage4:RegisterWrite ] writing value "
 			<< writeValue << " to register Lo" << reset << flush;
 		sem_post ( cout_mutex );
-		Lo = writeValue;
+		ctx[inLatch[4].thread].Lo = writeValue;
 		break;
 	case REG_HI:
 		sem_wait ( cout_mutex );
 		cout << violet << "\n[ Stage4:RegisterWrite ] writing value "
 			<< writeValue << " to register Hi" << reset << flush;
 		sem_post ( cout_mutex );
-		Hi = writeValue;
+		ctx[inLatch[4].thread].Hi = writeValue;
 		break;
 	default:
 		sem_wait ( cout_mutex );
@@ -517,7 +543,7 @@ bool Processor :: RegisterWrite ( int regNumber, RegisterWriteSource source )
 			<< writeValue << " to register r"
 			<< regNumber << reset << flush;
 		sem_post ( cout_mutex );
-		reg[regNumber] = writeValue;
+		ctx[inLatch[4].thread].reg[regNumber] = writeValue;
 		break;
 	}
 	return true;
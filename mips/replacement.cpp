@@ -0,0 +1,215 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "replacement.h"
+
+# include <cstddef>
+
+Replacement :: Replacement ( )
+{
+	policy = REPL_FIFO;
+	noOfSets = associativity = 0;
+	stamp = NULL;
+	bits = NULL;
+	tree = NULL;
+	leaves = treeNodes = 1;
+	now = 0;
+	seed = 1;
+}
+
+void Replacement :: Initialise ( ReplacementPolicy p, int sets, int assoc, 
+	unsigned int sd )
+{
+	AtExit ( );
+	policy = p;
+	noOfSets = sets;
+	associativity = assoc;
+	seed = ( sd != 0 ) ? sd : 1;	// xorshift never leaves 0
+	now = 0;
+	
+	stamp = new word_64 [noOfSets * associativity];
+	bits = new unsigned char [noOfSets * associativity];
+	for ( int i = 0; i < noOfSets * associativity; i++ )
+	{
+		stamp[i] = 0;
+		bits[i] = ( policy == REPL_SRRIP || policy == REPL_BRRIP ) ? RRPV_MAX : 0;
+	}
+	
+	leaves = 1;
+	while ( leaves < associativity ) leaves <<= 1;
+	treeNodes = ( leaves > 1 ) ? leaves - 1 : 1;
+	tree = new unsigned char [noOfSets * treeNodes];
+	for ( int i = 0; i < noOfSets * treeNodes; i++ )
+		tree[i] = 0;
+}
+
+void Replacement :: AtExit ( )
+{
+	delete[] stamp;
+	delete[] bits;
+	delete[] tree;
+	stamp = NULL;
+	bits = NULL;
+	tree = NULL;
+}
+
+ReplacementPolicy Replacement :: Policy ( )
+{
+	return policy;
+}
+
+const char * Replacement :: Name ( ReplacementPolicy p )
+{
+	switch ( p )
+	{
+	case REPL_FIFO: return "FIFO";
+	case REPL_LRU: return "LRU";
+	case REPL_PLRU: return "tree-PLRU";
+	case REPL_NRU: return "NRU";
+	case REPL_SRRIP: return "SRRIP";
+	case REPL_BRRIP: return "BRRIP";
+	case REPL_RANDOM: return "random";
+	default: return "?";
+	};
+}
+
+unsigned int Replacement :: NextRandom ( )
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+int Replacement :: Victim ( int setNo )
+{
+	int base = setNo * associativity;
+	int victim = 0;
+	
+	switch ( policy )
+	{
+	case REPL_FIFO:
+	case REPL_LRU:
+		for ( int i = 1; i < associativity; i++ )
+			if ( stamp[base + i] < stamp[base + victim] )
+				victim = i;
+		break;
+		
+	case REPL_PLRU:
+		victim = PLRUVictim ( setNo );
+		break;
+		
+	case REPL_NRU:
+		// The first way not referenced since the bits were last cleared
+		for ( victim = 0; victim < associativity; victim++ )
+			if ( bits[base + victim] == 0 )
+				break;
+		if ( victim == associativity )
+		{
+			for ( int i = 0; i < associativity; i++ )
+				bits[base + i] = 0;
+			victim = 0;
+		}
+		break;
+		
+	case REPL_SRRIP:
+	case REPL_BRRIP:
+		// The first way predicted to be re-referenced furthest away,
+		// ageing the whole set until there is one
+		while ( true )
+		{
+			for ( victim = 0; victim < associativity; victim++ )
+				if ( bits[base + victim] >= RRPV_MAX )
+					return victim;
+			for ( int i = 0; i < associativity; i++ )
+				bits[base + i] ++;
+		}
+		
+	case REPL_RANDOM:
+		victim = NextRandom ( ) % associativity;
+		break;
+		
+	default:
+		break;
+	};
+	return victim;
+}
+
+void Replacement :: Fill ( int setNo, int way )
+{
+	int line = setNo * associativity + way;
+	switch ( policy )
+	{
+	case REPL_FIFO:
+	case REPL_LRU:
+		stamp[line] = ++ now;
+		break;
+	case REPL_PLRU:
+		PLRUTouch ( setNo, way );
+		break;
+	case REPL_NRU:
+		bits[line] = 1;
+		break;
+	case REPL_SRRIP:
+		bits[line] = RRPV_MAX - 1;
+		break;
+	case REPL_BRRIP:
+		bits[line] = ( NextRandom ( ) % BRRIP_LONG_ODDS == 0 ) ? 
+			RRPV_MAX - 1 : RRPV_MAX;
+		break;
+	default:
+		break;
+	};
+}
+
+// The tree is laid out as a heap: node n has children 2n+1 and 2n+2, and
+// the leaves stand for the ways.  When the associativity is not a power
+// of two, the tree is that of the next power of two and the walk never
+// turns towards a subtree holding no way.
+void Replacement :: PLRUTouch ( int setNo, int way )
+{
+	unsigned char * t = tree + setNo * treeNodes;
+	int node = 0, low = 0, span = leaves;
+	while ( span > 1 )
+	{
+		span >>= 1;
+		bool right = ( way >= low + span );
+		t[node] = right ? 0 : 1;	// point away from the way just used
+		if ( right ) low += span;
+		node = 2 * node + ( right ? 2 : 1 );
+	}
+}
+
+int Replacement :: PLRUVictim ( int setNo )
+{
+	unsigned char * t = tree + setNo * treeNodes;
+	int node = 0, low = 0, span = leaves;
+	while ( span > 1 )
+	{
+		span >>= 1;
+		bool right = ( t[node] == 1 && low + span < associativity );
+		if ( right ) low += span;
+		node = 2 * node + ( right ? 2 : 1 );
+	}
+	return low;
+}
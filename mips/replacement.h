@@ -0,0 +1,85 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __REPLACEMENT_H
+# define __REPLACEMENT_H
+
+# include "../include/instruction.h"
+
+// Replacement policies of a set associative cache.  The policy is picked
+// when the cache is configured; the lookup path only calls Touch ( ),
+// which is inline and switches on the policy, so there is no virtual call.
+enum ReplacementPolicy { REPL_FIFO, REPL_LRU, REPL_PLRU, REPL_NRU, 
+		REPL_SRRIP, REPL_BRRIP, REPL_RANDOM, NO_OF_REPL_POLICIES };
+
+# define RRPV_MAX 3		// 2 bit re-reference prediction values
+# define BRRIP_LONG_ODDS 32	// BRRIP inserts at RRPV_MAX-1 once in this many fills
+
+class Replacement
+{
+private:
+	ReplacementPolicy policy;
+	int noOfSets;
+	int associativity;
+	
+	word_64 * stamp;	// FIFO: fill order, LRU: last use ( per line )
+	word_64 now;
+	unsigned char * bits;	// NRU: referenced bit, SRRIP / BRRIP: RRPV
+	unsigned char * tree;	// PLRU: treeNodes per set, 1 meaning "go right"
+	int leaves, treeNodes;
+	unsigned int seed;	// RANDOM and BRRIP
+	
+	unsigned int NextRandom ( );
+	int PLRUVictim ( int setNo );
+	void PLRUTouch ( int setNo, int way );
+public:
+	Replacement ( );
+	void Initialise ( ReplacementPolicy p, int sets, int assoc, unsigned int sd );
+	void AtExit ( );
+	
+	ReplacementPolicy Policy ( );
+	static const char * Name ( ReplacementPolicy p );
+	
+	// A hit on the given way
+	void Touch ( int setNo, int way )
+	{
+		int line = setNo * associativity + way;
+		switch ( policy )
+		{
+		case REPL_LRU: stamp[line] = ++ now; break;
+		case REPL_PLRU: PLRUTouch ( setNo, way ); break;
+		case REPL_NRU: bits[line] = 1; break;
+		case REPL_SRRIP:
+		case REPL_BRRIP: bits[line] = 0; break;
+		default: break;		// FIFO and RANDOM ignore hits
+		};
+	}
+	
+	// The way to evict from a set whose ways are all valid
+	int Victim ( int setNo );
+	
+	// A new block was put in the given way
+	void Fill ( int setNo, int way );
+};
+
+# endif
@@ -0,0 +1,290 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "scratchpad.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include <cstring>	// memcpy, memset
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+Scratchpad :: Scratchpad ( word_32 b, word_32 sz, Cache * dc )
+{
+	base = b & ~3;
+	size = ( sz + 3 ) & ~3;
+	store = new unsigned char [size];
+	memset ( store, 0, size );
+	dataSide = dc;
+	
+	for ( int r = 0; r < NO_OF_DMA_REGISTERS; r++ )
+		dmaReg[r] = 0;
+	dmaStatus = DMA_IDLE;
+	dmaSource = dmaDestination = 0;
+	dmaLeft = 0;
+	dmaReadyAt = 0;
+	
+	reads = writes = bypassed = 0;
+	dmaTransfers = dmaWords = 0;
+	dmaBusyCycles = dmaCacheStalls = 0;
+}
+
+void Scratchpad :: AtExit ( )
+{
+	delete[] store;
+	store = NULL;
+}
+
+bool Scratchpad :: Local ( u_word_32 address, int noOfBytes )
+{
+	return address >= static_cast<u_word_32>( base ) && 
+		address - static_cast<u_word_32>( base ) + noOfBytes <= static_cast<u_word_32>( size );
+}
+
+bool Scratchpad :: Register ( u_word_32 address )
+{
+	u_word_32 first = static_cast<u_word_32>( base ) + size;
+	return address >= first && address < first + 4 * NO_OF_DMA_REGISTERS;
+}
+
+void Scratchpad :: Preload ( MainMemory * m )
+{
+	for ( word_32 offset = 0; offset < size; offset += 4 )
+	{
+		word_32 value;
+		if ( m -> Peek ( base + offset, value ) == true )
+			memcpy ( store + offset, &value, 4 );
+	}
+}
+
+bool Scratchpad :: Serves ( word_32 address )
+{
+	return Local ( address, 1 ) || Register ( address );
+}
+
+void Scratchpad :: Bypassed ( )
+{
+	bypassed ++;
+}
+
+// Laid out like MainMemory, in the host's byte order.
+bool Scratchpad :: Read ( word_32 address, word_32 & result, int noOfBytes )
+{
+	reads ++;
+	if ( Register ( address ) )
+	{
+		if ( noOfBytes != 4 || address % 4 != 0 )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ Scratchpad::Read ] Error, DMA registers take word accesses" 
+				<< reset << flush;
+			sem_post ( cout_mutex );
+			return false;
+		}
+		int r = ( static_cast<u_word_32>( address ) - base - size ) / 4;
+		result = ( r == DMA_CONTROL ) ? static_cast<word_32>( dmaStatus ) : dmaReg[r];
+		return true;
+	}
+	
+	if ( Local ( address, noOfBytes ) == false || address % noOfBytes != 0 )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Scratchpad::Read ] Error, Address out of bounds or unaligned" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return false;
+	}
+	
+	unsigned char * ref = store + ( static_cast<u_word_32>( address ) - base );
+	switch ( noOfBytes )
+	{
+	case 1:
+		result = *ref;
+		break;
+	case 2:
+		result = *( reinterpret_cast<unsigned short *> (ref) );
+		break;
+	default:
+		result = *( reinterpret_cast<word_32 *> (ref) );
+		break;
+	};
+	return true;
+}
+
+// Writing CONTROL while a transfer is under way leaves it alone.
+bool Scratchpad :: Write ( word_32 address, word_32 value, int noOfBytes )
+{
+	writes ++;
+	if ( Register ( address ) )
+	{
+		if ( noOfBytes != 4 || address % 4 != 0 )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ Scratchpad::Write ] Error, DMA registers take word accesses" 
+				<< reset << flush;
+			sem_post ( cout_mutex );
+			return false;
+		}
+		int r = ( static_cast<u_word_32>( address ) - base - size ) / 4;
+		dmaReg[r] = value;
+		if ( r == DMA_CONTROL && value != 0 && dmaStatus != DMA_BUSY )
+			StartDma ( );
+		return true;
+	}
+	
+	if ( Local ( address, noOfBytes ) == false || address % noOfBytes != 0 )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Scratchpad::Write ] Error, Address out of bounds or unaligned" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return false;
+	}
+	
+	unsigned char * ref = store + ( static_cast<u_word_32>( address ) - base );
+	switch ( noOfBytes )
+	{
+	case 1:
+		*ref = static_cast<unsigned char>( value );
+		break;
+	case 2:
+		*( reinterpret_cast<unsigned short *> (ref) ) = static_cast<unsigned short>( value );
+		break;
+	default:
+		*( reinterpret_cast<word_32 *> (ref) ) = value;
+		break;
+	};
+	return true;
+}
+
+void Scratchpad :: Fetch ( u_word_32 address, word_32 & value )
+{
+	memcpy ( &value, store + ( address - base ), 4 );
+}
+
+void Scratchpad :: Store ( u_word_32 address, word_32 value )
+{
+	memcpy ( store + ( address - base ), &value, 4 );
+}
+
+void Scratchpad :: StartDma ( )
+{
+	dmaSource = dmaReg[DMA_SOURCE];
+	dmaDestination = dmaReg[DMA_DESTINATION];
+	dmaLeft = ( dmaReg[DMA_COUNT] + 3 ) & ~3;
+	if ( dmaLeft <= 0 )
+	{
+		dmaStatus = DMA_IDLE;
+		return;
+	}
+	
+	if ( dmaSource % 4 != 0 || dmaDestination % 4 != 0 ||
+		( Local ( dmaSource, dmaLeft ) == false && 
+		Local ( dmaDestination, dmaLeft ) == false ) )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Scratchpad::DMA ] Error, a transfer must be word aligned"
+			<< " and start or end in the scratchpad" << reset << flush;
+		sem_post ( cout_mutex );
+		dmaStatus = DMA_ERROR;
+		return;
+	}
+	
+	dmaStatus = DMA_BUSY;
+	dmaTransfers ++;
+}
+
+// One word at a time: a word from or to the cache waits for it to be free
+// and then for the access to complete, a word within the scratchpad takes
+// a clock.
+void Scratchpad :: Clock ( int now )
+{
+	if ( dmaStatus != DMA_BUSY ) return;
+	dmaBusyCycles ++;
+	if ( now < dmaReadyAt ) return;
+	
+	bool fromCache = Local ( dmaSource, 4 ) == false;
+	bool toCache = Local ( dmaDestination, 4 ) == false;
+	if ( ( fromCache || toCache ) && dataSide -> Busy ( now ) )
+	{
+		dmaCacheStalls ++;
+		return;
+	}
+	
+	word_32 value;
+	int ready = now;
+	if ( fromCache )
+		ready = dataSide -> TimedRead ( dmaSource, value, 4, now );
+	else
+		Fetch ( dmaSource, value );
+	if ( ready != -1 )
+	{
+		if ( toCache )
+			ready = dataSide -> TimedWrite ( dmaDestination, value, 4, now );
+		else
+			Store ( dmaDestination, value );
+	}
+	if ( ready == -1 )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ Scratchpad::DMA ] Error, transfer failed at "
+			<< ( fromCache ? dmaSource : dmaDestination ) << reset << flush;
+		sem_post ( cout_mutex );
+		dmaStatus = DMA_ERROR;
+		return;
+	}
+	
+	dmaReadyAt = ready;
+	dmaWords ++;
+	dmaSource += 4;
+	dmaDestination += 4;
+	dmaLeft -= 4;
+	if ( dmaLeft <= 0 )
+	{
+		dmaStatus = DMA_IDLE;
+		sem_wait ( cout_mutex );
+		cout << "\n[ Scratchpad::DMA ] transfer done" << flush;
+		sem_post ( cout_mutex );
+	}
+}
+
+void Scratchpad :: Statistics ( )
+{
+	word_64 local = reads + writes;
+	cout << gray << "\n  Scratchpad             : " << size << " bytes at " << base
+		<< "\n  Scratchpad accesses    : " << local 
+		<< " ( " << reads << " reads, " << writes << " writes )"
+		<< "\n  Data cache accesses    : " << bypassed;
+	if ( local + bypassed > 0 )
+		cout << " ( " << 100.0 * bypassed / ( local + bypassed ) << "% of the data accesses )";
+	cout << "\n  DMA transfers          : " << dmaTransfers
+		<< "\n  DMA words moved        : " << dmaWords
+		<< "\n  DMA busy cycles        : " << dmaBusyCycles
+		<< "\n  DMA waits for the cache: " << dmaCacheStalls
+		<< reset << flush;
+}
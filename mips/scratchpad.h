@@ -0,0 +1,87 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __SCRATCHPAD_H
+# define __SCRATCHPAD_H
+
+# include "memory.h"
+
+// Where a scratchpad goes unless configured otherwise; SmallC places its
+// 'scratchpad' globals here too ( see compiler/codegen.h ).
+# define SCRATCHPAD_BASE 0x10000
+# define MAX_SCRATCHPAD_SIZE 0x100000
+
+// The DMA engine's registers are the words right after the scratchpad.
+// A transfer copies COUNT bytes, a word at a time, from SOURCE to
+// DESTINATION, one of which must lie in the scratchpad; writing CONTROL
+// starts it, reading CONTROL gives its DmaStatus.
+enum DmaRegister { DMA_SOURCE, DMA_DESTINATION, DMA_COUNT, DMA_CONTROL, 
+	NO_OF_DMA_REGISTERS };
+enum DmaStatus { DMA_IDLE, DMA_BUSY, DMA_ERROR };
+
+// A software managed local memory of one core.  Loads and stores that
+// fall in it take a single cycle and never reach the caches; it holds
+// what the program image put in its range at boot, and the DMA engine
+// moves data between it and the rest of memory through the core's data
+// cache while the pipeline carries on.
+class Scratchpad
+{
+private:
+	word_32 base;
+	word_32 size;		// bytes, a multiple of 4
+	unsigned char * store;
+	Cache * dataSide;	// where the DMA engine reaches the rest of memory
+	
+	word_32 dmaReg[NO_OF_DMA_REGISTERS];
+	DmaStatus dmaStatus;
+	u_word_32 dmaSource, dmaDestination;	// the next word of the transfer
+	word_32 dmaLeft;	// bytes
+	int dmaReadyAt;		// cycle at which the word in flight is done
+	
+	// Statistics
+	word_64 reads, writes;
+	word_64 bypassed;		// data accesses that went to the cache
+	word_64 dmaTransfers, dmaWords;
+	word_64 dmaBusyCycles, dmaCacheStalls;
+	
+	bool Local ( u_word_32 address, int noOfBytes );
+	bool Register ( u_word_32 address );
+	void Fetch ( u_word_32 address, word_32 & value );	// a word, for the DMA
+	void Store ( u_word_32 address, word_32 value );
+	void StartDma ( );
+public:
+	Scratchpad ( word_32 b, word_32 sz, Cache * dc );
+	void AtExit ( );
+	
+	void Preload ( MainMemory * m );	// copies the range from the program image
+	
+	bool Serves ( word_32 address );	// Whether the access belongs here
+	void Bypassed ( );	// Counts a data access that went to the cache
+	bool Read ( word_32 address, word_32 & result, int noOfBytes );
+	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	
+	void Clock ( int now );	// Moves the DMA transfer along, once every clock
+	void Statistics ( );
+};
+
+# endif
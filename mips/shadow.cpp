@@ -0,0 +1,370 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "shadow.h"
+# include "trace.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include <iomanip>
+using std::setw;
+
+# include <cstdio>	// snprintf
+# include <sched.h>	// sched_yield
+# include <unistd.h>	// usleep
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+/*********************************************************************************
+*******************The queue*****************************************************/
+
+// The indices only ever grow; an entry's slot is its index modulo the
+// ring size, so the two differ by the number of entries in the ring.
+
+ShadowQueue :: ShadowQueue ( )
+{
+	ring = new ShadowAccess [SHADOW_QUEUE_ENTRIES];
+	head = tail = 0;
+}
+
+void ShadowQueue :: AtExit ( )
+{
+	delete[] ring;
+	ring = NULL;
+}
+
+void ShadowQueue :: Push ( const ShadowAccess * batch, int count )
+{
+	unsigned int t = tail;
+	while ( count > 0 )
+	{
+		unsigned int room = SHADOW_QUEUE_ENTRIES - 
+			( t - __atomic_load_n ( &head, __ATOMIC_ACQUIRE ) );
+		if ( room == 0 )
+		{
+			sched_yield ( );	// The worker is behind
+			continue;
+		}
+		int n = ( static_cast<unsigned int>( count ) < room ) ? count : 
+			static_cast<int>( room );
+		for ( int i = 0; i < n; i++ )
+			ring[( t + i ) & ( SHADOW_QUEUE_ENTRIES - 1 )] = batch[i];
+		t += n;
+		batch += n;
+		count -= n;
+		__atomic_store_n ( &tail, t, __ATOMIC_RELEASE );
+	}
+}
+
+int ShadowQueue :: Pop ( ShadowAccess * batch, int max )
+{
+	unsigned int h = head;
+	unsigned int ready = __atomic_load_n ( &tail, __ATOMIC_ACQUIRE ) - h;
+	int n = ( ready < static_cast<unsigned int>( max ) ) ? 
+		static_cast<int>( ready ) : max;
+	for ( int i = 0; i < n; i++ )
+		batch[i] = ring[( h + i ) & ( SHADOW_QUEUE_ENTRIES - 1 )];
+	__atomic_store_n ( &head, h + n, __ATOMIC_RELEASE );
+	return n;
+}
+
+/*********************************************************************************
+*******************A shadow hierarchy********************************************/
+
+void* shadowWorker ( void * sobj )
+{
+	ShadowHierarchy * s = static_cast<ShadowHierarchy *>( sobj );
+	s -> Work ( );
+	return NULL;
+}
+
+ShadowHierarchy :: ShadowHierarchy ( const char * nm, MainMemory * m, Cache * dc, 
+	Cache * ic )
+{
+	snprintf ( name, SHADOW_NAME_SIZE, "%s", nm );
+	mem = m;
+	dataCache = dc;
+	instrCache = ic;
+	fed = applied = 0;
+	stopping = false;
+	pthread_create ( &worker, NULL, &::shadowWorker, this );
+}
+
+void ShadowHierarchy :: AtExit ( )
+{
+	__atomic_store_n ( &stopping, true, __ATOMIC_RELEASE );
+	pthread_join ( worker, NULL );
+	queue.AtExit ( );
+	dataCache -> AtExit ( );
+	instrCache -> AtExit ( );
+	mem -> AtExit ( );
+}
+
+// The accesses are carried out at the clocks the core made them in.  A
+// level that would still be busy then does not hold them up: the core
+// waited for its own caches, and the shadows have to follow its stream.
+void ShadowHierarchy :: Apply ( const ShadowAccess & a )
+{
+	Cache * c = ( a.kind == SHADOW_FETCH ) ? instrCache : dataCache;
+	c -> SetClock ( a.clock );
+	c -> SetPC ( a.pc );
+	if ( a.kind == SHADOW_STORE )
+		c -> Write ( a.address, a.value, a.noOfBytes );
+	else
+	{
+		word_32 result;
+		c -> Read ( a.address, result, a.noOfBytes );
+	}
+}
+
+void ShadowHierarchy :: Work ( )
+{
+	ShadowAccess batch[SHADOW_BATCH];
+	while ( true )
+	{
+		int n = queue.Pop ( batch, SHADOW_BATCH );
+		if ( n == 0 )
+		{
+			if ( __atomic_load_n ( &stopping, __ATOMIC_ACQUIRE ) == true )
+				return;
+			usleep ( 100 );	// Nothing fed yet
+			continue;
+		}
+		for ( int i = 0; i < n; i++ )
+			Apply ( batch[i] );
+		__atomic_add_fetch ( &applied, n, __ATOMIC_RELEASE );
+	}
+}
+
+void ShadowHierarchy :: Feed ( const ShadowAccess * batch, int count )
+{
+	queue.Push ( batch, count );
+	fed += count;
+}
+
+void ShadowHierarchy :: Drain ( )
+{
+	while ( __atomic_load_n ( &applied, __ATOMIC_ACQUIRE ) != fed )
+		sched_yield ( );
+}
+
+const char * ShadowHierarchy :: Name ( )
+{
+	return name;
+}
+
+MainMemory * ShadowHierarchy :: Memory ( )
+{
+	return mem;
+}
+
+Cache * ShadowHierarchy :: DataCache ( )
+{
+	return dataCache;
+}
+
+Cache * ShadowHierarchy :: InstrCache ( )
+{
+	return instrCache;
+}
+
+/*********************************************************************************
+*******************The shadows of a core*****************************************/
+
+ShadowSet :: ShadowSet ( )
+{
+	shadow = NULL;
+	noOfShadows = shadowSlots = 0;
+	trace = NULL;
+	for ( int s = 0; s < NO_OF_SHADOW_SOURCES; s++ )
+		stagedCount[s] = 0;
+	lost = 0;
+}
+
+void ShadowSet :: AtExit ( )
+{
+	Hand ( );	// what is left over
+	if ( trace != NULL )
+	{
+		trace -> Close ( );
+		delete trace;
+		trace = NULL;
+	}
+	for ( int s = 0; s < noOfShadows; s++ )
+	{
+		shadow[s] -> AtExit ( );
+		delete shadow[s];
+	}
+	delete [] shadow;
+	shadow = NULL;
+	noOfShadows = shadowSlots = 0;
+}
+
+void ShadowSet :: Add ( ShadowHierarchy * s )
+{
+	if ( noOfShadows == shadowSlots )
+	{
+		shadowSlots = ( shadowSlots == 0 ) ? 4 : 2 * shadowSlots;
+		ShadowHierarchy ** grown = new ShadowHierarchy * [shadowSlots];
+		for ( int i = 0; i < noOfShadows; i++ )
+			grown[i] = shadow[i];
+		delete [] shadow;
+		shadow = grown;
+	}
+	shadow[noOfShadows ++] = s;
+}
+
+int ShadowSet :: Count ( )
+{
+	return noOfShadows;
+}
+
+void ShadowSet :: SetTrace ( TraceWriter * t )
+{
+	trace = t;
+}
+
+bool ShadowSet :: Active ( )
+{
+	return noOfShadows > 0 || trace != NULL;
+}
+
+void ShadowSet :: Record ( int source, int kind, word_32 address, word_32 value, 
+	int noOfBytes, word_32 pc, int clock )
+{
+	if ( stagedCount[source] == 2 * SHADOW_BATCH )
+	{
+		lost ++;	// Clock ( ) was not called for too long
+		return;
+	}
+	ShadowAccess & a = staged[source][stagedCount[source] ++];
+	a.address = address;
+	a.value = value;
+	a.pc = pc;
+	a.noOfBytes = noOfBytes;
+	a.kind = kind;
+	a.clock = clock;
+}
+
+void ShadowSet :: Clock ( )
+{
+	if ( stagedCount[SHADOW_SOURCE_FETCH] >= SHADOW_BATCH ||
+			stagedCount[SHADOW_SOURCE_DATA] >= SHADOW_BATCH )
+		Hand ( );
+}
+
+// Each source is in the order of the clocks already; within a clock
+// the fetch goes first.
+void ShadowSet :: Hand ( )
+{
+	int f = 0, d = 0, n = 0;
+	int nf = stagedCount[SHADOW_SOURCE_FETCH], nd = stagedCount[SHADOW_SOURCE_DATA];
+	while ( f < nf || d < nd )
+		if ( d == nd || ( f < nf && 
+				staged[SHADOW_SOURCE_FETCH][f].clock <= staged[SHADOW_SOURCE_DATA][d].clock ) )
+			merged[n ++] = staged[SHADOW_SOURCE_FETCH][f ++];
+		else
+			merged[n ++] = staged[SHADOW_SOURCE_DATA][d ++];
+	
+	for ( int s = 0; s < noOfShadows; s++ )
+		shadow[s] -> Feed ( merged, n );
+	if ( trace != NULL )
+		trace -> Write ( merged, n );
+	stagedCount[SHADOW_SOURCE_FETCH] = stagedCount[SHADOW_SOURCE_DATA] = 0;
+}
+
+// One row of the table: "-" where a cache does not keep the counts.
+static void ShadowRow ( const char * label, bool ratio, Cache * primary,
+	ShadowHierarchy ** shadow, int noOfShadows, bool data )
+{
+	cout << "\n" << std::left << setw ( 26 ) << label << std::right;
+	for ( int s = -1; s < noOfShadows; s++ )
+	{
+		Cache * cache = ( s == -1 ) ? primary : 
+			( data ? shadow[s] -> DataCache ( ) : shadow[s] -> InstrCache ( ) );
+		word_64 accesses, hits;
+		if ( cache -> Totals ( accesses, hits ) == false )
+			cout << setw ( 14 ) << "-";
+		else if ( ratio == true )
+			cout << setw ( 14 ) << std::fixed << std::setprecision ( 4 ) <<
+				( ( accesses != 0 ) ? static_cast<double>( hits ) / accesses : 0 );
+		else
+			cout << setw ( 14 ) << accesses - hits;
+	}
+}
+
+void ShadowSet :: Statistics ( Cache * dc, Cache * ic, MainMemory * m )
+{
+	if ( Active ( ) == false ) return;
+	Hand ( );
+	for ( int s = 0; s < noOfShadows; s++ )
+		shadow[s] -> Drain ( );
+	
+	sem_wait ( cout_mutex );
+	if ( trace != NULL )
+		trace -> Statistics ( );
+	if ( noOfShadows > 0 )
+		ShadowTable ( dc, ic, m );
+	if ( lost > 0 )
+		cout << red << "\n" << lost << " accesses were not recorded" << reset;
+	cout << flush;
+	sem_post ( cout_mutex );
+}
+
+void ShadowSet :: ShadowTable ( Cache * dc, Cache * ic, MainMemory * m )
+{
+	std::streamsize precision = cout.precision ( );
+	cout << blue << "\nShadow hierarchies, side by side with this core's caches : "
+		<< reset << "\n( they saw what reached those caches: not the loads forwarded"
+		<< " from the store buffer, nor the scratchpad's or its DMA's accesses )"
+		<< "\n" << std::left << setw ( 26 ) << "" << std::right 
+		<< setw ( 14 ) << "core";
+	for ( int s = 0; s < noOfShadows; s++ )
+		cout << setw ( 14 ) << shadow[s] -> Name ( );
+	
+	ShadowRow ( "Data hit ratio", true, dc, shadow, noOfShadows, true );
+	ShadowRow ( "Data misses", false, dc, shadow, noOfShadows, true );
+	ShadowRow ( "Instruction hit ratio", true, ic, shadow, noOfShadows, false );
+	ShadowRow ( "Instruction misses", false, ic, shadow, noOfShadows, false );
+	
+	cout << "\n" << std::left << setw ( 26 ) << "Data access time" << std::right 
+		<< std::fixed << std::setprecision ( 2 ) << setw ( 14 ) << dc -> AverageAccessTime ( );
+	for ( int s = 0; s < noOfShadows; s++ )
+		cout << setw ( 14 ) << shadow[s] -> DataCache ( ) -> AverageAccessTime ( );
+	cout << "\n" << std::left << setw ( 26 ) << "Instruction access time" << std::right 
+		<< setw ( 14 ) << ic -> AverageAccessTime ( );
+	for ( int s = 0; s < noOfShadows; s++ )
+		cout << setw ( 14 ) << shadow[s] -> InstrCache ( ) -> AverageAccessTime ( );
+	cout.unsetf ( std::ios::floatfield );
+	cout.precision ( precision );
+	
+	cout << "\n" << std::left << setw ( 26 ) << "Memory traffic ( bytes )" << std::right 
+		<< setw ( 14 ) << m -> Traffic ( );
+	for ( int s = 0; s < noOfShadows; s++ )
+		cout << setw ( 14 ) << shadow[s] -> Memory ( ) -> Traffic ( );
+}
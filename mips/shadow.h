@@ -0,0 +1,147 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __SHADOW_H
+# define __SHADOW_H
+
+# include "memory.h"
+
+# include <pthread.h>
+
+# define SHADOW_NAME_SIZE 24
+# define SHADOW_QUEUE_ENTRIES 4096	// a power of two
+# define SHADOW_BATCH 256		// accesses handed over at a time
+
+class TraceWriter;
+
+// What a shadow hierarchy is shown of the core's access stream: every
+// instruction fetch and every load and store that reached the core's own
+// caches, as they were made.  Loads forwarded from the store buffer and
+// the accesses of the scratchpad and its DMA engine are not shown, so the
+// shadows see what the core's caches saw, not what the program made.
+enum ShadowAccessKind { SHADOW_FETCH, SHADOW_LOAD, SHADOW_STORE };
+
+// Where the accesses are recorded; each is written by one stage thread
+// only ( SHADOW_SOURCE_DATA also by the clock thread, between clocks ).
+enum ShadowSource { SHADOW_SOURCE_FETCH, SHADOW_SOURCE_DATA, NO_OF_SHADOW_SOURCES };
+
+class ShadowAccess
+{
+public:
+	word_32 address;
+	word_32 value;		// stored, for SHADOW_STORE
+	word_32 pc;		// for the prefetchers
+	int noOfBytes;
+	int kind;		// a ShadowAccessKind
+	int clock;
+};
+
+// A ring of accesses with one producer and one consumer.  Neither ever
+// takes a lock: each owns one index and only reads the other, and the
+// producer publishes a whole batch with one store.
+class ShadowQueue
+{
+private:
+	ShadowAccess * ring;
+	unsigned int head;	// next to be taken, written by the consumer
+	unsigned int tail;	// next free, written by the producer
+public:
+	ShadowQueue ( );
+	void AtExit ( );
+	
+	void Push ( const ShadowAccess * batch, int count );	// waits for room
+	int Pop ( ShadowAccess * batch, int max );		// 0 if empty
+};
+
+// A cache hierarchy of its own, over a memory of its own, that is
+// driven by a worker thread with the accesses of the core it watches.
+// It never answers the core, so it has no say in the timing, and its
+// data is meaningless; only its statistics are of interest.
+class ShadowHierarchy
+{
+private:
+	char name[SHADOW_NAME_SIZE];
+	MainMemory * mem;
+	Cache * dataCache;
+	Cache * instrCache;
+	
+	ShadowQueue queue;
+	word_64 fed;		// accesses pushed, by the producer
+	word_64 applied;	// ... and carried out, by the worker
+	bool stopping;
+	pthread_t worker;
+	
+	void Apply ( const ShadowAccess & a );
+	void Work ( );
+	friend void* shadowWorker ( void * );
+public:
+	ShadowHierarchy ( const char * nm, MainMemory * m, Cache * dc, Cache * ic );
+	void AtExit ( );	// stops the worker
+	
+	void Feed ( const ShadowAccess * batch, int count );
+	void Drain ( );		// returns once everything fed has been carried out
+	
+	const char * Name ( );
+	MainMemory * Memory ( );
+	Cache * DataCache ( );
+	Cache * InstrCache ( );
+};
+
+// The shadow hierarchies of a core.  The stages record their accesses
+// here; once every clock the clock thread hands them, in the order of
+// the clocks they were made in, to the shadows in batches, and to the
+// trace if one is being written.
+class ShadowSet
+{
+private:
+	ShadowHierarchy ** shadow;	// grown by Add ( )
+	int noOfShadows, shadowSlots;
+	TraceWriter * trace;	// NULL if none
+	
+	ShadowAccess staged[NO_OF_SHADOW_SOURCES][2 * SHADOW_BATCH];
+	int stagedCount[NO_OF_SHADOW_SOURCES];
+	word_64 lost;		// recorded with a full staging area
+	ShadowAccess merged[4 * SHADOW_BATCH];
+	
+	void Hand ( );		// merges the staged accesses and feeds them
+	void ShadowTable ( Cache * dc, Cache * ic, MainMemory * m );
+public:
+	ShadowSet ( );
+	void AtExit ( );
+	
+	void Add ( ShadowHierarchy * s );
+	int Count ( );
+	void SetTrace ( TraceWriter * t );
+	bool Active ( );	// if there are shadows or a trace
+	
+	void Record ( int source, int kind, word_32 address, word_32 value, 
+		int noOfBytes, word_32 pc, int clock );
+	void Clock ( );		// hands a batch over when there is one
+	
+	// Waits for the shadows to catch up, then prints their hit ratios,
+	// access times and memory traffic side by side with those of the
+	// core's own caches, and the size of the trace.
+	void Statistics ( Cache * dc, Cache * ic, MainMemory * m );
+};
+
+# endif
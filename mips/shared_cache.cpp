@@ -0,0 +1,239 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "shared_cache.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+/********************************************************************
+ * CachePort
+ ********************************************************************/
+
+CachePort :: CachePort ( SharedCache * s, int r )
+{
+	shared = s;
+	requester = r;
+}
+
+SharedCache * CachePort :: Shared ( )
+{
+	return shared;
+}
+
+void CachePort :: Statistics ( )
+{
+	shared -> Statistics ( );
+}
+
+bool CachePort :: Read ( word_32 address, word_32 & result, int noOfBytes )
+{
+	int wait = shared -> Begin ( requester, clock, accessPC );
+	bool ret = shared -> Level ( ) -> Read ( address, result, noOfBytes );
+	shared -> End ( requester, wait, lastLatency, lastOccupancy );
+	AccountAccess ( );
+	return ret;
+}
+
+bool CachePort :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+{
+	return shared -> Level ( ) -> Read_nofetch ( address, result, noOfBytes );
+}
+
+bool CachePort :: Write ( word_32 address, word_32 value, int noOfBytes )
+{
+	int wait = shared -> Begin ( requester, clock, accessPC );
+	bool ret = shared -> Level ( ) -> Write ( address, value, noOfBytes );
+	shared -> End ( requester, wait, lastLatency, lastOccupancy );
+	AccountAccess ( );
+	return ret;
+}
+
+bool CachePort :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	int wait = shared -> Begin ( requester, clock, accessPC );
+	bool ret = shared -> Level ( ) -> ReadBlock ( address, data, noOfWords, 
+		first, arrival );
+	if ( arrival != NULL )
+		for ( int i = 0; i < noOfWords; i++ )
+			arrival[i] += wait;
+	shared -> End ( requester, wait, lastLatency, lastOccupancy );
+	AccountAccess ( );
+	return ret;
+}
+
+bool CachePort :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	int wait = shared -> Begin ( requester, clock, accessPC );
+	bool ret = shared -> Level ( ) -> WriteBlock ( address, data, noOfWords );
+	shared -> End ( requester, wait, lastLatency, lastOccupancy );
+	AccountAccess ( );
+	return ret;
+}
+
+// Off the timing, like the write back it stands for
+void CachePort :: CleanEviction ( word_32 address, word_32 * data, int noOfWords )
+{
+	shared -> Begin ( requester, clock, accessPC );
+	shared -> Level ( ) -> CleanEviction ( address, data, noOfWords );
+	int l, o;
+	shared -> End ( requester, 0, l, o );
+}
+
+void CachePort :: AtExit ( )
+{	// Does nothing
+}
+
+/********************************************************************
+ * SharedCache
+ ********************************************************************/
+
+SharedCache :: SharedCache ( Cache * lvl, int ports, InclusionPolicy policy )
+{
+	level = lvl;
+	top = dynamic_cast<SimpleCache *>( level );
+	inclusion = policy;
+	if ( top != NULL )
+		top -> SetInclusion ( policy );
+	else if ( policy != INCLUSION_NON_INCLUSIVE )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SharedCache ] Only a SimpleCache can be inclusive or "
+			<< "exclusive, the shared level is non-inclusive" << reset << flush;
+		sem_post ( cout_mutex );
+		inclusion = INCLUSION_NON_INCLUSIVE;
+	}
+	
+	noOfPorts = ports;
+	if ( noOfPorts < 1 ) noOfPorts = 1;
+	if ( noOfPorts > MAX_SHARED_PORTS ) noOfPorts = MAX_SHARED_PORTS;
+	for ( int p = 0; p < noOfPorts; p++ )
+		portFreeAt[p] = 0;
+	usedPort = start = 0;
+	
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init ( &attr );
+	pthread_mutexattr_settype ( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init ( &mutex, &attr );
+	pthread_mutexattr_destroy ( &attr );
+	
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+	{
+		port[r] = new CachePort ( this, r );
+		accesses[r] = conflicts[r] = waitCycles[r] = latency[r] = 0;
+	}
+	reported = 0;
+}
+
+CachePort * SharedCache :: Port ( int requester )
+{
+	return port[requester];
+}
+
+Cache * SharedCache :: Level ( )
+{
+	return level;
+}
+
+void SharedCache :: AddUpper ( SimpleCache * above )
+{
+	if ( top == NULL ) return;
+	if ( inclusion == INCLUSION_INCLUSIVE && above -> LineBytes ( ) > top -> LineBytes ( ) )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SharedCache ] An inclusive level needs lines at least as "
+			<< "large as those above it, the shared level is non-inclusive" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		inclusion = INCLUSION_NON_INCLUSIVE;
+		top -> SetInclusion ( inclusion );
+	}
+	top -> AddUpper ( above );
+	if ( inclusion == INCLUSION_INCLUSIVE )
+		above -> SetHierarchyLock ( &mutex );
+}
+
+int SharedCache :: Begin ( int requester, int now, word_32 pc )
+{
+	pthread_mutex_lock ( &mutex );
+	usedPort = 0;
+	for ( int p = 1; p < noOfPorts; p++ )
+		if ( portFreeAt[p] < portFreeAt[usedPort] ) usedPort = p;
+	start = ( portFreeAt[usedPort] > now ) ? portFreeAt[usedPort] : now;
+	
+	level -> SetClock ( start );
+	level -> SetPC ( pc );
+	level -> SetRequester ( requester );
+	return start - now;
+}
+
+void SharedCache :: End ( int requester, int wait, int & lastLatency, int & lastOccupancy )
+{
+	lastLatency = wait + level -> LastLatency ( );
+	lastOccupancy = wait + level -> LastOccupancy ( );
+	portFreeAt[usedPort] = start + level -> LastOccupancy ( );
+	
+	accesses[requester] ++;
+	latency[requester] += lastLatency;
+	if ( wait > 0 )
+	{
+		conflicts[requester] ++;
+		waitCycles[requester] += wait;
+	}
+	pthread_mutex_unlock ( &mutex );
+}
+
+void SharedCache :: Statistics ( )
+{
+	if ( ++ reported < NO_OF_REQUESTERS ) return;
+	reported = 0;
+	
+	cout << green << "\n[ SharedCache::Statistics ] Statistics for the levels shared "
+		<< "by data and instructions are displayed" << reset << flush;
+	cout << "\nPorts : " << noOfPorts << ", first come first served"
+		<< "\nInclusion : " << ( inclusion == INCLUSION_INCLUSIVE ? "inclusive" :
+			inclusion == INCLUSION_EXCLUSIVE ? "exclusive" : "non-inclusive" );
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+		cout << "\n" << Cache::RequesterName ( r ) << " : " << accesses[r] 
+			<< " accesses, " << conflicts[r] << " waited for a port ( " 
+			<< waitCycles[r] << " cycles ), average latency "
+			<< (( accesses[r] != 0 ) ? 
+				static_cast<double>(latency[r]) / accesses[r] : 0) << " cycles";
+	cout << flush;
+	level -> Statistics ( );
+}
+
+void SharedCache :: AtExit ( )
+{
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+		delete port[r];
+	level -> AtExit ( );
+	pthread_mutex_destroy ( &mutex );
+}
@@ -0,0 +1,103 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __SHARED_CACHE_H
+# define __SHARED_CACHE_H
+
+# include "memory.h"
+# include "simple_cache.h"
+
+# include <pthread.h>
+
+# define MAX_SHARED_PORTS 4
+
+class SharedCache;
+
+// The way one requester ( the data or the instruction side ) reaches a
+// SharedCache.  The private levels of that side sit on it as they would
+// on a lower level of their own.
+class CachePort : public Cache
+{
+private:
+	SharedCache * shared;
+	int requester;
+public:
+	CachePort ( SharedCache * s, int r );
+	SharedCache * Shared ( );
+	
+	void Statistics ( );
+	bool Read ( word_32 address, word_32 & result, int noOfBytes );
+	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes );
+	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	void CleanEviction ( word_32 address, word_32 * data, int noOfWords );
+	void AtExit ( );	// Does nothing, see SharedCache::AtExit
+};
+
+// Lower cache levels used by both the data and the instruction side.
+// The level has a number of ports; an access takes the port that frees
+// up first, waiting for it if need be ( first come, first served ), and
+// holds it for the level's occupancy.  The top level may be inclusive or
+// exclusive of the private caches above it if it is a SimpleCache.
+class SharedCache
+{
+private:
+	Cache * level;
+	SimpleCache * top;	// level, if it is a SimpleCache
+	InclusionPolicy inclusion;
+	CachePort * port[NO_OF_REQUESTERS];
+	
+	int noOfPorts;
+	int portFreeAt[MAX_SHARED_PORTS];	// first clock each port is free
+	int usedPort;		// taken by the access in progress
+	int start;		// ... and the clock it got it
+	
+	// The ports' accesses are made from the stage threads of both sides;
+	// recursive, as an inclusive level's evictions reach back above.
+	pthread_mutex_t mutex;
+	
+	word_64 accesses[NO_OF_REQUESTERS];
+	word_64 conflicts[NO_OF_REQUESTERS];	// waited for a port
+	word_64 waitCycles[NO_OF_REQUESTERS];
+	word_64 latency[NO_OF_REQUESTERS];
+	int reported;		// ports through with their Statistics ( )
+public:
+	SharedCache ( Cache * lvl, int ports, InclusionPolicy policy );
+	
+	CachePort * Port ( int requester );
+	Cache * Level ( );
+	void AddUpper ( SimpleCache * above );	// a private cache directly on a port
+	
+	// An access by a port: Begin arbitrates, with the lock held, and
+	// passes the clock and the requester on to the level; End returns the
+	// latency and occupancy, counting the wait, and releases the lock.
+	int Begin ( int requester, int now, word_32 pc );
+	void End ( int requester, int wait, int & lastLatency, int & lastOccupancy );
+	
+	void Statistics ( );	// once every port has asked for it
+	void AtExit ( );
+};
+
+# endif
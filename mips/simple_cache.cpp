@@ -22,6 +22,7 @@
  */
 
 # include "simple_cache.h"
+# include "coherence_bus.h"
 
 # include <iostream>
 using std::cout;
@@ -29,22 +30,57 @@ using std::cin;
 using std::flush;
 # include <cstring>
 using std::strcpy;
+using std::memset;
+# include <cstdlib>
+using std::free;
 
 # include "../include/color.h"
 
+// Ways FindInSet compares at once.  Build with -mavx2 ( see SIMDFLAGS in
+// the Makefile ) for the AVX2 compare; x86-64 always has SSE2.
+# if defined ( __AVX2__ )
+# include <immintrin.h>
+# define TAG_VECTOR 8
+# elif defined ( __SSE2__ )
+# include <emmintrin.h>
+# define TAG_VECTOR 4
+# else
+# define TAG_VECTOR 1
+# endif
+
 # include <semaphore.h>
 extern sem_t * cout_mutex;	// Defined in main.cpp
 
 SimpleCache_TagRecord :: SimpleCache_TagRecord ( )
 {
-	tag = 0;
-	valid = false;
 	modified = false;
+	state = MESI_INVALID;
+	accessMask = 0;
+	prefetched = false;
+	readyAt = -1;
+}
+
+
+
+SimpleCache_StreamEntry :: SimpleCache_StreamEntry ( )
+{
+	blockTag = -1;
+	readyAt = -1;
+	data = NULL;
+}
+
+
+
+SimpleCache_MSHR :: SimpleCache_MSHR ( )
+{
+	blockTag = -1;
+	issuedAt = doneAt = -1;
+	wordReady = NULL;
 }
 
 
 
-SimpleCache :: SimpleCache ( Cache * memory, int nob, int wpb, int assoc, char * ty,
+SimpleCache :: SimpleCache ( Cache * memory, int nob, int wpb, int assoc, const char * ty,
 	int lev, bool verbos ) 
 {
 	mem = memory;
@@ -59,63 +95,242 @@ SimpleCache :: SimpleCache ( Cache * memory, int nob, int wpb, int assoc, char *
 	noOfSets = noOfBlocks / associativity;
 	noOfBlocks = noOfSets * associativity;		// remove fractions
 	
-	cache = new word_32 ** [noOfSets];
-	if ( cache == 0 )
+	// Whole vectors of tags per set, and whole host cache lines of data
+	tagStride = ( associativity + TAG_VECTOR - 1 ) / TAG_VECTOR * TAG_VECTOR;
+	void * d = NULL, * t = NULL;
+	size_t dataBytes = static_cast<size_t>(noOfBlocks) * wordsPerBlock * sizeof ( word_32 );
+	size_t tagBytes = static_cast<size_t>(noOfSets) * tagStride * sizeof ( int );
+	if ( posix_memalign ( &d, CACHE_LINE_BYTES, dataBytes ) != 0 ||
+		posix_memalign ( &t, CACHE_LINE_BYTES, tagBytes ) != 0 )
 	{
 		sem_wait ( cout_mutex );
 		cout << red << "\n[ SimpleCache " << type << " "
-			<< level << "-level ] Error allocating memory (1)" 
+			<< level << "-level ] Error allocating memory" 
 			<< reset << flush;
 		sem_post ( cout_mutex );
 	}
-	tagArray = new SimpleCache_TagRecord * [noOfSets];
-	fifoIndex = new int [noOfSets];
-	for ( int i = 0; i < noOfSets; i++ )
+	data = static_cast<word_32 *>(d);
+	tags = static_cast<int *>(t);
+	for ( int i = 0; i < noOfSets * tagStride; i++ )
+		tags[i] = -1;
+	memset ( data, 0, dataBytes );
+	tagArray = new SimpleCache_TagRecord [noOfBlocks];
+	
+	offsetShift = -1;
+	for ( int b = 0; b < 31; b++ )
+		if ( wordsPerBlock == ( 1 << b ) ) offsetShift = b;
+	setMask = ( ( noOfSets & ( noOfSets - 1 ) ) == 0 ) ? noOfSets - 1 : -1;
+	
+	readCount = readHitCount = 0;
+	writeCount = writeHitCount = 0;
+	blockReads = blockWrites = 0;
+	fillPolicy = FILL_WHOLE_BLOCK;
+	
+	replacement.Initialise ( REPL_FIFO, noOfSets, associativity, 1 );
+	evictions = dirtyEvictions = 0;
+	writeThrough = false;
+	writeAllocate = true;
+	writeBuffer = NULL;
+	drainReadyAt = 0;
+	bytesFromBelow = bytesToBelow = 0;
+	victimCache = NULL;
+	shadowPolicy = NULL;
+	shadowTags = NULL;
+	shadowAccesses = 0;
+	stackDistance = NULL;
+	missClassifier = NULL;
+	
+	mshr = NULL;
+	noOfMSHRs = 0;
+	secondaryMisses = mshrFullStalls = mshrFullCycles = 0;
+	mshrBusyCycles = mshrCoveredCycles = 0;
+	coveredUntil = firstIssue = lastDone = -1;
+	peakMSHRs = 0;
+	
+	wordArrival = new int [wordsPerBlock];
+	demandTag = -1;
+	demandTrigger = false;
+	candidate = NULL;
+	pollutionTag = NULL;
+	stream = NULL;
+	streamHead = streamCount = 0;
+	streamNextTag = 0;
+	prefetchesIssued = usefulPrefetches = latePrefetches = 0;
+	unusedPrefetches = pollutionMisses = 0;
+	
+	bus = NULL;
+	snooping = false;
+	
+	inclusion = INCLUSION_NON_INCLUSIVE;
+	noOfUppers = 0;
+	hierarchyLock = NULL;
+	recalls = dirtyRecalls = 0;
+	linesMovedUp = linesFromAbove = 0;
+	backInvalidations = 0;
+	for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+		requesterAccesses[r] = requesterHits[r] = 0;
+}
+
+bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
+{
+	bool ret;
+	if ( hierarchyLock != NULL ) pthread_mutex_lock ( hierarchyLock );
+	if ( bus == NULL )
+		ret = Read_internal ( address, result, noOfBytes );
+	else
 	{
-		fifoIndex[i] = 0;
-		cache[i] = new word_32 * [associativity];
-		if ( cache[i] == 0 )
+		// A non snooping cache's lines never change under it,
+		// so only its misses need to be serialised with the other cores.
+		int blockTag, blockOffset, setNo;
+		Locate ( address, blockTag, blockOffset, setNo );
+		if ( snooping == false && address % 4 == 0 && noOfBytes == 4 &&
+				FindInSet ( setNo, blockTag ) != -1 )
+			ret = Read_internal ( address, result, noOfBytes );
+		else
 		{
-			sem_wait ( cout_mutex );
-			cout << red << "\n[ SimpleCache " << type << " "
-				<< level << "-level ] Error allocating memory (2)"
-				<< reset << flush;
-			sem_post ( cout_mutex );
+			bool wide;
+			LockForAccess ( address, false, wide );
+			ret = Read_internal ( address, result, noOfBytes );
+			UnlockForAccess ( address, wide );
 		}
-		tagArray[i] = new SimpleCache_TagRecord [associativity];
-		
-		for ( int j = 0; j < associativity; j++ )
+	}
+	IssuePrefetches ( );
+	AccountAccess ( );
+	if ( hierarchyLock != NULL ) pthread_mutex_unlock ( hierarchyLock );
+	return ret;
+}
+
+bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
+{
+	bool ret;
+	if ( hierarchyLock != NULL ) pthread_mutex_lock ( hierarchyLock );
+	if ( bus == NULL )
+		ret = Write_internal ( address, value, noOfBytes );
+	else
+	{
+		bool wide;
+		LockForAccess ( address, true, wide );
+		ret = Write_internal ( address, value, noOfBytes );
+		UnlockForAccess ( address, wide );
+	}
+	IssuePrefetches ( );
+	AccountAccess ( );
+	if ( hierarchyLock != NULL ) pthread_mutex_unlock ( hierarchyLock );
+	return ret;
+}
+
+bool SimpleCache :: ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	blockReads ++;
+	if ( inclusion == INCLUSION_EXCLUSIVE )
+		return ExclusiveReadBlock ( address, data, noOfWords, first, arrival );
+	if ( hierarchyLock != NULL ) pthread_mutex_lock ( hierarchyLock );
+	if ( bus != NULL ) bus -> Lock ( );
+	bool ret = true;
+	int lineTag = -1, way = -1;
+	int ready = 0, firstReady = 0;
+	for ( int n = 0; n < noOfWords && ret == true; n++ )
+	{
+		int k = ( first + n ) % noOfWords;
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * k, blockTag, blockOffset, setNo );
+		if ( blockTag != lineTag )
 		{
-			cache[i][j] = new word_32 [wordsPerBlock];
-			if ( cache[i][j] == 0 )
+			// The line is looked up, and filled if need be, once; one
+			// set lock at a time, under the bus lock
+			if ( bus != NULL )
 			{
-				sem_wait ( cout_mutex );
-				cout << red << "\n[ SimpleCache " << type << " "
-					<< level << "-level ]"
-					<< " Error allocating memory (3)"
-					<< reset << flush;
-				sem_post ( cout_mutex );
+				if ( lineTag != -1 ) bus -> UnlockSet ( BlockAddress ( lineTag ) );
+				bus -> LockSet ( address + 4 * k );
 			}
+			ret = Read_internal ( address + 4 * k, data[k], 4 );
+			IssuePrefetches ( );
+			AccountAccess ( );
+			lineTag = blockTag;
+			way = FindInSet ( setNo, blockTag );
+			ready = ( n == 0 || lastLatency > ready + 1 ) ? lastLatency : ready + 1;
 		}
+		else
+		{
+			data[k] = Line ( setNo, way )[blockOffset];
+			Record ( setNo, way ).accessMask |= 1u << ( blockOffset % 32 );
+			ready ++;
+		}
+		if ( n == 0 ) firstReady = ready;
+		if ( arrival != NULL ) arrival[k] = ready;
 	}
-	
-	readCount = readHitCount = 0;
-	writeCount = writeHitCount = 0;
+	if ( bus != NULL )
+	{
+		if ( lineTag != -1 ) bus -> UnlockSet ( BlockAddress ( lineTag ) );
+		bus -> Unlock ( );
+	}
+	if ( hierarchyLock != NULL ) pthread_mutex_unlock ( hierarchyLock );
+	lastLatency = firstReady;
+	lastOccupancy = ready;
+	return ret;
 }
 
-bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
+bool SimpleCache :: WriteBlock ( word_32 address, word_32 * data, int noOfWords )
 {
-	if ( noOfBytes != 4 )
+	blockWrites ++;
+	if ( inclusion == INCLUSION_EXCLUSIVE )
+		return ExclusiveWriteBlock ( address, data, noOfWords );
+	if ( hierarchyLock != NULL ) pthread_mutex_lock ( hierarchyLock );
+	if ( bus != NULL ) bus -> Lock ( );
+	bool ret = true;
+	int lineTag = -1, way = -1;
+	int firstLatency = 0, occupancy = 0;
+	for ( int k = 0; k < noOfWords && ret == true; k++ )
 	{
-		// Feature not supported right now
-		sem_wait ( cout_mutex );
-		cout << red << "\n[ SimpleCache::Read " << type << " "
-			<< level << "-level ] no of bytes != 4" 
-			<< reset << flush;
-		sem_post ( cout_mutex );
-		return false;
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * k, blockTag, blockOffset, setNo );
+		if ( blockTag != lineTag )
+		{
+			// The first word of each line makes the access ( allocation,
+			// coherence, the statistics ); the rest go straight in.
+			if ( bus != NULL )
+			{
+				if ( lineTag != -1 ) bus -> UnlockSet ( BlockAddress ( lineTag ) );
+				bus -> LockSet ( address + 4 * k );
+			}
+			ret = Write_internal ( address + 4 * k, data[k], 4 );
+			IssuePrefetches ( );
+			AccountAccess ( );
+			lineTag = blockTag;
+			way = FindInSet ( setNo, blockTag );
+			if ( k == 0 ) firstLatency = lastLatency;
+			if ( lastOccupancy + k > occupancy ) occupancy = lastOccupancy + k;
+			continue;
+		}
+		if ( way != -1 )
+		{
+			Line ( setNo, way )[blockOffset] = data[k];
+			Record ( setNo, way ).accessMask |= 1u << ( blockOffset % 32 );
+			if ( writeThrough == true )
+				WriteDown ( address + 4 * k, data[k] );
+			continue;
+		}
+		// Not allocated: as in Write_internal
+		int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+		if ( v != -1 )
+			victimCache -> Entry ( v ).data[blockOffset] = data[k];
+		WriteDown ( address + 4 * k, data[k] );
+	}
+	if ( bus != NULL )
+	{
+		if ( lineTag != -1 ) bus -> UnlockSet ( BlockAddress ( lineTag ) );
+		bus -> Unlock ( );
 	}
-	if ( address % 4 != 0 )
+	if ( hierarchyLock != NULL ) pthread_mutex_unlock ( hierarchyLock );
+	lastLatency = firstLatency;
+	lastOccupancy = ( occupancy > noOfWords ) ? occupancy : noOfWords;
+	return ret;
+}
+
+bool SimpleCache :: Read_internal ( word_32 address, word_32 & result, int noOfBytes )
+{
+	if ( Aligned ( address, noOfBytes ) == false )
 	{
 		// Alignment error
 		sem_wait ( cout_mutex );
@@ -126,21 +341,17 @@ bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
 		return false;
 	}
 	
-	int blockTag = ( address / 4 ) / ( wordsPerBlock );
-	int blockOffset = ( address / 4 ) % ( wordsPerBlock );
-	int setNo = blockTag % noOfSets;
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	if ( shadowPolicy != NULL )
+		ObservePolicies ( setNo, blockTag );
+	if ( stackDistance != NULL )
+		stackDistance -> Observe ( blockTag );
+	BackgroundDrain ( );
 	
-	int indexInSet = -1;
-	for ( int i = 0; i < associativity; i++ )
-	{
-		if ( tagArray[setNo][i].valid == true &&
-			tagArray[setNo][i].tag == blockTag )
-		{
-			// Hit.
-			indexInSet = i;
-			break;
-		}
-	}
+	int indexInSet = FindInSet ( setNo, blockTag );
+	if ( missClassifier != NULL )
+		missClassifier -> Access ( setNo, blockTag, indexInSet != -1, true );
 	
 	if ( indexInSet != -1 )
 	{
@@ -155,13 +366,30 @@ bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
 			sem_post ( cout_mutex );
 		}
 		readCount ++;
-		readHitCount ++;
+		lastLatency = lastOccupancy = hitLatency;
+		replacement.Touch ( setNo, indexInSet );
+		int m = FindMSHR ( blockTag );
+		CountRequester ( m == -1 );
+		if ( m == -1 )
+			readHitCount ++;
+		else
+		{
+			// Still arriving, wait for the word
+			secondaryMisses ++;
+			if ( mshr[m].wordReady[blockOffset] - clock + 1 > hitLatency )
+				lastLatency = mshr[m].wordReady[blockOffset] - clock + 1;
+		}
+		demandTag = blockTag;
+		DemandHit ( setNo, indexInSet );
+		Record ( setNo, indexInSet ).accessMask |= 1u << ( blockOffset % 32 );
 		
-		result = cache[setNo][indexInSet][blockOffset];
+		result = Extract ( Line ( setNo, indexInSet )[blockOffset], address, noOfBytes );
 		return true;
 	}
 	// We have a miss.
-	int index = fifoIndex[setNo];
+	DemandMiss ( setNo, blockTag );
+	int index = ChooseVictim ( setNo );
+	mem -> SetClock ( clock + hitLatency );	// for the write back
 	if ( verbose == true )
 	{
 		sem_wait ( cout_mutex );
@@ -171,8 +399,11 @@ bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
 			<< ", blockOffset = " << blockOffset << reset << flush;
 		sem_post ( cout_mutex );
 	}
-	if ( tagArray[setNo][index].valid == true &&
-		tagArray[setNo][index].modified == true )
+	bool fromVictim = false, victimDirty = false;
+	if ( victimCache != NULL )
+		fromVictim = VictimSwap ( setNo, index, blockTag, victimDirty );
+	else if ( Valid ( setNo, index ) == true &&
+		Record ( setNo, index ).modified == true )
 	{
 		// We need to write back.
 		if ( verbose == true )
@@ -184,67 +415,72 @@ bool SimpleCache :: Read ( word_32 address, word_32 & result, int noOfBytes )
 				<< reset << flush;
 			sem_post ( cout_mutex );
 		}
-		int writeBaseAddress = tagArray[setNo][index].tag * wordsPerBlock * 4;
-		for ( int i = 0; i < wordsPerBlock; i++ )
-		{
-			if ( mem -> Write ( writeBaseAddress + (4*i), 
-				cache[setNo][index][i], 4) == false )
-			{
-				sem_wait ( cout_mutex );
-				cout << red << "\n[ SimpleCache::Read " << type << " "
-					<< level << "-level ] Write Back failed" 
-					<< reset << flush;
-				sem_post ( cout_mutex );
-			}
-		}
+		WriteBack ( setNo, index );
 	}
+	else if ( Valid ( setNo, index ) == true )
+		mem -> CleanEviction ( BlockAddress ( TagOf ( setNo, index ) ),
+			Line ( setNo, index ), wordsPerBlock );
 	
-	tagArray[setNo][index].tag = blockTag;
-	tagArray[setNo][index].valid = true;
-	tagArray[setNo][index].modified = false;
+	// Other caches supply / write back the line before we fetch it.
+	bool shared = false;
+	if ( bus != NULL && snooping == true )
+		shared = bus -> BusRead ( this, address );
 	
-	if ( verbose == true )
-	{
-		sem_wait ( cout_mutex );
-		cout << green << "\n[ SimpleCache::Read " << type << " "
-			<< level << "-level ] Fetching new block..."
-			<< reset << flush;
-		sem_post ( cout_mutex );
-	}
-
-	int readBaseAddress = blockTag * wordsPerBlock * 4;
-	for ( int i = 0; i < wordsPerBlock; i++ )
-	{
-		if ( mem -> Read ( readBaseAddress + (4*i),
-			cache[setNo][index][i], 4 ) == false )
-		{
-			sem_wait ( cout_mutex );
-			cout << red << "\n[ SimpleCache::Read " << type << " "
-				<< level << "-level ] Read from from lower level failed" 
-				<< reset << flush;
-			sem_post ( cout_mutex );
-		}
-	}
+	SetTag ( setNo, index, blockTag );
+	Record ( setNo, index ).modified = victimDirty;
+	Record ( setNo, index ).state = victimDirty ? MESI_MODIFIED :
+		shared ? MESI_SHARED : MESI_EXCLUSIVE;
+	Record ( setNo, index ).accessMask = 1u << ( blockOffset % 32 );
+	Record ( setNo, index ).prefetched = false;
+	
+	if ( fromVictim == true )
+		lastLatency = lastOccupancy = hitLatency + VICTIM_CACHE_LATENCY;
+	else if ( StreamLookup ( setNo, index, blockTag ) == false )
+		FetchBlock ( setNo, index, blockTag, blockOffset );
 	
 	readCount ++;
-	result = cache[setNo][index][blockOffset];
-	fifoIndex[setNo] = ( fifoIndex[setNo] + 1) % associativity;
+	CountRequester ( false );
+	result = Extract ( Line ( setNo, index )[blockOffset], address, noOfBytes );
+	replacement.Fill ( setNo, index );
 	return true;
 }
 
-bool SimpleCache :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+bool SimpleCache :: ReplayAccess ( word_32 address, bool write )
 {
-	if ( noOfBytes != 4 )
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	if ( shadowPolicy != NULL )
+		ObservePolicies ( setNo, blockTag );
+	if ( stackDistance != NULL )
+		stackDistance -> Observe ( blockTag );
+	
+	int index = FindInSet ( setNo, blockTag );
+	if ( missClassifier != NULL )
+		missClassifier -> Access ( setNo, blockTag, index != -1, 
+			write == false || writeAllocate == true );
+	if ( write == true ) writeCount ++;
+	else readCount ++;
+	if ( index != -1 )
 	{
-		// Feature not supported right now
-		sem_wait ( cout_mutex );
-		cout << red << "\n[ SimpleCache::Read_nofetch " << type << " "
-			<< level << "-level ] no of bytes != 4" 
-			<< reset << flush;
-		sem_post ( cout_mutex );
-		return false;
+		if ( write == true ) writeHitCount ++;
+		else readHitCount ++;
+		replacement.Touch ( setNo, index );
+		if ( write == true && writeThrough == false )
+			Record ( setNo, index ).modified = true;
+		return true;
 	}
-	if ( address % 4 != 0 )
+	if ( write == true && writeAllocate == false )
+		return false;
+	index = ChooseVictim ( setNo );
+	SetTag ( setNo, index, blockTag );
+	Record ( setNo, index ).modified = ( write == true && writeThrough == false );
+	replacement.Fill ( setNo, index );
+	return false;
+}
+
+bool SimpleCache :: Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+{
+	if ( Aligned ( address, noOfBytes ) == false )
 	{
 		// Alignment error
 		sem_wait ( cout_mutex );
@@ -255,44 +491,29 @@ bool SimpleCache :: Read_nofetch ( word_32 address, word_32 & result, int noOfBy
 		return false;
 	}
 	
-	int blockTag = ( address / 4 ) / ( wordsPerBlock );
-	int blockOffset = ( address / 4 ) % ( wordsPerBlock );
-	int setNo = blockTag % noOfSets;
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
 	
-	int indexInSet = -1;
-	for ( int i = 0; i < associativity; i++ )
-	{
-		if ( tagArray[setNo][i].valid == true &&
-			tagArray[setNo][i].tag == blockTag )
-		{
-			// Hit.
-			indexInSet = i;
-			break;
-		}
-	}
+	int indexInSet = FindInSet ( setNo, blockTag );
 	
 	if ( indexInSet != -1 )
 	{
-		result = cache[setNo][indexInSet][blockOffset];
+		result = Extract ( Line ( setNo, indexInSet )[blockOffset], address, noOfBytes );
+		return true;
+	}
+	int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+	if ( v != -1 )
+	{
+		result = Extract ( victimCache -> Entry ( v ).data[blockOffset], address, noOfBytes );
 		return true;
 	}
 	
 	return false;
 }
 
-bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
+bool SimpleCache :: Write_internal ( word_32 address, word_32 value, int noOfBytes )
 {
-	if ( noOfBytes != 4 )
-	{
-		// Feature not supported right now
-		sem_wait ( cout_mutex );
-		cout << red << "\n[ SimpleCache::Write " << type << " "
-			<< level << "-level ] no of bytes != 4" 
-			<< reset << flush;
-		sem_post ( cout_mutex );
-		return false;
-	}
-	if ( address % 4 != 0 )
+	if ( Aligned ( address, noOfBytes ) == false )
 	{
 		// Alignment error
 		sem_wait ( cout_mutex );
@@ -303,21 +524,17 @@ bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
 		return false;
 	}
 	
-	int blockTag = ( address / 4 ) / ( wordsPerBlock );
-	int blockOffset = ( address / 4 ) % ( wordsPerBlock );
-	int setNo = blockTag % noOfSets;
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	if ( shadowPolicy != NULL )
+		ObservePolicies ( setNo, blockTag );
+	if ( stackDistance != NULL )
+		stackDistance -> Observe ( blockTag );
+	BackgroundDrain ( );
 	
-	int indexInSet = -1;
-	for ( int i = 0; i < associativity; i++ )
-	{
-		if ( tagArray[setNo][i].valid == true &&
-			tagArray[setNo][i].tag == blockTag )
-		{
-			// Hit.
-			indexInSet = i;
-			break;
-		}
-	}
+	int indexInSet = FindInSet ( setNo, blockTag );
+	if ( missClassifier != NULL )
+		missClassifier -> Access ( setNo, blockTag, indexInSet != -1, writeAllocate );
 	
 	if ( indexInSet != -1 )
 	{
@@ -332,14 +549,62 @@ bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
 			sem_post ( cout_mutex );
 		}
 		writeCount ++;
-		writeHitCount ++;
+		lastLatency = lastOccupancy = hitLatency;
+		replacement.Touch ( setNo, indexInSet );
+		CountRequester ( FindMSHR ( blockTag ) == -1 );
+		if ( FindMSHR ( blockTag ) == -1 )
+			writeHitCount ++;
+		else
+			secondaryMisses ++;	// The MSHR takes the word
+		demandTag = blockTag;
+		DemandHit ( setNo, indexInSet );
+		
+		if ( bus != NULL && snooping == true && 
+				Record ( setNo, indexInSet ).state == MESI_SHARED )
+			bus -> BusUpgrade ( this, address );
 		
-		cache[setNo][indexInSet][blockOffset] = value;
-		tagArray[setNo][indexInSet].modified = true;
+		word_32 & word = Line ( setNo, indexInSet )[blockOffset];
+		word = Merge ( word, address, value, noOfBytes );
+		if ( stream != NULL )
+			StreamInvalidate ( blockTag );	// Its copy would go stale
+		Record ( setNo, indexInSet ).accessMask |= 1u << ( blockOffset % 32 );
+		if ( writeThrough == true )
+		{
+			mem -> SetClock ( clock + hitLatency );
+			lastLatency += WriteDown ( address & ~3, word, 4 );
+			lastOccupancy = lastLatency;
+			return true;
+		}
+		Record ( setNo, indexInSet ).modified = true;
+		Record ( setNo, indexInSet ).state = MESI_MODIFIED;
 		return true;
 	}
 	// We have a miss.
-	int index = fifoIndex[setNo];
+	DemandMiss ( setNo, blockTag );
+	if ( writeAllocate == false )
+	{
+		if ( verbose == true )
+		{
+			sem_wait ( cout_mutex );
+			cout << green << "\n[ SimpleCache::Write " << type << " "
+				<< level << "-level ] Miss, SetNo = " << setNo 
+				<< ", written to the lower level only" << reset << flush;
+			sem_post ( cout_mutex );
+		}
+		writeCount ++;
+		CountRequester ( false );
+		if ( stream != NULL )
+			StreamInvalidate ( blockTag );
+		int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+		if ( v != -1 )	// Keep it current
+			victimCache -> Entry ( v ).data[blockOffset] = 
+				Merge ( victimCache -> Entry ( v ).data[blockOffset], address, value, noOfBytes );
+		mem -> SetClock ( clock + hitLatency );
+		lastLatency = lastOccupancy = hitLatency + WriteDown ( address, value, noOfBytes );
+		return true;
+	}
+	int index = ChooseVictim ( setNo );
+	mem -> SetClock ( clock + hitLatency );	// for the write back
 	if ( verbose == true )
 	{
 		sem_wait ( cout_mutex );
@@ -349,8 +614,11 @@ bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
 			<< ", blockOffset = " << blockOffset << reset << flush;
 		sem_post ( cout_mutex );
 	}
-	if ( tagArray[setNo][index].valid == true &&
-		tagArray[setNo][index].modified == true )
+	bool fromVictim = false, victimDirty = false;
+	if ( victimCache != NULL )
+		fromVictim = VictimSwap ( setNo, index, blockTag, victimDirty );
+	else if ( Valid ( setNo, index ) == true &&
+		Record ( setNo, index ).modified == true )
 	{
 		// We need to write back.
 		if ( verbose == true )
@@ -362,100 +630,1249 @@ bool SimpleCache :: Write ( word_32 address, word_32 value, int noOfBytes )
 				<< reset << flush;
 			sem_post ( cout_mutex );
 		}
-		int writeBaseAddress = tagArray[setNo][index].tag * wordsPerBlock * 4;
-		for ( int i = 0; i < wordsPerBlock; i++ )
-		{
-			if ( mem -> Write ( writeBaseAddress + (4*i), 
-				cache[setNo][index][i], 4) == false )
-			{
-				sem_wait ( cout_mutex );
-				cout << red << "\n[ SimpleCache::Write " << type << " "
-					<< level << "-level ]"
-					<< " Writeback failed" 
-					<< reset << flush;
-				sem_post ( cout_mutex );
-			}
-		}
+		WriteBack ( setNo, index );
 	}
+	else if ( Valid ( setNo, index ) == true )
+		mem -> CleanEviction ( BlockAddress ( TagOf ( setNo, index ) ),
+			Line ( setNo, index ), wordsPerBlock );
+	
+	if ( bus != NULL && snooping == true )
+		bus -> BusReadExclusive ( this, address );
 	
-	tagArray[setNo][index].tag = blockTag;
-	tagArray[setNo][index].valid = true;
-	tagArray[setNo][index].modified = true;
+	SetTag ( setNo, index, blockTag );
+	Record ( setNo, index ).modified = true;
+	Record ( setNo, index ).state = MESI_MODIFIED;
+	Record ( setNo, index ).accessMask = 1u << ( blockOffset % 32 );
+	Record ( setNo, index ).prefetched = false;
 	
+	if ( fromVictim == true )
+		lastLatency = lastOccupancy = hitLatency + VICTIM_CACHE_LATENCY;
+	else if ( StreamLookup ( setNo, index, blockTag ) == false )
+	{
+		FetchBlock ( setNo, index, blockTag, blockOffset );
+		if ( noOfMSHRs > 0 )
+			lastLatency = lastOccupancy;	// The MSHR takes the word
+	}
+	
+	writeCount ++;
+	CountRequester ( false );
+	word_32 & word = Line ( setNo, index )[blockOffset];
+	word = Merge ( word, address, value, noOfBytes );
+	replacement.Fill ( setNo, index );
+	if ( writeThrough == true )
+	{
+		Record ( setNo, index ).modified = false;
+		lastLatency += WriteDown ( address & ~3, word, 4 );
+		if ( lastOccupancy < lastLatency ) lastOccupancy = lastLatency;
+	}
+	return true;
+}
+
+// Word i of the fill ( in the order fetched ) arrives at the latency the
+// lower level reports for it, but no sooner than one cycle after word
+// i-1: the first word pays the full latency, the rest stream in behind.
+void SimpleCache :: FetchBlock ( int setNo, int index, int blockTag, int blockOffset )
+{
 	if ( verbose == true )
 	{
 		sem_wait ( cout_mutex );
-		cout << green << "\n[ SimpleCache::Write " << type << " "
+		cout << green << "\n[ SimpleCache " << type << " "
 			<< level << "-level ] Fetching new block..."
 			<< reset << flush;
 		sem_post ( cout_mutex );
 	}
 	
-	int readBaseAddress = blockTag * wordsPerBlock * 4;
-	for ( int i = 0; i < wordsPerBlock; i++ )
+	int wait = 0;
+	int m = ( noOfMSHRs > 0 ) ? AllocateMSHR ( blockTag, wait ) : -1;
+	int start = clock + wait;
+	mem -> SetClock ( start + hitLatency );
+	
+	int first = ( fillPolicy == FILL_CRITICAL_WORD_FIRST ) ? blockOffset : 0;
+	int arrival = ReadFromBelow ( blockTag, Line ( setNo, index ), first );
+	int requestedArrival = wordArrival[blockOffset];
+	if ( m != -1 )
+		for ( int i = 0; i < wordsPerBlock; i++ )
+			mshr[m].wordReady[i] = start + hitLatency + wordArrival[i] - 1;
+	
+	lastOccupancy = hitLatency + arrival;
+	if ( fillPolicy == FILL_WHOLE_BLOCK )
+		lastLatency = lastOccupancy;
+	else
+		lastLatency = hitLatency + requestedArrival;
+	if ( m == -1 ) return;
+	
+	// The cache goes on with other accesses while the block arrives
+	SimpleCache_MSHR & e = mshr[m];
+	e.issuedAt = start;
+	e.doneAt = start + lastOccupancy - 1;
+	if ( fillPolicy == FILL_WHOLE_BLOCK )
+		for ( int i = 0; i < wordsPerBlock; i++ )
+			e.wordReady[i] = e.doneAt;
+	lastLatency += wait;
+	lastOccupancy = wait + hitLatency;
+	
+	mshrBusyCycles += e.doneAt - e.issuedAt + 1;
+	int from = ( e.issuedAt > coveredUntil ) ? e.issuedAt : coveredUntil + 1;
+	if ( e.doneAt >= from )
+		mshrCoveredCycles += e.doneAt - from + 1;
+	if ( e.doneAt > coveredUntil ) coveredUntil = e.doneAt;
+	if ( firstIssue == -1 ) firstIssue = e.issuedAt;
+	if ( e.doneAt > lastDone ) lastDone = e.doneAt;
+}
+
+int SimpleCache :: ReadFromBelow ( int blockTag, word_32 * data, int first )
+{
+	// Buffered writes to the block must reach the level below first
+	if ( writeBuffer != NULL )
+		bytesToBelow += writeBuffer -> DrainBlock ( BlockAddress ( blockTag ) );
+	bytesFromBelow += wordsPerBlock * 4;
+	mem -> SetPC ( accessPC );
+	mem -> SetRequester ( requester );
+	
+	if ( mem -> ReadBlock ( BlockAddress ( blockTag ), data, wordsPerBlock,
+			first, wordArrival ) == false )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Read from lower level failed" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+	return mem -> LastOccupancy ( );
+}
+
+int SimpleCache :: FindMSHR ( int blockTag )
+{
+	for ( int i = 0; i < noOfMSHRs; i++ )
+		if ( mshr[i].blockTag == blockTag && mshr[i].doneAt >= clock )
+			return i;
+	return -1;
+}
+
+int SimpleCache :: AllocateMSHR ( int blockTag, int & wait )
+{
+	// Take a free one, or else the one that frees up first
+	int pick = 0, inUse = 0;
+	for ( int i = 0; i < noOfMSHRs; i++ )
+	{
+		if ( mshr[i].doneAt >= clock ) inUse ++;
+		if ( mshr[i].doneAt < mshr[pick].doneAt ) pick = i;
+	}
+	wait = 0;
+	if ( mshr[pick].doneAt >= clock )
 	{
-		if ( mem -> Read ( readBaseAddress + (4*i),
-			cache[setNo][index][i], 4 ) == false )
+		wait = mshr[pick].doneAt - clock + 1;
+		mshrFullStalls ++;
+		mshrFullCycles += wait;
+		inUse --;
+		if ( verbose == true )
 		{
 			sem_wait ( cout_mutex );
-			cout << red << "\n[ SimpleCache::Write " << type << " "
-				<< level << "-level ] Read from lower level failed" 
-				<< reset << flush;
+			cout << green << "\n[ SimpleCache " << type << " "
+				<< level << "-level ] All MSHRs in use, waiting "
+				<< wait << " cycles" << reset << flush;
 			sem_post ( cout_mutex );
 		}
 	}
+	if ( inUse + 1 > peakMSHRs ) peakMSHRs = inUse + 1;
+	mshr[pick].blockTag = blockTag;
+	return pick;
+}
+
+int SimpleCache :: ChooseVictim ( int setNo )
+{
+	for ( int i = 0; i < associativity; i++ )
+		if ( Valid ( setNo, i ) == false )
+			return i;
 	
-	writeCount ++;
-	cache[setNo][index][blockOffset] = value;
-	fifoIndex[setNo] = ( fifoIndex[setNo] + 1) % associativity;
+	int victim = replacement.Victim ( setNo );
+	if ( inclusion == INCLUSION_INCLUSIVE )
+		Recall ( setNo, victim );
+	evictions ++;
+	if ( missClassifier != NULL )
+		missClassifier -> Evict ( setNo );
+	if ( Record ( setNo, victim ).modified == true )
+		dirtyEvictions ++;
+	if ( Record ( setNo, victim ).prefetched == true )
+		unusedPrefetches ++;
+	return victim;
+}
+
+/********************************************************************
+ * Victim cache
+ ********************************************************************/
+
+void SimpleCache :: SetVictimCache ( int entries )
+{
+	if ( victimCache != NULL )
+	{
+		victimCache -> AtExit ( );
+		delete victimCache;
+		victimCache = NULL;
+	}
+	if ( entries > 0 )
+		victimCache = new VictimCache ( entries, wordsPerBlock );
+}
+
+void SimpleCache :: VictimEvict ( int setNo, int index )
+{
+	SimpleCache_TagRecord & t = Record ( setNo, index );
+	if ( Valid ( setNo, index ) == false ) return;
+	
+	// Dirty lines go down only when they leave the victim cache
+	int i = victimCache -> Slot ( );
+	VictimCache_Entry & e = victimCache -> Entry ( i );
+	if ( e.valid == true && e.modified == true )
+	{
+		if ( stream != NULL )
+			StreamInvalidate ( e.blockTag );
+		WriteBlockDown ( e.blockTag, e.data );
+	}
+	else if ( e.valid == true )
+		mem -> CleanEviction ( BlockAddress ( e.blockTag ), e.data, wordsPerBlock );
+	victimCache -> Insert ( i, TagOf ( setNo, index ), Line ( setNo, index ), t.modified );
+	t.modified = false;
+}
+
+bool SimpleCache :: VictimSwap ( int setNo, int index, int blockTag, bool & dirty )
+{
+	int i = victimCache -> Lookup ( blockTag );
+	if ( i == -1 )
+	{
+		VictimEvict ( setNo, index );
+		return false;
+	}
+	
+	SimpleCache_TagRecord & t = Record ( setNo, index );
+	dirty = victimCache -> Swap ( i, Line ( setNo, index ), 
+		TagOf ( setNo, index ), t.modified );
+	t.modified = false;
+	if ( verbose == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << green << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Block " << blockTag 
+			<< " swapped back from the victim cache" << reset << flush;
+		sem_post ( cout_mutex );
+	}
 	return true;
 }
 
-void SimpleCache :: AtExit ( )
+// The bus takes the line away from the victim cache, as it would from
+// the cache itself.
+bool SimpleCache :: VictimSnoop ( int blockTag, bool & flushed )
+{
+	if ( victimCache == NULL ) return false;
+	int i = victimCache -> Find ( blockTag );
+	if ( i == -1 ) return false;
+	
+	VictimCache_Entry & e = victimCache -> Entry ( i );
+	if ( e.modified == true )
+	{
+		WriteBlockDown ( blockTag, e.data );
+		flushed = true;
+	}
+	victimCache -> Remove ( i );
+	return true;
+}
+
+/********************************************************************
+ * Prefetching
+ ********************************************************************/
+
+void SimpleCache :: SetPrefetcher ( PrefetchKind kind, int degree )
 {
+	delete[] candidate;
+	delete[] pollutionTag;
+	candidate = NULL;
+	pollutionTag = NULL;
+	if ( stream != NULL )
+	{
+		for ( int i = 0; i < prefetcher.Degree ( ); i++ )
+			delete[] stream[i].data;
+		delete[] stream;
+		stream = NULL;
+	}
+	
+	prefetcher.Initialise ( kind, degree );
+	if ( kind == PREFETCH_NONE ) return;
+	candidate = new int [prefetcher.Degree ( )];
+	pollutionTag = new int [noOfSets];
 	for ( int i = 0; i < noOfSets; i++ )
+		pollutionTag[i] = -1;
+	if ( kind != PREFETCH_STREAM ) return;
+	stream = new SimpleCache_StreamEntry [prefetcher.Degree ( )];
+	for ( int i = 0; i < prefetcher.Degree ( ); i++ )
+		stream[i].data = new word_32 [wordsPerBlock];
+	streamHead = streamCount = 0;
+}
+
+// The first demand use of a prefetched line makes the prefetch useful,
+// and late if the line is still arriving.
+void SimpleCache :: DemandHit ( int setNo, int index )
+{
+	SimpleCache_TagRecord & t = Record ( setNo, index );
+	demandTrigger = false;
+	if ( t.prefetched == false ) return;
+	
+	t.prefetched = false;
+	usefulPrefetches ++;
+	demandTrigger = true;
+	if ( t.readyAt >= clock + hitLatency )
 	{
-		for ( int j = 0; j < associativity; j++ )
-			delete[] cache[i][j];
-		delete[] cache[i];
-		delete[] tagArray[i];
+		latePrefetches ++;
+		lastLatency = t.readyAt - clock + 1;
+		lastOccupancy = lastLatency;
 	}
-	delete[] cache;
-	delete[] tagArray;
-	delete[] fifoIndex;
 }
 
-void SimpleCache :: Statistics ( )
+void SimpleCache :: DemandMiss ( int setNo, int blockTag )
 {
-	cout << green << "\n[ SimpleCache::Statistics ] Statistics for the "
-		<< level << "-level \n\t" << type << " cache are displayed"
-		<< reset << flush;
-	cout << "\nNumber of Blocks : " << noOfBlocks
-		<< "\nWords per block : " << wordsPerBlock
-		<< "\nAssociativity : " << associativity
-		<< "\nNumber of sets : " << noOfSets
-		<< "\nTotal Cache Size in Bytes : " << noOfBlocks * wordsPerBlock * 4
-		
-		<< "\n\nTotal Number of reads : " << readCount
-		<< "\nTotal Number of read Hits : " << readHitCount
-		<< "\nTotal Number of read Misses : " << readCount - readHitCount
-		<< "\nRead Hit Ratio : " 
-		<< ((readCount != 0 ) ? static_cast<double>(readHitCount) / readCount : 0)
-		
-		<< "\n\nTotal Number of writes : " << writeCount
-		<< "\nTotal Number of write Hits : " << writeHitCount
-		<< "\nTotal Number of write Misses : " << writeCount - writeHitCount
-		<< "\nWrite Hit Ratio : " 
-		<< ((writeCount != 0 ) ? static_cast<double>(writeHitCount) / writeCount : 0)
-		
-		<< "\n\nTotal Number of accesses : " << readCount + writeCount
-		<< "\nTotal Number of Hits : " << readHitCount + writeHitCount
+	demandTag = blockTag;
+	demandTrigger = true;
+	if ( pollutionTag != NULL && pollutionTag[setNo] == blockTag )
+	{
+		pollutionMisses ++;
+		pollutionTag[setNo] = -1;
+	}
+}
+
+void SimpleCache :: IssuePrefetches ( )
+{
+	if ( demandTag == -1 ) return;
+	int blockTag = demandTag;
+	demandTag = -1;
+	if ( prefetcher.Kind ( ) == PREFETCH_NONE ) return;
+	
+	// Behind the access that triggered them
+	int start = clock + lastOccupancy;
+	if ( stream != NULL )
+	{
+		if ( bus != NULL ) bus -> Lock ( );
+		StreamFill ( start );
+		if ( bus != NULL ) bus -> Unlock ( );
+		return;
+	}
+	
+	int n = prefetcher.Candidates ( blockTag, accessPC, demandTrigger, candidate );
+	if ( n == 0 ) return;
+	if ( bus != NULL ) bus -> Lock ( );
+	for ( int i = 0; i < n; i++ )
+	{
+		if ( bus != NULL ) bus -> LockSet ( BlockAddress ( candidate[i] ) );
+		PrefetchBlock ( candidate[i], start );
+		if ( bus != NULL ) bus -> UnlockSet ( BlockAddress ( candidate[i] ) );
+	}
+	if ( bus != NULL ) bus -> Unlock ( );
+}
+
+void SimpleCache :: PrefetchBlock ( int blockTag, int start )
+{
+	int setNo = SetOf ( blockTag );
+	if ( FindInSet ( setNo, blockTag ) != -1 || FindMSHR ( blockTag ) != -1 )
+		return;
+	if ( victimCache != NULL && victimCache -> Find ( blockTag ) != -1 )
+		return;
+	
+	int index = ChooseVictim ( setNo );
+	mem -> SetClock ( start );
+	SimpleCache_TagRecord & t = Record ( setNo, index );
+	if ( Valid ( setNo, index ) == true )
+	{
+		pollutionTag[setNo] = TagOf ( setNo, index );
+		if ( victimCache != NULL )
+			VictimEvict ( setNo, index );
+		else if ( t.modified == true )
+			WriteBack ( setNo, index );
+		else
+			mem -> CleanEviction ( BlockAddress ( TagOf ( setNo, index ) ),
+				Line ( setNo, index ), wordsPerBlock );
+	}
+	
+	bool shared = false;
+	if ( bus != NULL && snooping == true )
+		shared = bus -> BusRead ( this, BlockAddress ( blockTag ) );
+	
+	SetTag ( setNo, index, blockTag );
+	t.modified = false;
+	t.state = shared ? MESI_SHARED : MESI_EXCLUSIVE;
+	t.accessMask = 0;
+	t.prefetched = true;
+	t.readyAt = start + ReadFromBelow ( blockTag, Line ( setNo, index ), 0 ) - 1;
+	replacement.Fill ( setNo, index );
+	prefetchesIssued ++;
+	
+	if ( verbose == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << green << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Prefetched block " << blockTag 
+			<< " into SetNo = " << setNo << ", indexInSet = " << index
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+}
+
+// Any miss that does not find its block at the head of the buffer
+// restarts it at the following block.
+bool SimpleCache :: StreamLookup ( int setNo, int index, int blockTag )
+{
+	if ( stream == NULL ) return false;
+	SimpleCache_StreamEntry & e = stream[streamHead];
+	if ( streamCount == 0 || e.blockTag != blockTag )
+	{
+		for ( int i = 0; i < streamCount; i++ )
+			if ( stream[( streamHead + i ) % prefetcher.Degree ( )].blockTag != -1 )
+				unusedPrefetches ++;
+		streamCount = 0;
+		streamNextTag = blockTag + 1;
+		return false;
+	}
+	
+	for ( int i = 0; i < wordsPerBlock; i++ )
+		Line ( setNo, index )[i] = e.data[i];
+	usefulPrefetches ++;
+	lastLatency = hitLatency;
+	if ( e.readyAt >= clock + hitLatency )
+	{
+		latePrefetches ++;
+		lastLatency = e.readyAt - clock + 1;
+	}
+	lastOccupancy = lastLatency;
+	streamHead = ( streamHead + 1 ) % prefetcher.Degree ( );
+	streamCount --;
+	
+	if ( verbose == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << green << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Block " << blockTag 
+			<< " taken from the stream buffer" << reset << flush;
+		sem_post ( cout_mutex );
+	}
+	return true;
+}
+
+void SimpleCache :: StreamFill ( int start )
+{
+	mem -> SetClock ( start );
+	while ( streamCount < prefetcher.Degree ( ) )
+	{
+		SimpleCache_StreamEntry & e = 
+			stream[( streamHead + streamCount ) % prefetcher.Degree ( )];
+		e.blockTag = streamNextTag ++;
+		e.readyAt = start + ReadFromBelow ( e.blockTag, e.data, 0 ) - 1;
+		streamCount ++;
+		prefetchesIssued ++;
+	}
+}
+
+void SimpleCache :: StreamInvalidate ( int blockTag )
+{
+	for ( int i = 0; i < streamCount; i++ )
+	{
+		SimpleCache_StreamEntry & e = stream[( streamHead + i ) % prefetcher.Degree ( )];
+		if ( e.blockTag == blockTag ) e.blockTag = -1;
+	}
+}
+
+void SimpleCache :: SetReplacement ( ReplacementPolicy policy, unsigned int seed )
+{
+	replacement.Initialise ( policy, noOfSets, associativity, seed );
+}
+
+void SimpleCache :: ComparePolicies ( unsigned int seed )
+{
+	if ( shadowPolicy != NULL ) return;
+	shadowPolicy = new Replacement [NO_OF_REPL_POLICIES];
+	shadowTags = new int * [NO_OF_REPL_POLICIES];
+	for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+	{
+		shadowPolicy[p].Initialise ( static_cast<ReplacementPolicy>(p), 
+			noOfSets, associativity, seed );
+		shadowTags[p] = new int [noOfSets * associativity];
+		for ( int i = 0; i < noOfSets * associativity; i++ )
+			shadowTags[p][i] = -1;
+		shadowHits[p] = 0;
+	}
+}
+
+void SimpleCache :: ProfileStackDistances ( const char * csv, int maxSets, int maxWays )
+{
+	if ( stackDistance != NULL ) return;
+	stackDistance = new StackDistance ( wordsPerBlock * 4, csv, maxSets, maxWays );
+}
+
+void SimpleCache :: ClassifyMisses ( )
+{
+	if ( missClassifier != NULL ) return;
+	missClassifier = new MissClassifier ( noOfSets, noOfBlocks );
+}
+
+// Plays the access on the tag-only copy of every policy.
+void SimpleCache :: ObservePolicies ( int setNo, int blockTag )
+{
+	shadowAccesses ++;
+	for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+	{
+		int * tags = shadowTags[p] + setNo * associativity;
+		int way = -1, empty = -1;
+		for ( int i = 0; i < associativity; i++ )
+		{
+			if ( tags[i] == blockTag ) { way = i; break; }
+			if ( tags[i] == -1 && empty == -1 ) empty = i;
+		}
+		if ( way != -1 )
+		{
+			shadowHits[p] ++;
+			shadowPolicy[p].Touch ( setNo, way );
+			continue;
+		}
+		way = ( empty != -1 ) ? empty : shadowPolicy[p].Victim ( setNo );
+		tags[way] = blockTag;
+		shadowPolicy[p].Fill ( setNo, way );
+	}
+}
+
+void SimpleCache :: SetMSHRs ( int count )
+{
+	for ( int i = 0; i < noOfMSHRs; i++ )
+		delete[] mshr[i].wordReady;
+	delete[] mshr;
+	mshr = NULL;
+	
+	noOfMSHRs = ( count > 0 ) ? count : 0;
+	if ( noOfMSHRs == 0 ) return;
+	mshr = new SimpleCache_MSHR [noOfMSHRs];
+	for ( int i = 0; i < noOfMSHRs; i++ )
+		mshr[i].wordReady = new int [wordsPerBlock];
+}
+
+void SimpleCache :: SetFillPolicy ( FillPolicy policy )
+{
+	fillPolicy = policy;
+}
+
+/********************************************************************
+ * Coherence support
+ ********************************************************************/
+
+// Compares a whole vector of ways at a time; the padding ways of a row
+// hold -1 like invalid ones, and no block has the tag -1.
+int SimpleCache :: FindInSet ( int setNo, int blockTag )
+{
+	const int * row = tags + setNo * tagStride;
+# if defined ( __AVX2__ )
+	__m256i key = _mm256_set1_epi32 ( blockTag );
+	for ( int i = 0; i < tagStride; i += TAG_VECTOR )
+	{
+		__m256i v = _mm256_load_si256 ( reinterpret_cast<const __m256i *>( row + i ) );
+		int mask = _mm256_movemask_ps ( _mm256_castsi256_ps ( 
+			_mm256_cmpeq_epi32 ( v, key ) ) );
+		if ( mask != 0 )
+			return i + __builtin_ctz ( mask );
+	}
+	return -1;
+# elif defined ( __SSE2__ )
+	__m128i key = _mm_set1_epi32 ( blockTag );
+	for ( int i = 0; i < tagStride; i += TAG_VECTOR )
+	{
+		__m128i v = _mm_load_si128 ( reinterpret_cast<const __m128i *>( row + i ) );
+		int mask = _mm_movemask_ps ( _mm_castsi128_ps ( _mm_cmpeq_epi32 ( v, key ) ) );
+		if ( mask != 0 )
+			return i + __builtin_ctz ( mask );
+	}
+	return -1;
+# else
+	for ( int i = 0; i < associativity; i++ )
+		if ( row[i] == blockTag )
+			return i;
+	return -1;
+# endif
+}
+
+const char * SimpleCache :: LookupPath ( )
+{
+# if defined ( __AVX2__ )
+	return "AVX2";
+# elif defined ( __SSE2__ )
+	return "SSE2";
+# else
+	return "scalar";
+# endif
+}
+
+void SimpleCache :: WriteBack ( int setNo, int index )
+{
+	WriteBlockDown ( TagOf ( setNo, index ), Line ( setNo, index ) );
+	Record ( setNo, index ).modified = false;
+}
+
+void SimpleCache :: WriteBlockDown ( int blockTag, word_32 * data )
+{
+	word_32 writeBaseAddress = BlockAddress ( blockTag );
+	mem -> SetRequester ( requester );
+	if ( writeBuffer != NULL )
+	{
+		for ( int i = 0; i < wordsPerBlock; i++ )
+			WriteDown ( writeBaseAddress + (4*i), data[i] );
+		return;
+	}
+	
+	if ( mem -> WriteBlock ( writeBaseAddress, data, wordsPerBlock ) == false )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Write to lower level failed" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+	bytesToBelow += wordsPerBlock * 4;
+}
+
+int SimpleCache :: WriteDown ( word_32 address, word_32 value, int noOfBytes )
+{
+	if ( writeBuffer != NULL && noOfBytes == 4 )
+	{
+		int bytes = writeBuffer -> Insert ( address, value );
+		bytesToBelow += bytes;
+		return ( bytes > 0 ) ? mem -> LastLatency ( ) : 0;	// drained one first
+	}
+	
+	// The buffer holds whole words, so a part of one goes past it, after
+	// whatever the buffer holds for the block.
+	if ( writeBuffer != NULL )
+		bytesToBelow += writeBuffer -> DrainBlock ( 
+			static_cast<u_word_32>( address ) / ( wordsPerBlock * 4 ) * wordsPerBlock * 4 );
+	if ( mem -> Write ( address, value, noOfBytes ) == false )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Write to lower level failed" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+	}
+	bytesToBelow += noOfBytes;
+	return mem -> LastLatency ( );
+}
+
+// The write buffer gets the level below whenever its last drain is done.
+void SimpleCache :: BackgroundDrain ( )
+{
+	if ( writeBuffer == NULL || writeBuffer -> Empty ( ) || clock < drainReadyAt )
+		return;
+	mem -> SetClock ( clock );
+	bytesToBelow += writeBuffer -> DrainOldest ( );
+	drainReadyAt = clock + mem -> LastLatency ( );
+}
+
+void SimpleCache :: SetWritePolicy ( bool through, bool allocate, int bufferEntries )
+{
+	writeThrough = through;
+	writeAllocate = allocate;
+	if ( writeBuffer != NULL )
+	{
+		writeBuffer -> AtExit ( );
+		delete writeBuffer;
+		writeBuffer = NULL;
+	}
+	if ( bufferEntries > 0 )
+		writeBuffer = new WriteBuffer ( mem, bufferEntries, wordsPerBlock );
+}
+
+void SimpleCache :: AttachBus ( CoherenceBus * b, int core, bool snoop )
+{
+	bus = b;
+	snooping = snoop;
+	bus -> AttachCache ( this, core, snoop, noOfSets );
+}
+
+// A hit needs the bus if it writes a line other caches may hold, or if
+// anything beside the set ( the level below, a write or victim buffer,
+// stream buffers ) takes part in the access.
+bool SimpleCache :: NeedsBus ( word_32 address, bool write )
+{
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	int index = FindInSet ( setNo, blockTag );
+	if ( index == -1 || writeThrough == true || writeBuffer != NULL ||
+			victimCache != NULL || stream != NULL )
+		return true;
+	return write == true && Record ( setNo, index ).state != MESI_MODIFIED &&
+		Record ( setNo, index ).state != MESI_EXCLUSIVE;
+}
+
+// The bus lock always comes before a set lock, so a miss lets go of the
+// set and takes both in order; the line may have moved meanwhile, which
+// the access itself then finds out.
+void SimpleCache :: LockForAccess ( word_32 address, bool write, bool & wide )
+{
+	bus -> LockSet ( address );
+	wide = NeedsBus ( address, write );
+	if ( wide == false ) return;
+	bus -> UnlockSet ( address );
+	bus -> Lock ( );
+	bus -> LockSet ( address );
+}
+
+void SimpleCache :: UnlockForAccess ( word_32 address, bool wide )
+{
+	bus -> UnlockSet ( address );
+	if ( wide == true ) bus -> Unlock ( );
+}
+
+int SimpleCache :: LineBytes ( )
+{
+	return wordsPerBlock * 4;
+}
+
+bool SimpleCache :: SnoopRead ( word_32 address, bool & flushed )
+{
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	int index = FindInSet ( setNo, blockTag );
+	
+	flushed = false;
+	if ( index == -1 ) return VictimSnoop ( blockTag, flushed );
+	
+	if ( Record ( setNo, index ).state == MESI_MODIFIED )
+	{
+		WriteBack ( setNo, index );
+		flushed = true;
+	}
+	Record ( setNo, index ).state = MESI_SHARED;
+	
+	if ( verbose == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << green << "\n[ SimpleCache::SnoopRead " << type << " "
+			<< level << "-level ] SetNo = " << setNo << ", indexInSet = " 
+			<< index << " now Shared" << reset << flush;
+		sem_post ( cout_mutex );
+	}
+	return true;
+}
+
+bool SimpleCache :: SnoopInvalidate ( word_32 address, bool & flushed, bool & wordTouched )
+{
+	int blockTag, blockOffset, setNo;
+	Locate ( address, blockTag, blockOffset, setNo );
+	int index = FindInSet ( setNo, blockTag );
+	
+	flushed = false;
+	wordTouched = false;
+	if ( stream != NULL )
+		StreamInvalidate ( blockTag );
+	if ( index == -1 ) return VictimSnoop ( blockTag, flushed );
+	
+	if ( Record ( setNo, index ).state == MESI_MODIFIED )
+	{
+		WriteBack ( setNo, index );
+		flushed = true;
+	}
+	wordTouched = ( Record ( setNo, index ).accessMask & 
+		( 1u << ( blockOffset % 32 ) ) ) != 0;
+	
+	SetTag ( setNo, index, -1 );
+	Record ( setNo, index ).modified = false;
+	Record ( setNo, index ).state = MESI_INVALID;
+	Record ( setNo, index ).accessMask = 0;
+	
+	if ( verbose == true )
+	{
+		sem_wait ( cout_mutex );
+		cout << green << "\n[ SimpleCache::SnoopInvalidate " << type << " "
+			<< level << "-level ] SetNo = " << setNo << ", indexInSet = " 
+			<< index << " invalidated" << reset << flush;
+		sem_post ( cout_mutex );
+	}
+	return true;
+}
+
+/********************************************************************
+ * Shared hierarchies
+ ********************************************************************/
+
+void SimpleCache :: SetInclusion ( InclusionPolicy policy )
+{
+	inclusion = policy;
+}
+
+InclusionPolicy SimpleCache :: Inclusion ( )
+{
+	return inclusion;
+}
+
+void SimpleCache :: AddUpper ( SimpleCache * above )
+{
+	if ( noOfUppers == MAX_UPPER_CACHES )
+	{
+		sem_wait ( cout_mutex );
+		cout << red << "\n[ SimpleCache " << type << " "
+			<< level << "-level ] Too many caches above" 
+			<< reset << flush;
+		sem_post ( cout_mutex );
+		return;
+	}
+	upper[noOfUppers ++] = above;
+	if ( hierarchyLock != NULL )
+		above -> SetHierarchyLock ( hierarchyLock );
+}
+
+void SimpleCache :: SetHierarchyLock ( pthread_mutex_t * lock )
+{
+	hierarchyLock = lock;
+	for ( int u = 0; u < noOfUppers; u++ )
+		upper[u] -> SetHierarchyLock ( lock );
+}
+
+void SimpleCache :: CountRequester ( bool hit )
+{
+	if ( requester < 0 || requester >= NO_OF_REQUESTERS ) return;
+	requesterAccesses[requester] ++;
+	if ( hit == true )
+		requesterHits[requester] ++;
+}
+
+// The caches above give the line up, along with any newer data
+void SimpleCache :: Recall ( int setNo, int index )
+{
+	bool dirty = false;
+	for ( int u = 0; u < noOfUppers; u++ )
+		if ( upper[u] -> BackInvalidate ( BlockAddress ( TagOf ( setNo, index ) ),
+				wordsPerBlock, Line ( setNo, index ) ) == true )
+			dirty = true;
+	recalls ++;
+	if ( dirty == true )
+	{
+		dirtyRecalls ++;
+		Record ( setNo, index ).modified = true;
+		Record ( setNo, index ).state = MESI_MODIFIED;
+	}
+}
+
+// This cache's own copy goes in first, then those from above, which
+// are newer.
+bool SimpleCache :: BackInvalidate ( word_32 address, int noOfWords, word_32 * words )
+{
+	bool dirty = false;
+	int n = 0;
+	while ( n < noOfWords )
+	{
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * n, blockTag, blockOffset, setNo );
+		int count = wordsPerBlock - blockOffset;
+		if ( count > noOfWords - n ) count = noOfWords - n;
+		
+		if ( stream != NULL )
+			StreamInvalidate ( blockTag );
+		int index = FindInSet ( setNo, blockTag );
+		int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+		if ( index != -1 )
+		{
+			SimpleCache_TagRecord & t = Record ( setNo, index );
+			if ( t.modified == true )
+			{
+				for ( int i = 0; i < count; i++ )
+					words[n + i] = Line ( setNo, index )[blockOffset + i];
+				dirty = true;
+			}
+			if ( t.prefetched == true )
+				unusedPrefetches ++;
+			SetTag ( setNo, index, -1 );
+			t.modified = false;
+			t.state = MESI_INVALID;
+			t.accessMask = 0;
+			t.prefetched = false;
+			backInvalidations ++;
+		}
+		else if ( v != -1 )
+		{
+			VictimCache_Entry & e = victimCache -> Entry ( v );
+			if ( e.modified == true )
+			{
+				for ( int i = 0; i < count; i++ )
+					words[n + i] = e.data[blockOffset + i];
+				dirty = true;
+			}
+			victimCache -> Remove ( v );
+			backInvalidations ++;
+		}
+		n += count;
+	}
+	
+	for ( int u = 0; u < noOfUppers; u++ )
+		if ( upper[u] -> BackInvalidate ( address, noOfWords, words ) == true )
+			dirty = true;
+	return dirty;
+}
+
+// The line leaves for the level above, which gets it unmodified; so a
+// modified line is written back first.
+void SimpleCache :: MoveUp ( int setNo, int index )
+{
+	SimpleCache_TagRecord & t = Record ( setNo, index );
+	if ( t.modified == true )
+	{
+		mem -> SetClock ( clock + hitLatency );
+		WriteBack ( setNo, index );
+	}
+	SetTag ( setNo, index, -1 );
+	t.modified = false;
+	t.state = MESI_INVALID;
+	t.accessMask = 0;
+	t.prefetched = false;
+	linesMovedUp ++;
+}
+
+void SimpleCache :: InstallLine ( int blockTag, word_32 * words, bool modified )
+{
+	int setNo = SetOf ( blockTag );
+	int index = FindInSet ( setNo, blockTag );
+	int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+	if ( v != -1 )
+		victimCache -> Remove ( v );	// The words from above are newer
+	if ( index == -1 )
+	{
+		index = ChooseVictim ( setNo );
+		mem -> SetClock ( clock + hitLatency );
+		SimpleCache_TagRecord & t = Record ( setNo, index );
+		if ( Valid ( setNo, index ) == true )
+		{
+			if ( victimCache != NULL )
+				VictimEvict ( setNo, index );
+			else if ( t.modified == true )
+				WriteBack ( setNo, index );
+		}
+		SetTag ( setNo, index, blockTag );
+		t.modified = false;
+		t.state = MESI_EXCLUSIVE;
+		t.accessMask = 0;
+		t.prefetched = false;
+		replacement.Fill ( setNo, index );
+		linesFromAbove ++;
+	}
+	else
+		replacement.Touch ( setNo, index );
+	
+	for ( int i = 0; i < wordsPerBlock; i++ )
+		Line ( setNo, index )[i] = words[i];
+	if ( modified == true )
+	{
+		Record ( setNo, index ).modified = true;
+		Record ( setNo, index ).state = MESI_MODIFIED;
+	}
+}
+
+// A fill for the level above.  A line found here moves up; one that is
+// not is read from below without being allocated.  The words come in
+// address order.
+bool SimpleCache :: ExclusiveReadBlock ( word_32 address, word_32 * data, int noOfWords,
+	int first, int * arrival )
+{
+	bool ret = true;
+	int ready = 0, firstReady = 0;
+	int n = 0;
+	BackgroundDrain ( );
+	while ( n < noOfWords )
+	{
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * n, blockTag, blockOffset, setNo );
+		int count = wordsPerBlock - blockOffset;
+		if ( count > noOfWords - n ) count = noOfWords - n;
+		
+		int index = FindInSet ( setNo, blockTag );
+		bool inVictim = index == -1 && victimCache != NULL && 
+			victimCache -> Find ( blockTag ) != -1;
+		readCount ++;
+		CountRequester ( index != -1 || inVictim );
+		if ( index != -1 )
+		{
+			readHitCount ++;
+			for ( int i = 0; i < count; i++ )
+			{
+				data[n + i] = Line ( setNo, index )[blockOffset + i];
+				wordArrival[i] = ( i == 0 ) ? hitLatency : wordArrival[i - 1] + 1;
+			}
+			MoveUp ( setNo, index );
+		}
+		else if ( inVictim == true )
+		{
+			int v = victimCache -> Lookup ( blockTag );
+			VictimCache_Entry & e = victimCache -> Entry ( v );
+			readHitCount ++;
+			for ( int i = 0; i < count; i++ )
+			{
+				data[n + i] = e.data[blockOffset + i];
+				wordArrival[i] = ( i == 0 ) ? hitLatency + VICTIM_CACHE_LATENCY : 
+					wordArrival[i - 1] + 1;
+			}
+			if ( e.modified == true )
+			{
+				mem -> SetClock ( clock + hitLatency );
+				WriteBlockDown ( blockTag, e.data );
+			}
+			victimCache -> Remove ( v );
+			linesMovedUp ++;
+		}
+		else
+		{
+			if ( writeBuffer != NULL )
+				bytesToBelow += writeBuffer -> DrainBlock ( BlockAddress ( blockTag ) );
+			mem -> SetClock ( clock + hitLatency );
+			mem -> SetPC ( accessPC );
+			mem -> SetRequester ( requester );
+			if ( mem -> ReadBlock ( address + 4 * n, data + n, count, 0, 
+					wordArrival ) == false )
+				ret = false;
+			bytesFromBelow += count * 4;
+			for ( int i = 0; i < count; i++ )
+				wordArrival[i] += hitLatency;
+		}
+		for ( int i = 0; i < count; i++ )
+		{
+			ready = ( n + i == 0 || wordArrival[i] > ready + 1 ) ? 
+				wordArrival[i] : ready + 1;
+			if ( n + i == first ) firstReady = ready;
+			if ( arrival != NULL ) arrival[n + i] = ready;
+		}
+		n += count;
+	}
+	AccountAccess ( );
+	lastLatency = firstReady;
+	lastOccupancy = ready;
+	return ret;
+}
+
+// A line here takes the words; whole lines that are not are put in
+// without a fetch, parts of them go straight down.
+bool SimpleCache :: ExclusiveWriteBlock ( word_32 address, word_32 * data, int noOfWords )
+{
+	bool ret = true;
+	int n = 0;
+	BackgroundDrain ( );
+	while ( n < noOfWords )
+	{
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * n, blockTag, blockOffset, setNo );
+		int count = wordsPerBlock - blockOffset;
+		if ( count > noOfWords - n ) count = noOfWords - n;
+		
+		int index = FindInSet ( setNo, blockTag );
+		writeCount ++;
+		CountRequester ( index != -1 );
+		if ( index != -1 )
+		{
+			writeHitCount ++;
+			for ( int i = 0; i < count; i++ )
+				Line ( setNo, index )[blockOffset + i] = data[n + i];
+			Record ( setNo, index ).modified = true;
+			Record ( setNo, index ).state = MESI_MODIFIED;
+			replacement.Touch ( setNo, index );
+		}
+		else if ( count == wordsPerBlock )
+			InstallLine ( blockTag, data + n, true );
+		else
+		{
+			if ( writeBuffer != NULL )
+				bytesToBelow += writeBuffer -> DrainBlock ( BlockAddress ( blockTag ) );
+			int v = ( victimCache != NULL ) ? victimCache -> Find ( blockTag ) : -1;
+			if ( v != -1 )
+				for ( int i = 0; i < count; i++ )	// Keep it current
+					victimCache -> Entry ( v ).data[blockOffset + i] = data[n + i];
+			mem -> SetClock ( clock + hitLatency );
+			mem -> SetRequester ( requester );
+			if ( mem -> WriteBlock ( address + 4 * n, data + n, count ) == false )
+				ret = false;
+			bytesToBelow += count * 4;
+		}
+		n += count;
+	}
+	lastLatency = hitLatency;
+	lastOccupancy = hitLatency + noOfWords - 1;
+	AccountAccess ( );
+	return ret;
+}
+
+void SimpleCache :: CleanEviction ( word_32 address, word_32 * words, int noOfWords )
+{
+	if ( inclusion != INCLUSION_EXCLUSIVE ) return;
+	int n = 0;
+	while ( n < noOfWords )
+	{
+		int blockTag, blockOffset, setNo;
+		Locate ( address + 4 * n, blockTag, blockOffset, setNo );
+		if ( blockOffset != 0 || noOfWords - n < wordsPerBlock )
+		{
+			n ++;	// Only whole lines can be kept
+			continue;
+		}
+		if ( FindInSet ( setNo, blockTag ) == -1 )
+			InstallLine ( blockTag, words + n, false );
+		n += wordsPerBlock;
+	}
+}
+
+void SimpleCache :: AtExit ( )
+{
+	free ( data );
+	free ( tags );
+	delete[] tagArray;
+	replacement.AtExit ( );
+	SetWritePolicy ( false, true, 0 );
+	SetPrefetcher ( PREFETCH_NONE, 0 );
+	SetVictimCache ( 0 );
+	delete[] wordArrival;
+	if ( shadowPolicy != NULL )
+	{
+		for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+		{
+			shadowPolicy[p].AtExit ( );
+			delete[] shadowTags[p];
+		}
+		delete[] shadowPolicy;
+		delete[] shadowTags;
+	}
+	if ( stackDistance != NULL )
+	{
+		stackDistance -> AtExit ( );
+		delete stackDistance;
+		stackDistance = NULL;
+	}
+	if ( missClassifier != NULL )
+	{
+		missClassifier -> AtExit ( );
+		delete missClassifier;
+		missClassifier = NULL;
+	}
+	SetMSHRs ( 0 );
+}
+
+bool SimpleCache :: Totals ( word_64 & accesses, word_64 & hits )
+{
+	accesses = readCount + writeCount;
+	hits = readHitCount + writeHitCount;
+	return true;
+}
+
+void SimpleCache :: Statistics ( )
+{
+	cout << green << "\n[ SimpleCache::Statistics ] Statistics for the "
+		<< level << "-level \n\t" << type << " cache are displayed"
+		<< reset << flush;
+	cout << "\nNumber of Blocks : " << noOfBlocks
+		<< "\nWords per block : " << wordsPerBlock
+		<< "\nAssociativity : " << associativity
+		<< "\nNumber of sets : " << noOfSets
+		<< "\nTotal Cache Size in Bytes : " << noOfBlocks * wordsPerBlock * 4
+		
+		<< "\n\nTotal Number of reads : " << readCount
+		<< "\nTotal Number of read Hits : " << readHitCount
+		<< "\nTotal Number of read Misses : " << readCount - readHitCount
+		<< "\nRead Hit Ratio : " 
+		<< ((readCount != 0 ) ? static_cast<double>(readHitCount) / readCount : 0)
+		
+		<< "\n\nTotal Number of writes : " << writeCount
+		<< "\nTotal Number of write Hits : " << writeHitCount
+		<< "\nTotal Number of write Misses : " << writeCount - writeHitCount
+		<< "\nWrite Hit Ratio : " 
+		<< ((writeCount != 0 ) ? static_cast<double>(writeHitCount) / writeCount : 0)
+		
+		<< "\n\nTotal Number of accesses : " << readCount + writeCount
+		<< "\nTotal Number of Hits : " << readHitCount + writeHitCount
 		<< "\nTotal Number of Misses : " 
 		<< ( readCount + writeCount ) - ( readHitCount + writeHitCount )
 		<< "\nOverall Hit Ratio : " 
 		<< (( (readCount + writeCount) != 0 ) ?  static_cast<double>
 			( readHitCount + writeHitCount) / ( readCount + writeCount ) : 0)
-		<< flush;
+		
+		<< "\n\nHit latency : " << hitLatency << " cycles, "
+		<< ( fillPolicy == FILL_WHOLE_BLOCK ? "whole block fill" :
+			fillPolicy == FILL_EARLY_RESTART ? "early restart" :
+				"critical word first" )
+		<< "\nAverage memory access time : " << AverageAccessTime ( ) 
+		<< " cycles"
+		<< "\n\nReplacement : " << Replacement::Name ( replacement.Policy ( ) )
+		<< "\nEvictions : " << evictions << " ( " << dirtyEvictions << " dirty )"
+		<< "\n\nWrite policy : " 
+		<< ( writeThrough ? "write-through" : "write-back" ) << ", "
+		<< ( writeAllocate ? "write-allocate" : "no-write-allocate" )
+		<< "\nTraffic with the level below : " << bytesFromBelow 
+		<< " bytes up ( fills ), " << bytesToBelow << " bytes down";
+	if ( blockReads + blockWrites > 0 )
+		cout << "\nLine transfers for the level above : " << blockReads
+			<< " reads, " << blockWrites << " writes";
+	if ( requesterAccesses[REQUESTER_DATA] + requesterAccesses[REQUESTER_INSTRUCTION] > 0 )
+	{
+		cout << "\n\nAccesses by requester :";
+		for ( int r = 0; r < NO_OF_REQUESTERS; r++ )
+			cout << "\n  " << RequesterName ( r ) << " : " << requesterAccesses[r]
+				<< " ( " << requesterHits[r] << " hits ), hit ratio "
+				<< (( requesterAccesses[r] != 0 ) ? static_cast<double>
+					( requesterHits[r] ) / requesterAccesses[r] : 0);
+	}
+	if ( inclusion == INCLUSION_INCLUSIVE )
+		cout << "\nInclusive : " << recalls << " evictions recalled the line from above ( "
+			<< dirtyRecalls << " modified there )";
+	else if ( inclusion == INCLUSION_EXCLUSIVE )
+		cout << "\nExclusive : " << linesMovedUp << " lines moved up, "
+			<< linesFromAbove << " lines put back from above";
+	if ( backInvalidations > 0 )
+		cout << "\nLines taken back by an inclusive level below : " << backInvalidations;
+	if ( writeBuffer != NULL )
+		writeBuffer -> Statistics ( );
+	if ( victimCache != NULL )
+		victimCache -> Statistics ( );
+	if ( prefetcher.Kind ( ) != PREFETCH_NONE )
+	{
+		// A block from the stream buffer is still a miss of the cache
+		word_64 misses = ( readCount + writeCount ) - ( readHitCount + writeHitCount );
+		if ( stream != NULL ) misses -= usefulPrefetches;
+		cout << "\n\nPrefetcher : " << Prefetcher::Name ( prefetcher.Kind ( ) )
+			<< ", degree " << prefetcher.Degree ( )
+			<< "\nPrefetches issued : " << prefetchesIssued
+			<< "\nUseful prefetches : " << usefulPrefetches
+			<< " ( " << latePrefetches << " late )"
+			<< "\nPrefetched blocks evicted unused : " << unusedPrefetches
+			<< "\nMisses on blocks a prefetch evicted ( pollution ) : " 
+			<< pollutionMisses
+			<< "\nAccuracy : " << (( prefetchesIssued != 0 ) ? 
+				static_cast<double>(usefulPrefetches) / prefetchesIssued : 0)
+			<< "\nCoverage : " << (( usefulPrefetches + misses != 0 ) ?
+				static_cast<double>(usefulPrefetches) / 
+					( usefulPrefetches + misses ) : 0)
+			<< "\nTimeliness : " << (( usefulPrefetches != 0 ) ?
+				static_cast<double>(usefulPrefetches - latePrefetches) / 
+					usefulPrefetches : 0);
+	}
+	if ( shadowPolicy != NULL )
+	{
+		cout << "\nHits with each policy ( tag-only copies of this cache ) :";
+		for ( int p = 0; p < NO_OF_REPL_POLICIES; p++ )
+			cout << "\n  " << Replacement::Name ( static_cast<ReplacementPolicy>(p) )
+				<< " : " << shadowHits[p] << " hits, hit ratio "
+				<< (( shadowAccesses != 0 ) ? 
+					static_cast<double>(shadowHits[p]) / shadowAccesses : 0);
+	}
+	if ( missClassifier != NULL )
+		missClassifier -> Statistics ( );
+	if ( stackDistance != NULL )
+		stackDistance -> Statistics ( noOfBlocks );
+	if ( noOfMSHRs == 0 )
+		cout << "\nBlocking cache ( no MSHRs )";
+	else
+		cout << "\n\nMSHRs : " << noOfMSHRs
+		<< "\nSecondary misses merged : " << secondaryMisses
+		<< "\nMisses stalled on full MSHRs : " << mshrFullStalls
+		<< " ( " << mshrFullCycles << " cycles )"
+		<< "\nPeak MSHRs in use : " << peakMSHRs
+		<< "\nAverage MSHR occupancy : " 
+		<< (( lastDone >= firstIssue && firstIssue != -1 ) ? 
+			static_cast<double>(mshrBusyCycles) / ( lastDone - firstIssue + 1 ) : 0)
+		<< "\nMemory-level parallelism : " 
+		<< (( mshrCoveredCycles != 0 ) ? 
+			static_cast<double>(mshrBusyCycles) / mshrCoveredCycles : 0);
+	cout << flush;
 	
 	mem -> Statistics ( );
 }
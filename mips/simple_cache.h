@@ -25,17 +25,84 @@
 # define __SIMPLE_CACHE
 
 # include "memory.h"
+# include "replacement.h"
+# include "write_buffer.h"
+# include "prefetcher.h"
+# include "victim_cache.h"
+# include "stack_distance.h"
+# include "miss_classifier.h"
 
+# include <pthread.h>
+
+class CoherenceBus;
+
+// Line states, used only when the cache is attached to a CoherenceBus.
+// valid and modified are kept consistent with the state.
+enum MESIState { MESI_INVALID, MESI_SHARED, MESI_EXCLUSIVE, MESI_MODIFIED };
+
+// When a miss lets the requester go on.  The words of a block arrive
+// one per cycle after the first; unless the cache has MSHRs, the whole
+// block must be in before it takes another access.
+enum FillPolicy { FILL_WHOLE_BLOCK,	// after the last word
+		FILL_EARLY_RESTART,	// as soon as the requested word is in
+		FILL_CRITICAL_WORD_FIRST };	// ... which is fetched first
+
+# define CACHE_LINE_BYTES 64	// alignment of the data and tag arrays
+
+// How a level holds the lines of the caches above it.  Set on the top
+// level of a SharedCache, see shared_cache.h.
+enum InclusionPolicy { INCLUSION_NON_INCLUSIVE,	// either way
+		INCLUSION_INCLUSIVE,	// every line above is also here: an
+					// eviction takes it from above too
+		INCLUSION_EXCLUSIVE };	// no line is in both: a fill moves the
+					// line up, lines dropped above come here
+
+# define MAX_UPPER_CACHES 4
+
+// The state of a line besides its tag, which SimpleCache keeps packed
+// apart for the lookup.
 class SimpleCache_TagRecord
 {
 public:
-	int tag;
-	bool valid;
 	bool modified;
 	
+	MESIState state;
+	u_word_32 accessMask;	// words touched by this core since the fill,
+				// used to tell false sharing from true sharing
+	
+	bool prefetched;	// brought in by the prefetcher, not yet used
+	int readyAt;		// ... and the last clock of its fill
+	
 	SimpleCache_TagRecord ( );
 };
 
+// A miss status holding register: a block on its way from the lower
+// level.  The fill itself is carried out at once, so the block is already
+// in the cache; the MSHR tells until when its words are still arriving.
+// Later misses to the block ( secondary misses ) are merged into it.
+class SimpleCache_MSHR
+{
+public:
+	int blockTag;
+	int issuedAt;		// clock the fill started
+	int doneAt;		// last clock of the fill; free after it
+	int * wordReady;	// last clock of an access that wants the word
+	
+	SimpleCache_MSHR ( );
+};
+
+// A block held by the stream buffer, which sits beside the cache and is
+// looked up on a miss.  Only the head of the buffer is compared.
+class SimpleCache_StreamEntry
+{
+public:
+	int blockTag;		// -1 once invalidated
+	int readyAt;		// last clock of its fill
+	word_32 * data;
+	
+	SimpleCache_StreamEntry ( );
+};
+
 class SimpleCache : public Cache
 {
 private:
@@ -51,23 +118,268 @@ private:
 	int wordsPerBlock;
 	int associativity;
 	int noOfSets;
-
-	word_32 *** cache;
-	SimpleCache_TagRecord ** tagArray;
-	int * fifoIndex;
+	
+	// Storage.  The data of every line is in one aligned allocation, set
+	// after set.  The tags are packed in rows of tagStride ints per set
+	// ( the associativity rounded up to a whole vector ), -1 standing for
+	// an invalid way, so a lookup compares a whole row at once.
+	word_32 * data;
+	int * tags;
+	int tagStride;
+	SimpleCache_TagRecord * tagArray;
+	
+	word_32 * Line ( int setNo, int way )
+	{
+		return data + ( setNo * associativity + way ) * wordsPerBlock;
+	}
+	SimpleCache_TagRecord & Record ( int setNo, int way )
+	{
+		return tagArray[setNo * associativity + way];
+	}
+	int TagOf ( int setNo, int way )
+	{
+		return tags[setNo * tagStride + way];
+	}
+	bool Valid ( int setNo, int way )
+	{
+		return tags[setNo * tagStride + way] != -1;
+	}
+	void SetTag ( int setNo, int way, int blockTag )	// -1 invalidates
+	{
+		tags[setNo * tagStride + way] = blockTag;
+	}
+	
+	// Splits an address with shifts and masks when the block size and
+	// the number of sets are powers of two, else with / and %.
+	int offsetShift;	// log2 wordsPerBlock, or -1
+	int setMask;		// noOfSets - 1, or -1
+	void Locate ( word_32 address, int & blockTag, int & blockOffset, int & setNo )
+	{
+		u_word_32 word = static_cast<u_word_32>(address) >> 2;
+		if ( offsetShift != -1 )
+		{
+			blockTag = word >> offsetShift;
+			blockOffset = word & ( wordsPerBlock - 1 );
+		}
+		else
+		{
+			blockTag = word / wordsPerBlock;
+			blockOffset = word % wordsPerBlock;
+		}
+		setNo = SetOf ( blockTag );
+	}
+	int SetOf ( int blockTag )
+	{
+		return ( setMask != -1 ) ? ( blockTag & setMask ) : ( blockTag % noOfSets );
+	}
+	// The address of the block's first byte, multiplied out unsigned: it
+	// passes 2^31 for the blocks in the top half of the address space.
+	word_32 BlockAddress ( int blockTag )
+	{
+		return static_cast<word_32>( static_cast<u_word_32>(blockTag) * wordsPerBlock * 4 );
+	}
+	
+	Replacement replacement;
+	int ChooseVictim ( int setNo );	// an invalid way, or the policy's pick
+	word_64 evictions;
+	word_64 dirtyEvictions;
+	
+	// Tag-only copies of this cache, one per replacement policy, that see
+	// the same accesses; NULL unless ComparePolicies ( ) was called.
+	Replacement * shadowPolicy;
+	int ** shadowTags;		// -1 for an empty way
+	word_64 shadowHits[NO_OF_REPL_POLICIES];
+	word_64 shadowAccesses;
+	void ObservePolicies ( int setNo, int blockTag );
+	
+	// Miss ratio curves of the same accesses; NULL unless
+	// ProfileStackDistances ( ) was called.
+	StackDistance * stackDistance;
+	
+	// The causes of the misses and the accesses, misses and evictions of
+	// each set; NULL unless ClassifyMisses ( ) was called.
+	MissClassifier * missClassifier;
+	
+	FillPolicy fillPolicy;
+	
+	// Non-blocking support.  With no MSHRs the cache blocks on a miss.
+	SimpleCache_MSHR * mshr;
+	int noOfMSHRs;
+	int FindMSHR ( int blockTag );	// outstanding at clock, or -1
+	int AllocateMSHR ( int blockTag, int & wait );
+		// wait is set to the clocks until an MSHR frees up
+	
+	word_64 secondaryMisses;	// merged into an outstanding MSHR
+	word_64 mshrFullStalls;		// misses that found every MSHR in use
+	word_64 mshrFullCycles;		// ... and the clocks they waited
+	word_64 mshrBusyCycles;		// sum over the misses of their fill time
+	word_64 mshrCoveredCycles;	// clocks with at least one miss outstanding
+	int coveredUntil;
+	int firstIssue, lastDone;
+	int peakMSHRs;
+	
+	// Write policy.  A write-through cache keeps its lines clean and sends
+	// every write down, through the write buffer if there is one.
+	bool writeThrough;
+	bool writeAllocate;	// else a write miss only goes down
+	WriteBuffer * writeBuffer;	// NULL for none
+	int drainReadyAt;	// clock at which the next entry may drain
+	int WriteDown ( word_32 address, word_32 value, int noOfBytes = 4 );
+		// returns the clocks the writer waits for it
+	void BackgroundDrain ( );
+	
+	VictimCache * victimCache;	// NULL for none
+	void VictimEvict ( int setNo, int index );	// moves the line there
+	bool VictimSwap ( int setNo, int index, int blockTag, bool & dirty );
+		// on a miss; true if the block came back from the victim cache
+		// into the line, dirty telling whether it was modified
+	bool VictimSnoop ( int blockTag, bool & flushed );
+	
+	word_64 bytesFromBelow;		// traffic with the level below
+	word_64 bytesToBelow;
+	
+	// Prefetching.  The access sets demandTag ( -1 once it is handled ),
+	// and demandTrigger on a miss or on the first use of a prefetched
+	// line; the prefetches are issued after the access, off its latency.
+	Prefetcher prefetcher;
+	int demandTag;
+	bool demandTrigger;
+	int * candidate;		// room for the prefetcher's blocks
+	int * pollutionTag;		// per set, the last block a prefetch evicted
+	void IssuePrefetches ( );	// takes the bus lock itself
+	void PrefetchBlock ( int blockTag, int start );
+	void DemandHit ( int setNo, int index );
+	void DemandMiss ( int setNo, int blockTag );
+	
+	SimpleCache_StreamEntry * stream;	// NULL unless a stream buffer
+	int streamHead, streamCount;
+	int streamNextTag;		// block that goes in behind the tail
+	bool StreamLookup ( int setNo, int index, int blockTag );
+		// on a miss, moves the block in from the head of the buffer
+	void StreamFill ( int start );	// tops the buffer up from streamNextTag
+	void StreamInvalidate ( int blockTag );
+	
+	word_64 prefetchesIssued;
+	word_64 usefulPrefetches;	// demand-used before being evicted
+	word_64 latePrefetches;		// ... while still arriving
+	word_64 unusedPrefetches;	// evicted ( or flushed ) unused
+	word_64 pollutionMisses;	// misses on a block a prefetch evicted
+	
+	int * wordArrival;		// per word, filled by ReadFromBelow
+	int ReadFromBelow ( int blockTag, word_32 * data, int first );
+		// reads a block, the word first onwards; returns the arrival
+		// of the last word, relative to the lower level's clock
 	
 	int readCount;
 	int readHitCount;
 	int writeCount;
 	int writeHitCount;
+	word_64 blockReads;	// ReadBlock / WriteBlock calls from above
+	word_64 blockWrites;
+	
+	// Coherence, see coherence_bus.h
+	CoherenceBus * bus;
+	bool snooping;
+	// Takes the lock of the address's set, and the bus lock before it
+	// unless the access is a hit that needs no bus transaction; wide is
+	// set to whether the bus lock was taken.
+	void LockForAccess ( word_32 address, bool write, bool & wide );
+	void UnlockForAccess ( word_32 address, bool wide );
+	bool NeedsBus ( word_32 address, bool write );	// with the set lock held
+	
+	// Inclusion.  The caches directly above are registered so that an
+	// inclusive level can take lines back from them; they then hold the
+	// hierarchy lock around their accesses, as the level may reach into
+	// them from the other side's thread.
+	InclusionPolicy inclusion;
+	SimpleCache * upper[MAX_UPPER_CACHES];
+	int noOfUppers;
+	pthread_mutex_t * hierarchyLock;	// NULL for none
+	void Recall ( int setNo, int index );	// before an inclusive eviction
+	void MoveUp ( int setNo, int index );	// an exclusive hit leaves
+	void InstallLine ( int blockTag, word_32 * words, bool modified );
+	bool ExclusiveReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first, int * arrival );
+	bool ExclusiveWriteBlock ( word_32 address, word_32 * data, int noOfWords );
+	word_64 recalls, dirtyRecalls;		// inclusive
+	word_64 linesMovedUp, linesFromAbove;	// exclusive
+	word_64 backInvalidations;		// lines a level below took from here
+	
+	word_64 requesterAccesses[NO_OF_REQUESTERS];
+	word_64 requesterHits[NO_OF_REQUESTERS];
+	void CountRequester ( bool hit );
+	
+	int FindInSet ( int setNo, int blockTag );	// the way, or -1
+	bool Read_internal ( word_32 address, word_32 & result, int noOfBytes );
+	bool Write_internal ( word_32 address, word_32 value, int noOfBytes );
+	void WriteBack ( int setNo, int index );
+	void WriteBlockDown ( int blockTag, word_32 * data );
+	void FetchBlock ( int setNo, int index, int blockTag, int blockOffset );
+		// Reads the block from the lower level and sets the timing
 public:
-	SimpleCache ( Cache * memory, int nob, int wpb, int assoc, char * ty, int lev,
+	SimpleCache ( Cache * memory, int nob, int wpb, int assoc, const char * ty, int lev,
 		bool verbos );
 	void Statistics ( );
+	bool Totals ( word_64 & accesses, word_64 & hits );
 	bool Read ( word_32 address, word_32 & result, int noOfBytes );
 	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes );
 	bool Write ( word_32 address, word_32 value, int noOfBytes );
+	
+	// The tags and the replacement state of an access only, for replaying
+	// traces: no data, timing, lower level, locks, prefetcher or victim
+	// cache.  Counted as a read or a write; true on a hit.
+	bool ReplayAccess ( word_32 address, bool write );
+	
+	// One access per line of this cache that the block touches; the words
+	// of a line follow its first one a cycle apart.
+	bool ReadBlock ( word_32 address, word_32 * data, int noOfWords,
+		int first = 0, int * arrival = NULL );
+	bool WriteBlock ( word_32 address, word_32 * data, int noOfWords );
 	void AtExit ( );
+	
+	void SetFillPolicy ( FillPolicy policy );
+	void SetMSHRs ( int count );	// 0 for a blocking cache
+	void SetReplacement ( ReplacementPolicy policy, unsigned int seed );
+	void SetWritePolicy ( bool through, bool allocate, int bufferEntries );
+		// bufferEntries is the size of the write buffer, 0 for none
+	void SetPrefetcher ( PrefetchKind kind, int degree );
+		// degree is the lines fetched ahead, or the stream buffer depth
+	void SetVictimCache ( int entries );	// 0 for none
+	void ComparePolicies ( unsigned int seed );
+		// report the hits every policy would get
+	void ProfileStackDistances ( const char * csv, int maxSets, int maxWays );
+		// report the misses of every LRU cache with this block size
+	void ClassifyMisses ( );
+		// report compulsory, capacity and conflict misses, and the sets
+		// they fall in
+	
+	// Makes this cache a private L1 on the given bus.  A snooping cache
+	// takes part in MESI; a non snooping one ( instructions ) only
+	// serialises its misses with the other cores.
+	void AttachBus ( CoherenceBus * b, int core, bool snoop );
+	
+	// Called by the bus, with the bus lock and the set's lock held, on
+	// behalf of another cache.
+	// Return true if this cache held the line.
+	bool SnoopRead ( word_32 address, bool & flushed );
+	bool SnoopInvalidate ( word_32 address, bool & flushed, bool & wordTouched );
+	
+	int LineBytes ( );
+	
+	// Shared hierarchies, see shared_cache.h
+	void SetInclusion ( InclusionPolicy policy );
+	InclusionPolicy Inclusion ( );
+	void AddUpper ( SimpleCache * above );
+	void SetHierarchyLock ( pthread_mutex_t * lock );	// this cache and those above
+	
+	// Drops the words from address on, merging the modified ones into
+	// words; returns true if any were modified.  Done for the caches
+	// above as well.  Called by an inclusive level below.
+	bool BackInvalidate ( word_32 address, int noOfWords, word_32 * words );
+	void CleanEviction ( word_32 address, word_32 * words, int noOfWords );
+	
+	// The instruction set the tag compare was built for.
+	static const char * LookupPath ( );
 };
 
 # endif
@@ -0,0 +1,302 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "stack_distance.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include <fstream>
+using std::ofstream;
+
+# include <cstdio>	// snprintf
+
+# include "../include/color.h"
+
+# define INITIAL_HASH_SIZE 1024
+# define INITIAL_TIMES 0x10000
+# define INITIAL_HISTOGRAM 1024
+
+StackDistance :: StackDistance ( int blockSize, const char * csv, int sets, int ways )
+{
+	blockBytes = blockSize;
+	snprintf ( csvFile, STACK_CSV_SIZE, "%s", csv );
+	accesses = 0;
+	
+	hashSize = INITIAL_HASH_SIZE;
+	hashShift = 32 - __builtin_ctz ( hashSize );
+	hashBlock = new int [hashSize];
+	hashTime = new int [hashSize];
+	for ( int i = 0; i < hashSize; i++ )
+		hashBlock[i] = -1;
+	blocks = 0;
+	
+	times = INITIAL_TIMES;
+	tree = new int [times + 1];
+	owner = new int [times + 1];
+	for ( int t = 0; t <= times; t++ )
+	{
+		tree[t] = 0;
+		owner[t] = -1;
+	}
+	now = 0;
+	
+	histogramSize = INITIAL_HISTOGRAM;
+	histogram = new word_64 [histogramSize];
+	for ( int d = 0; d < histogramSize; d++ )
+		histogram[d] = 0;
+	
+	// The set counts are powers of two, 2 to sets
+	if ( sets > MAX_STACK_SETS ) sets = MAX_STACK_SETS;
+	if ( ways < 1 ) ways = 1;
+	if ( ways > MAX_STACK_WAYS ) ways = MAX_STACK_WAYS;
+	maxWays = ways;
+	noOfSetCounts = 0;
+	for ( maxSets = 2; maxSets * 2 <= sets; maxSets *= 2 )
+		noOfSetCounts ++;
+	noOfSetCounts ++;
+	stack = new int * [noOfSetCounts];
+	setHistogram = new word_64 * [noOfSetCounts];
+	for ( int k = 0; k < noOfSetCounts; k++ )
+	{
+		int entries = ( 2 << k ) * maxWays;
+		stack[k] = new int [entries];
+		for ( int i = 0; i < entries; i++ )
+			stack[k][i] = -1;
+		setHistogram[k] = new word_64 [maxWays];
+		for ( int d = 0; d < maxWays; d++ )
+			setHistogram[k][d] = 0;
+	}
+}
+
+void StackDistance :: AtExit ( )
+{
+	delete[] hashBlock;
+	delete[] hashTime;
+	delete[] tree;
+	delete[] owner;
+	delete[] histogram;
+	for ( int k = 0; k < noOfSetCounts; k++ )
+	{
+		delete[] stack[k];
+		delete[] setHistogram[k];
+	}
+	delete[] stack;
+	delete[] setHistogram;
+	noOfSetCounts = 0;
+}
+
+int StackDistance :: Find ( int block )
+{
+	// The top bits of the product: the low ones depend only on the low
+	// bits of the block, so power of two strides would share an entry
+	u_word_32 h = ( static_cast<u_word_32>( block ) * 2654435761u ) >> hashShift;
+	while ( hashBlock[h] != -1 && hashBlock[h] != block )
+		h = ( h + 1 ) & ( hashSize - 1 );
+	return static_cast<int>( h );
+}
+
+void StackDistance :: GrowHash ( )
+{
+	int * oldBlock = hashBlock, * oldTime = hashTime;
+	int oldSize = hashSize;
+	hashSize *= 2;
+	hashShift --;
+	hashBlock = new int [hashSize];
+	hashTime = new int [hashSize];
+	for ( int i = 0; i < hashSize; i++ )
+		hashBlock[i] = -1;
+	for ( int i = 0; i < oldSize; i++ )
+		if ( oldBlock[i] != -1 )
+		{
+			int e = Find ( oldBlock[i] );
+			hashBlock[e] = oldBlock[i];
+			hashTime[e] = oldTime[i];
+			owner[oldTime[i]] = e;
+		}
+	delete[] oldBlock;
+	delete[] oldTime;
+}
+
+// Only the last access of each block is marked, so the times can be
+// handed out again, in the same order, as 1 .. blocks.  There are twice
+// as many afterwards if more than half would be in use.
+void StackDistance :: Renumber ( )
+{
+	int newTimes = ( blocks * 2 > times ) ? times * 2 : times;
+	int * newOwner = new int [newTimes + 1];
+	for ( int t = 0; t <= newTimes; t++ )
+		newOwner[t] = -1;
+	int n = 0;
+	for ( int t = 1; t <= now; t++ )
+		if ( owner[t] != -1 )
+		{
+			newOwner[++ n] = owner[t];
+			hashTime[owner[t]] = n;
+		}
+	delete[] owner;
+	owner = newOwner;
+	
+	delete[] tree;
+	tree = new int [newTimes + 1];
+	for ( int t = 0; t <= newTimes; t++ )
+		tree[t] = ( t >= 1 && t <= n ) ? 1 : 0;
+	for ( int t = 1; t <= newTimes; t++ )
+	{
+		int parent = t + ( t & -t );
+		if ( parent <= newTimes )
+			tree[parent] += tree[t];
+	}
+	times = newTimes;
+	now = n;
+}
+
+int StackDistance :: Marks ( int time )
+{
+	int sum = 0;
+	for ( ; time > 0; time -= time & -time )
+		sum += tree[time];
+	return sum;
+}
+
+void StackDistance :: Mark ( int time, int delta )
+{
+	for ( ; time <= times; time += time & -time )
+		tree[time] += delta;
+}
+
+void StackDistance :: Count ( int distance )
+{
+	if ( distance >= histogramSize )
+	{
+		int size = histogramSize;
+		while ( size <= distance ) size *= 2;
+		word_64 * grown = new word_64 [size];
+		for ( int d = 0; d < size; d++ )
+			grown[d] = ( d < histogramSize ) ? histogram[d] : 0;
+		delete[] histogram;
+		histogram = grown;
+		histogramSize = size;
+	}
+	histogram[distance] ++;
+}
+
+void StackDistance :: Observe ( int block )
+{
+	accesses ++;
+	
+	if ( now == times ) Renumber ( );
+	now ++;
+	int e = Find ( block );
+	if ( hashBlock[e] == -1 )
+	{
+		hashBlock[e] = block;
+		blocks ++;
+	}
+	else
+	{
+		int last = hashTime[e];
+		Count ( Marks ( now - 1 ) - Marks ( last ) );
+		Mark ( last, -1 );
+		owner[last] = -1;
+	}
+	hashTime[e] = now;
+	owner[now] = e;
+	Mark ( now, 1 );
+	if ( blocks * 2 > hashSize ) GrowHash ( );
+	
+	for ( int k = 0; k < noOfSetCounts; k++ )
+	{
+		int * s = stack[k] + ( block & ( ( 2 << k ) - 1 ) ) * maxWays;
+		int depth = 0;
+		while ( depth < maxWays && s[depth] != block && s[depth] != -1 )
+			depth ++;
+		if ( depth < maxWays && s[depth] == block )
+			setHistogram[k][depth] ++;
+		else if ( depth == maxWays )
+			depth --;		// The LRU block falls off
+		for ( ; depth > 0; depth-- )
+			s[depth] = s[depth - 1];
+		s[0] = block;
+	}
+}
+
+word_64 StackDistance :: Misses ( int cacheBlocks )
+{
+	word_64 hits = 0;
+	for ( int d = 0; d < cacheBlocks && d < histogramSize; d++ )
+		hits += histogram[d];
+	return accesses - hits;
+}
+
+// One row per cache: the fully associative ones ( a single set ) where
+// the curve steps, then every set count and associativity.
+bool StackDistance :: WriteCsv ( )
+{
+	ofstream file ( csvFile );
+	if ( ! file )
+	{
+		cout << red << "\n[ StackDistance ] Could not write \"" << csvFile << "\""
+			<< reset << flush;
+		return false;
+	}
+	file << "sets,ways,blocks,bytes,misses,miss_ratio\n";
+	word_64 hits = 0;
+	for ( int n = 1; n <= histogramSize; n++ )
+	{
+		hits += histogram[n - 1];
+		if ( n == 1 || histogram[n - 1] != 0 )
+			file << 1 << "," << n << "," << n << "," 
+				<< static_cast<word_64>( n ) * blockBytes << "," << accesses - hits << ","
+				<< (( accesses != 0 ) ? static_cast<double>( accesses - hits ) / accesses : 0)
+				<< "\n";
+	}
+	for ( int k = 0; k < noOfSetCounts; k++ )
+	{
+		int sets = 2 << k;
+		hits = 0;
+		for ( int a = 1; a <= maxWays; a++ )
+		{
+			hits += setHistogram[k][a - 1];
+			file << sets << "," << a << "," << sets * a << ","
+				<< static_cast<word_64>( sets * a ) * blockBytes << "," << accesses - hits << ","
+				<< (( accesses != 0 ) ? static_cast<double>( accesses - hits ) / accesses : 0)
+				<< "\n";
+		}
+	}
+	return true;
+}
+
+void StackDistance :: Statistics ( int cacheBlocks )
+{
+	word_64 misses = Misses ( cacheBlocks );
+	cout << "\n\nStack distances ( " << blockBytes << " byte blocks ) : " 
+		<< accesses << " accesses, " << blocks << " distinct blocks"
+		<< "\nMisses with a fully associative LRU cache of this size : " << misses
+		<< ", miss ratio " << (( accesses != 0 ) ? 
+			static_cast<double>( misses ) / accesses : 0);
+	if ( WriteCsv ( ) == true )
+		cout << "\nMiss ratio curves ( up to " << maxSets << " sets of " << maxWays 
+			<< " ways ) written to " << csvFile;
+}
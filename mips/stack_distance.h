@@ -0,0 +1,89 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __STACK_DISTANCE_H
+# define __STACK_DISTANCE_H
+
+# include "../include/instruction.h"
+
+# define STACK_CSV_SIZE 128
+# define MAX_STACK_SETS 0x10000
+# define MAX_STACK_WAYS 64
+# define DEFAULT_STACK_SETS 4096
+# define DEFAULT_STACK_WAYS 16
+
+// LRU stack distances of a stream of block accesses, from which the
+// misses of every LRU cache with this block size follow at once: an
+// access hits in a cache deeper than its distance ( Mattson et al. ).
+// 
+// Fully associative distances are unbounded and found as Bennett and
+// Kruskal did: each block is marked at the time of its last access, and
+// a Fenwick tree over the times counts the marks after it, that is the
+// distinct blocks touched since, in O ( log n ).  For 2, 4 .. maxSets
+// sets the blocks of each set are kept in an LRU stack maxWays deep.
+class StackDistance
+{
+private:
+	int blockBytes;
+	char csvFile[STACK_CSV_SIZE];
+	word_64 accesses;
+	
+	// Fully associative
+	int * hashBlock;	// open addressing, -1 for an empty entry
+	int * hashTime;		// the block's last access
+	int hashSize;		// a power of two
+	int hashShift;		// 32 - log2 hashSize
+	int blocks;		// distinct blocks seen
+	int * tree;		// Fenwick tree over the times 1 .. times
+	int * owner;		// time -> hash entry, -1 if a later access took it
+	int times;
+	int now;		// the last time handed out
+	word_64 * histogram;	// accesses at each distance
+	int histogramSize;
+	
+	int Find ( int block );		// the hash entry, or the empty one for it
+	void GrowHash ( );
+	void Renumber ( );		// when the times run out
+	int Marks ( int time );		// marks at times 1 .. time
+	void Mark ( int time, int delta );
+	void Count ( int distance );
+	
+	// Set associative; index k is for 2 << k sets
+	int maxSets, maxWays, noOfSetCounts;
+	int ** stack;		// [k][set * maxWays + depth], -1 empty
+	word_64 ** setHistogram;	// [k][depth], hits at each depth
+	
+	word_64 Misses ( int blocks );	// of a fully associative cache
+public:
+	StackDistance ( int blockSize, const char * csv, int sets, int ways );
+	void AtExit ( );
+	
+	void Observe ( int block );	// a block number
+	
+	// A summary ( with the misses of a fully associative cache of the
+	// given number of blocks ), and the curves written to the CSV file.
+	void Statistics ( int cacheBlocks );
+	bool WriteCsv ( );
+};
+
+# endif
@@ -0,0 +1,75 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "static_cache.h"
+
+// The L1 hits in one cycle, an L2 in L2_HIT_LATENCY.
+# define L2_HIT_LATENCY 6
+
+typedef StaticCache < 8192, 1, 4, MainMemory > Small_L1;
+typedef StaticCache < 32768, 4, 8, MainMemory > L1_Only;
+typedef StaticCache < 262144, 8, 16, MainMemory > L2_256K;
+typedef StaticCache < 32768, 4, 8, L2_256K > L1_L2;
+typedef StaticCache < 131072, 8, 16, MainMemory > L2_128K;
+typedef StaticCache < 16384, 2, 8, L2_128K > Small_L1_L2;
+
+const char * StaticTopology :: Name ( int topology )
+{
+	switch ( topology )
+	{
+	case 0: return "8KB direct mapped, 16B blocks";
+	case 1: return "32KB 4-way, 32B blocks";
+	case 2: return "32KB 4-way, 32B blocks, over a 256KB 8-way L2 with 64B blocks";
+	case 3: return "16KB 2-way, 32B blocks, over a 128KB 8-way L2 with 64B blocks";
+	default: return "?";
+	};
+}
+
+Cache * StaticTopology :: Build ( int topology, MainMemory * mem, const char * type )
+{
+	Cache * c = NULL;
+	switch ( topology )
+	{
+	case 0:
+		c = new Small_L1 ( mem, type, 1 );
+		break;
+	case 1:
+		c = new L1_Only ( mem, type, 1 );
+		break;
+	case 2:
+		{
+			L2_256K * l2 = new L2_256K ( mem, type, 2 );
+			l2 -> SetLatency ( L2_HIT_LATENCY );
+			c = new L1_L2 ( l2, type, 1 );
+		}
+		break;
+	case 3:
+		{
+			L2_128K * l2 = new L2_128K ( mem, type, 2 );
+			l2 -> SetLatency ( L2_HIT_LATENCY );
+			c = new Small_L1_L2 ( l2, type, 1 );
+		}
+		break;
+	};
+	return c;
+}
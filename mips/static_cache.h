@@ -0,0 +1,296 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __STATIC_CACHE_H
+# define __STATIC_CACHE_H
+
+# include "memory.h"
+
+# include <iostream>
+# include <cstring>
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+// A cache level whose geometry and lower level are fixed at compile
+// time, so that a whole hierarchy such as
+//	StaticCache < 32768, 4, 8, StaticCache < 262144, 8, 16, MainMemory > >
+// is one type.  Each level calls the next as Lower::Read etc. rather
+// than through the Cache interface, so the compiler sees ( and inlines )
+// the whole lookup path; the top level is still a Cache for the
+// processor.  A level is write-back, write-allocate and LRU, with whole
+// block fills; for anything else, build a SimpleCache hierarchy.
+//	BYTES		capacity
+//	WAYS		associativity
+//	LINE_WORDS	words per block
+template < int BYTES, int WAYS, int LINE_WORDS, class Lower >
+class StaticCache : public Cache
+{
+private:
+	enum { LINE_BYTES = LINE_WORDS * 4, SETS = BYTES / ( WAYS * LINE_BYTES ) };
+	
+	Lower * mem;
+	char type[TYPEFIELDSIZE];
+	int level;
+	
+	int tags[SETS][WAYS];		// -1 for an invalid way
+	bool dirty[SETS][WAYS];
+	word_64 lastUse[SETS][WAYS];
+	word_64 useClock;
+	word_32 data[SETS][WAYS][LINE_WORDS];
+	
+	word_64 reads, readHits;
+	word_64 writes, writeHits;
+	word_64 writeBacks;
+	
+	// A block's first byte, multiplied out unsigned as it passes 2^31.
+	static word_32 BlockAddress ( int blockTag )
+	{
+		return static_cast<word_32>( static_cast<u_word_32>(blockTag) * LINE_BYTES );
+	}
+	
+	// Finds the block, filling it on a miss; sets the timing.
+	int Access ( word_32 address, int & setNo, int & offset, bool & hit )
+	{
+		u_word_32 word = static_cast<u_word_32>(address) / 4;
+		int blockTag = word / LINE_WORDS;
+		offset = word % LINE_WORDS;
+		setNo = blockTag % SETS;
+		
+		for ( int w = 0; w < WAYS; w++ )
+			if ( tags[setNo][w] == blockTag )
+			{
+				hit = true;
+				lastUse[setNo][w] = ++ useClock;
+				lastLatency = lastOccupancy = hitLatency;
+				return w;
+			}
+		
+		hit = false;
+		int victim = 0;
+		for ( int w = 1; w < WAYS; w++ )
+			if ( lastUse[setNo][w] < lastUse[setNo][victim] ) victim = w;
+		
+		mem -> SetClock ( clock + hitLatency );
+		mem -> SetPC ( accessPC );
+		if ( tags[setNo][victim] != -1 && dirty[setNo][victim] == true )
+		{
+			writeBacks ++;
+			mem -> Lower::WriteBlock ( BlockAddress ( tags[setNo][victim] ), 
+				data[setNo][victim], LINE_WORDS );
+		}
+		if ( mem -> Lower::ReadBlock ( BlockAddress ( blockTag ), data[setNo][victim], 
+				LINE_WORDS ) == false )
+		{
+			sem_wait ( cout_mutex );
+			std::cout << red << "\n[ StaticCache " << type << " "
+				<< level << "-level ] Read from lower level failed" 
+				<< reset << std::flush;
+			sem_post ( cout_mutex );
+		}
+		tags[setNo][victim] = blockTag;
+		dirty[setNo][victim] = false;
+		lastUse[setNo][victim] = ++ useClock;
+		lastLatency = lastOccupancy = hitLatency + mem -> LastOccupancy ( );
+		return victim;
+	}
+	
+	bool Aligned ( word_32 address, int noOfBytes, const char * who )
+	{
+		if ( Cache::Aligned ( address, noOfBytes ) ) return true;
+		sem_wait ( cout_mutex );
+		std::cout << red << "\n[ StaticCache::" << who << " " << type << " "
+			<< level << "-level ] Alignment error" 
+			<< reset << std::flush;
+		sem_post ( cout_mutex );
+		return false;
+	}
+public:
+	StaticCache ( Lower * lower, const char * ty, int lev )
+	{
+		mem = lower;
+		std::strncpy ( type, ty, TYPEFIELDSIZE - 1 );
+		type[TYPEFIELDSIZE - 1] = 0;
+		level = lev;
+		for ( int s = 0; s < SETS; s++ )
+			for ( int w = 0; w < WAYS; w++ )
+			{
+				tags[s][w] = -1;
+				dirty[s][w] = false;
+				lastUse[s][w] = 0;
+			}
+		useClock = 0;
+		reads = readHits = writes = writeHits = writeBacks = 0;
+	}
+	
+	Lower * LowerLevel ( )
+	{
+		return mem;
+	}
+	
+	bool Read ( word_32 address, word_32 & result, int noOfBytes )
+	{
+		if ( Aligned ( address, noOfBytes, "Read" ) == false ) return false;
+		int setNo, offset; bool hit;
+		int w = Access ( address, setNo, offset, hit );
+		reads ++;
+		if ( hit ) readHits ++;
+		result = Extract ( data[setNo][w][offset], address, noOfBytes );
+		AccountAccess ( );
+		return true;
+	}
+	
+	bool Read_nofetch ( word_32 address, word_32 & result, int noOfBytes )
+	{
+		if ( Aligned ( address, noOfBytes, "Read_nofetch" ) == false ) return false;
+		u_word_32 word = static_cast<u_word_32>(address) / 4;
+		int blockTag = word / LINE_WORDS;
+		for ( int w = 0; w < WAYS; w++ )
+			if ( tags[blockTag % SETS][w] == blockTag )
+			{
+				result = Extract ( data[blockTag % SETS][w][word % LINE_WORDS],
+					address, noOfBytes );
+				return true;
+			}
+		return false;
+	}
+	
+	bool Write ( word_32 address, word_32 value, int noOfBytes )
+	{
+		if ( Aligned ( address, noOfBytes, "Write" ) == false ) return false;
+		int setNo, offset; bool hit;
+		int w = Access ( address, setNo, offset, hit );
+		writes ++;
+		if ( hit ) writeHits ++;
+		data[setNo][w][offset] = Merge ( data[setNo][w][offset], address, value, noOfBytes );
+		dirty[setNo][w] = true;
+		AccountAccess ( );
+		return true;
+	}
+	
+	// One access per line touched, as in SimpleCache
+	bool ReadBlock ( word_32 address, word_32 * block, int noOfWords,
+		int first = 0, int * arrival = NULL )
+	{
+		int setNo = 0, offset = 0, w = 0, line = -1;
+		int ready = 0, firstReady = 0;
+		for ( int n = 0; n < noOfWords; n++ )
+		{
+			int k = ( first + n ) % noOfWords;
+			word_32 a = address + 4 * k;
+			if ( static_cast<int>( static_cast<u_word_32>(a) / LINE_BYTES ) != line )
+			{
+				bool hit;
+				w = Access ( a, setNo, offset, hit );
+				reads ++;
+				if ( hit ) readHits ++;
+				AccountAccess ( );
+				line = static_cast<u_word_32>(a) / LINE_BYTES;
+				ready = ( n == 0 || lastLatency > ready + 1 ) ? lastLatency : ready + 1;
+			}
+			else
+			{
+				offset = ( static_cast<u_word_32>(a) / 4 ) % LINE_WORDS;
+				ready ++;
+			}
+			block[k] = data[setNo][w][offset];
+			if ( n == 0 ) firstReady = ready;
+			if ( arrival != NULL ) arrival[k] = ready;
+		}
+		lastLatency = firstReady;
+		lastOccupancy = ready;
+		return true;
+	}
+	
+	bool WriteBlock ( word_32 address, word_32 * block, int noOfWords )
+	{
+		int setNo = 0, offset = 0, w = 0, line = -1;
+		int firstLatency = 0;
+		for ( int k = 0; k < noOfWords; k++ )
+		{
+			word_32 a = address + 4 * k;
+			if ( static_cast<int>( static_cast<u_word_32>(a) / LINE_BYTES ) != line )
+			{
+				bool hit;
+				w = Access ( a, setNo, offset, hit );
+				writes ++;
+				if ( hit ) writeHits ++;
+				AccountAccess ( );
+				line = static_cast<u_word_32>(a) / LINE_BYTES;
+				if ( k == 0 ) firstLatency = lastLatency;
+			}
+			else
+				offset = ( static_cast<u_word_32>(a) / 4 ) % LINE_WORDS;
+			data[setNo][w][offset] = block[k];
+			dirty[setNo][w] = true;
+		}
+		lastLatency = firstLatency;
+		lastOccupancy = firstLatency + noOfWords - 1;
+		return true;
+	}
+	
+	void Statistics ( )
+	{
+		word_64 accesses = reads + writes;
+		std::cout << green << "\n[ StaticCache::Statistics ] Statistics for the "
+			<< level << "-level \n\t" << type << " cache are displayed"
+			<< reset << std::flush;
+		std::cout << "\nStatically composed : " << BYTES << " bytes, " << WAYS 
+			<< "-way, " << LINE_WORDS << " words per block, " << static_cast<int>( SETS ) << " sets, LRU"
+			<< "\nReads : " << reads << " ( " << readHits << " hits )"
+			<< "\nWrites : " << writes << " ( " << writeHits << " hits )"
+			<< "\nOverall Hit Ratio : " << (( accesses != 0 ) ? 
+				static_cast<double>( readHits + writeHits ) / accesses : 0)
+			<< "\nWrite backs : " << writeBacks
+			<< "\nHit latency : " << hitLatency << " cycles"
+			<< "\nAverage memory access time : " << AverageAccessTime ( ) 
+			<< " cycles" << std::flush;
+		mem -> Statistics ( );
+	}
+	
+	bool Totals ( word_64 & accesses, word_64 & hits )
+	{
+		accesses = reads + writes;
+		hits = readHits + writeHits;
+		return true;
+	}
+	
+	void AtExit ( )
+	{	// The storage is part of the object
+	}
+};
+
+// The topologies built in.  The runtime configuration picks one by
+// number; each is a single StaticCache type over the main memory.
+# define NO_OF_STATIC_TOPOLOGIES 4
+
+class StaticTopology
+{
+public:
+	static const char * Name ( int topology );
+	static Cache * Build ( int topology, MainMemory * mem, const char * type );
+		// NULL for an unknown topology
+};
+
+# endif
@@ -0,0 +1,139 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "store_buffer.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+StoreBuffer :: StoreBuffer ( int sz )
+{
+	size = ( sz > 0 ) ? sz : 1;
+	entry = new StoreBuffer_Entry [size];
+	head = count = 0;
+	newThisCycle = 0;
+	
+	inserted = fullStalls = lookups = forwarded = conflicts = 0;
+	occupancySum = samples = 0;
+	occupancyMax = 0;
+}
+
+void StoreBuffer :: AtExit ( )
+{
+	delete[] entry;
+}
+
+bool StoreBuffer :: Insert ( word_32 address, word_32 value, int noOfBytes, int thread,
+	word_32 pc )
+{
+	if ( count == size )
+	{
+		fullStalls ++;
+		return false;
+	}
+	StoreBuffer_Entry & e = entry[( head + count ) % size];
+	e.address = address;
+	e.value = value;
+	e.noOfBytes = noOfBytes;
+	e.thread = thread;
+	e.pc = pc;
+	count ++;
+	newThisCycle ++;
+	inserted ++;
+	return true;
+}
+
+StoreBufferLookup StoreBuffer :: Lookup ( word_32 address, word_32 & result, 
+	int noOfBytes, int thread )
+{
+	lookups ++;
+	// Youngest first, so the latest value of the address is forwarded.
+	for ( int i = count - 1; i >= 0; i-- )
+	{
+		StoreBuffer_Entry & e = entry[( head + i ) % size];
+		bool overlaps = ( e.address < address + noOfBytes ) &&
+			( address < e.address + e.noOfBytes );
+		if ( overlaps == false ) continue;
+		
+		if ( e.thread == thread && e.address == address && 
+				e.noOfBytes == noOfBytes )
+		{
+			result = e.value;
+			forwarded ++;
+			return SB_FORWARDED;
+		}
+		conflicts ++;
+		return SB_CONFLICT;
+	}
+	return SB_MISS;
+}
+
+bool StoreBuffer :: Empty ( )
+{
+	return count == 0;
+}
+
+bool StoreBuffer :: Drainable ( )
+{
+	return count > newThisCycle;
+}
+
+StoreBuffer_Entry & StoreBuffer :: Oldest ( )
+{
+	return entry[head];
+}
+
+void StoreBuffer :: Remove ( )
+{
+	if ( count == 0 ) return;
+	head = ( head + 1 ) % size;
+	count --;
+}
+
+void StoreBuffer :: Sample ( )
+{
+	occupancySum += count;
+	samples ++;
+	if ( count > occupancyMax ) occupancyMax = count;
+	newThisCycle = 0;
+}
+
+void StoreBuffer :: Statistics ( )
+{
+	cout << gray << "\n  Store buffer entries   : " << size
+		<< "\n  Stores buffered        : " << inserted
+		<< "\n  Stalls on a full buffer: " << fullStalls;
+	if ( samples > 0 )
+		cout << "\n  Average occupancy      : " 
+			<< static_cast<double>(occupancySum) / samples;
+	cout << "\n  Maximum occupancy      : " << occupancyMax
+		<< "\n  Loads checked          : " << lookups
+		<< "\n  Loads forwarded        : " << forwarded;
+	if ( lookups > 0 )
+		cout << " ( " << 100.0 * forwarded / lookups << "% )";
+	cout << "\n  Loads waiting on drain : " << conflicts
+		<< reset << flush;
+}
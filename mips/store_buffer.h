@@ -0,0 +1,84 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __STORE_BUFFER_H
+# define __STORE_BUFFER_H
+
+# include "../include/instruction.h"
+
+// A FIFO of stores that have left the MEM stage but not yet reached the
+// data cache.  Stage3 puts stores in, the clock drains the oldest one 
+// every cycle, and loads look for a younger matching store to forward
+// from before going to the cache.
+class StoreBuffer_Entry
+{
+public:
+	word_32 address;
+	word_32 value;
+	int noOfBytes;
+	int thread;		// hardware thread that issued the store
+	word_32 pc;		// ... and its instruction, for the cache's prefetcher
+};
+
+// Outcome of looking up a load in the store buffer.
+enum StoreBufferLookup { SB_MISS, SB_FORWARDED, SB_CONFLICT };
+
+class StoreBuffer
+{
+private:
+	StoreBuffer_Entry * entry;
+	int size;
+	int head, count;
+	int newThisCycle;	// entries that may only drain from the next cycle
+	
+	// Statistics
+	word_64 inserted;
+	word_64 fullStalls;		// stores that found the buffer full
+	word_64 lookups;		// loads checked against the buffer
+	word_64 forwarded;		// ... that got their data from it
+	word_64 conflicts;		// ... that had to wait for a drain
+	word_64 occupancySum;		// sampled once per cycle
+	word_64 samples;
+	int occupancyMax;
+public:
+	StoreBuffer ( int sz );
+	void AtExit ( );
+	
+	bool Insert ( word_32 address, word_32 value, int noOfBytes, int thread,
+		word_32 pc = 0 );
+		// false if the buffer is full
+	StoreBufferLookup Lookup ( word_32 address, word_32 & result, 
+		int noOfBytes, int thread );
+		// SB_CONFLICT if an older store overlaps the load only in part, 
+		// or belongs to another thread; the load must wait for it to drain.
+	
+	bool Empty ( );
+	bool Drainable ( );	// The oldest entry was buffered in an earlier cycle
+	StoreBuffer_Entry & Oldest ( );
+	void Remove ( );	// Drops the oldest entry once it is written
+	
+	void Sample ( );	// Accounts one cycle of occupancy, and ends the cycle
+	void Statistics ( );
+};
+
+# endif
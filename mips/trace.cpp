@@ -0,0 +1,340 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "trace.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include <cstdio>	// snprintf
+# include <cstring>	// memcpy, memcmp
+
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+void TraceState :: Reset ( )
+{
+	clock = 0;
+	fetch = data = pc = 0;
+}
+
+static unsigned char * PutVarint ( unsigned char * p, u_word_32 value )
+{
+	while ( value >= 0x80 )
+	{
+		*p ++ = static_cast<unsigned char>( value | 0x80 );
+		value >>= 7;
+	}
+	*p ++ = static_cast<unsigned char>( value );
+	return p;
+}
+
+static u_word_32 ZigZag ( u_word_32 difference )
+{
+	return ( difference << 1 ) ^ ( ( difference & 0x80000000u ) ? 0xffffffffu : 0 );
+}
+
+static u_word_32 UnZigZag ( u_word_32 coded )
+{
+	return ( coded >> 1 ) ^ ( ( coded & 1 ) ? 0xffffffffu : 0 );
+}
+
+/*********************************************************************************
+*******************Writing*******************************************************/
+
+TraceWriter :: TraceWriter ( )
+{
+	fileName[0] = '\0';
+	fd = -1;
+	mapped = false;
+	buffer = NULL;
+	windowStart = 0;
+	used = 0;
+	state.Reset ( );
+	records = bytes = 0;
+}
+
+bool TraceWriter :: Open ( const char * file, bool useMmap )
+{
+	snprintf ( fileName, TRACE_FILE_SIZE, "%s", file );
+	fd = open ( fileName, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+	if ( fd == -1 )
+	{
+		cout << red << "\n[ TraceWriter ] Could not create \"" << fileName << "\""
+			<< reset << flush;
+		return false;
+	}
+	mapped = useMmap;
+	if ( mapped == true )
+	{
+		if ( Map ( ) == false )
+		{
+			close ( fd );
+			fd = -1;
+			return false;
+		}
+	}
+	else
+		buffer = new unsigned char [TRACE_BUFFER_SIZE];
+	memcpy ( buffer, TRACE_MAGIC, TRACE_MAGIC_SIZE );
+	used = TRACE_MAGIC_SIZE;
+	bytes = TRACE_MAGIC_SIZE;
+	return true;
+}
+
+// Maps the window at windowStart, growing the file to cover it.
+bool TraceWriter :: Map ( )
+{
+	void * window = MAP_FAILED;
+	if ( ftruncate ( fd, windowStart + TRACE_MAP_WINDOW ) == 0 )
+		window = mmap ( NULL, TRACE_MAP_WINDOW, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd, windowStart );
+	if ( window == MAP_FAILED )
+	{
+		cout << red << "\n[ TraceWriter ] Could not map \"" << fileName << "\""
+			<< reset << flush;
+		buffer = NULL;
+		return false;
+	}
+	buffer = static_cast<unsigned char *>( window );
+	return true;
+}
+
+bool TraceWriter :: Flush ( )
+{
+	if ( mapped == true )
+	{
+		// The new window starts at the page the last record ends in
+		word_64 end = windowStart + used;
+		munmap ( buffer, TRACE_MAP_WINDOW );
+		windowStart = end & ~static_cast<word_64>( sysconf ( _SC_PAGESIZE ) - 1 );
+		used = static_cast<int>( end - windowStart );
+		return Map ( );
+	}
+	for ( int done = 0; done < used; )
+	{
+		ssize_t n = write ( fd, buffer + done, used - done );
+		if ( n <= 0 ) return false;
+		done += n;
+	}
+	used = 0;
+	return true;
+}
+
+void TraceWriter :: Encode ( const ShadowAccess & a )
+{
+	unsigned char * start = buffer + used;
+	unsigned char * p = start + 1;
+	unsigned char header = static_cast<unsigned char>( a.kind & TRACE_KIND_MASK );
+	header |= ( ( a.noOfBytes == 4 ) ? 2 : ( a.noOfBytes == 2 ) ? 1 : 0 ) << TRACE_SIZE_SHIFT;
+	
+	if ( a.clock == state.clock )
+		header |= TRACE_SAME_CLOCK;
+	else if ( a.clock == state.clock + 1 )
+		header |= TRACE_NEXT_CLOCK;
+	else
+		p = PutVarint ( p, ZigZag ( static_cast<u_word_32>( a.clock - state.clock ) ) );
+	state.clock = a.clock;
+	
+	word_32 & last = ( a.kind == SHADOW_FETCH ) ? state.fetch : state.data;
+	if ( a.address == last + 4 )
+		header |= TRACE_NEXT_WORD;
+	else
+		p = PutVarint ( p, ZigZag ( static_cast<u_word_32>( a.address - last ) ) );
+	last = a.address;
+	
+	if ( a.kind != SHADOW_FETCH )
+	{
+		p = PutVarint ( p, ZigZag ( static_cast<u_word_32>( a.pc - state.pc ) ) );
+		state.pc = a.pc;
+	}
+	*start = header;
+	used += p - start;
+	bytes += p - start;
+	records ++;
+}
+
+void TraceWriter :: Write ( const ShadowAccess * batch, int count )
+{
+	if ( buffer == NULL ) return;	// Failed earlier
+	int capacity = mapped ? TRACE_MAP_WINDOW : TRACE_BUFFER_SIZE;
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( capacity - used < TRACE_RECORD_MAX && Flush ( ) == false )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ TraceWriter ] Could not write \"" << fileName 
+				<< "\", the trace stops here" << reset << flush;
+			sem_post ( cout_mutex );
+			Close ( );
+			return;
+		}
+		Encode ( batch[i] );
+	}
+}
+
+void TraceWriter :: Close ( )
+{
+	if ( fd == -1 ) return;
+	if ( mapped == true )
+	{
+		if ( buffer != NULL )
+			munmap ( buffer, TRACE_MAP_WINDOW );
+		if ( ftruncate ( fd, windowStart + used ) != 0 )
+			cout << red << "\n[ TraceWriter ] Could not trim \"" << fileName << "\""
+				<< reset << flush;
+	}
+	else
+	{
+		Flush ( );
+		delete[] buffer;
+	}
+	buffer = NULL;
+	close ( fd );
+	fd = -1;
+}
+
+void TraceWriter :: Statistics ( )
+{
+	cout << "\nTrace : " << records << " accesses, " << bytes << " bytes ( "
+		<< (( records != 0 ) ? static_cast<double>( bytes - TRACE_MAGIC_SIZE ) / records : 0)
+		<< " per access ) " << ( mapped ? "mapped into " : "written to " ) 
+		<< fileName << flush;
+}
+
+/*********************************************************************************
+*******************Reading*******************************************************/
+
+TraceReader :: TraceReader ( )
+{
+	fd = -1;
+	data = NULL;
+	size = position = 0;
+	state.Reset ( );
+}
+
+bool TraceReader :: Open ( const char * file )
+{
+	fd = open ( file, O_RDONLY );
+	struct stat st;
+	if ( fd == -1 || fstat ( fd, &st ) != 0 || st.st_size < TRACE_MAGIC_SIZE )
+	{
+		if ( fd != -1 ) close ( fd );
+		fd = -1;
+		return false;
+	}
+	size = st.st_size;
+	void * map = mmap ( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	if ( map == MAP_FAILED )
+	{
+		close ( fd );
+		fd = -1;
+		return false;
+	}
+	madvise ( map, size, MADV_SEQUENTIAL );
+	data = static_cast<const unsigned char *>( map );
+	if ( memcmp ( data, TRACE_MAGIC, TRACE_MAGIC_SIZE ) != 0 )
+	{
+		Close ( );
+		return false;
+	}
+	Rewind ( );
+	return true;
+}
+
+void TraceReader :: Rewind ( )
+{
+	position = TRACE_MAGIC_SIZE;
+	state.Reset ( );
+}
+
+// A record cut short at the end of the file ends the trace.
+bool TraceReader :: Next ( ShadowAccess & a )
+{
+	if ( position >= size ) return false;
+	const unsigned char * p = data + position;
+	const unsigned char * end = data + size;
+	unsigned char header = *p ++;
+	u_word_32 fields[3];
+	int needed = ( ( header & ( TRACE_SAME_CLOCK | TRACE_NEXT_CLOCK ) ) == 0 ) +
+		( ( header & TRACE_NEXT_WORD ) == 0 ) +
+		( ( header & TRACE_KIND_MASK ) != SHADOW_FETCH );
+	for ( int f = 0; f < needed; f++ )
+	{
+		u_word_32 value = 0;
+		int shift = 0;
+		do
+		{
+			if ( p == end || shift > 28 ) return false;
+			value |= static_cast<u_word_32>( *p & 0x7f ) << shift;
+			shift += 7;
+		} while ( *p ++ & 0x80 );
+		fields[f] = value;
+	}
+	
+	int f = 0;
+	a.kind = header & TRACE_KIND_MASK;
+	a.noOfBytes = 1 << ( ( header >> TRACE_SIZE_SHIFT ) & 3 );
+	if ( header & TRACE_NEXT_CLOCK )
+		state.clock ++;
+	else if ( ( header & TRACE_SAME_CLOCK ) == 0 )
+		state.clock += static_cast<word_32>( UnZigZag ( fields[f ++] ) );
+	a.clock = state.clock;
+	
+	word_32 & last = ( a.kind == SHADOW_FETCH ) ? state.fetch : state.data;
+	if ( header & TRACE_NEXT_WORD )
+		last += 4;
+	else
+		last += static_cast<word_32>( UnZigZag ( fields[f ++] ) );
+	a.address = last;
+	
+	if ( a.kind != SHADOW_FETCH )
+		state.pc += static_cast<word_32>( UnZigZag ( fields[f ++] ) );
+	a.pc = ( a.kind == SHADOW_FETCH ) ? a.address : state.pc;
+	a.value = 0;
+	position = p - data;
+	return true;
+}
+
+void TraceReader :: Close ( )
+{
+	if ( data != NULL )
+		munmap ( const_cast<unsigned char *>( data ), size );
+	if ( fd != -1 )
+		close ( fd );
+	data = NULL;
+	fd = -1;
+}
+
+word_64 TraceReader :: Size ( )
+{
+	return size;
+}
@@ -0,0 +1,107 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __TRACE_H
+# define __TRACE_H
+
+# include "shadow.h"
+
+# define TRACE_MAGIC "CCNTRACE"	// the first bytes of a trace file
+# define TRACE_MAGIC_SIZE 8
+# define TRACE_FILE_SIZE 128
+# define TRACE_BUFFER_SIZE 0x100000	// bytes written out at a time
+# define TRACE_MAP_WINDOW 0x4000000	// bytes mapped at a time
+# define TRACE_RECORD_MAX 16		// a header and three varints
+
+// A trace is the magic, then one record per access, in the order the
+// core made them: a header byte and, unless the header says otherwise,
+// LEB128 varints of the zigzag coded differences from the last record:
+// the clock, the address ( from the last of the same side ) and, for a
+// load or store, the PC ( fetches are at their PC ).  A store's value is
+// not kept.
+# define TRACE_KIND_MASK 0x03		// a ShadowAccessKind
+# define TRACE_SIZE_SHIFT 2		// log2 of the bytes, 2 bits
+# define TRACE_SAME_CLOCK 0x10		// no clock follows
+# define TRACE_NEXT_CLOCK 0x20		// ... the clock is the last one + 1
+# define TRACE_NEXT_WORD 0x40		// no address follows, it is the last + 4
+
+// What the records are coded against, kept alike by the writer and the
+// reader.
+class TraceState
+{
+public:
+	int clock;
+	word_32 fetch;		// last fetch address
+	word_32 data;		// last load or store address
+	word_32 pc;		// ... and its PC
+	
+	void Reset ( );
+};
+
+// Writes a trace, either through a buffer that is written out when full
+// or straight into a window of the file that is mapped in, and moved on
+// as it fills.
+class TraceWriter
+{
+private:
+	char fileName[TRACE_FILE_SIZE];
+	int fd;
+	bool mapped;
+	unsigned char * buffer;	// the buffer, or the mapped window
+	word_64 windowStart;	// offset of buffer[0] in the file, if mapped
+	int used;
+	TraceState state;
+	word_64 records;
+	word_64 bytes;
+	
+	void Encode ( const ShadowAccess & a );
+	bool Flush ( );		// makes room for TRACE_RECORD_MAX bytes
+	bool Map ( );
+public:
+	TraceWriter ( );
+	bool Open ( const char * file, bool useMmap );
+	void Write ( const ShadowAccess * batch, int count );
+	void Close ( );
+	void Statistics ( );
+};
+
+// Reads a trace through a mapping of the whole file.  Each reader keeps
+// its own position, so several threads may replay one trace each.
+class TraceReader
+{
+private:
+	int fd;
+	const unsigned char * data;
+	word_64 size;
+	word_64 position;
+	TraceState state;
+public:
+	TraceReader ( );
+	bool Open ( const char * file );
+	bool Next ( ShadowAccess & a );		// false at the end
+	void Rewind ( );
+	void Close ( );
+	word_64 Size ( );			// bytes
+};
+
+# endif
@@ -0,0 +1,139 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "victim_cache.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+VictimCache :: VictimCache ( int entries, int wpb )
+{
+	size = ( entries > 0 ) ? entries : 1;
+	wordsPerBlock = wpb;
+	entry = new VictimCache_Entry [size];
+	for ( int i = 0; i < size; i++ )
+	{
+		entry[i].data = new word_32 [wordsPerBlock];
+		entry[i].valid = false;
+		entry[i].modified = false;
+		entry[i].blockTag = -1;
+		entry[i].lastUse = 0;
+	}
+	useClock = 0;
+	
+	lookups = hits = inserted = dirtyEvictions = 0;
+}
+
+void VictimCache :: AtExit ( )
+{
+	for ( int i = 0; i < size; i++ )
+		delete[] entry[i].data;
+	delete[] entry;
+}
+
+int VictimCache :: Find ( int blockTag )
+{
+	for ( int i = 0; i < size; i++ )
+		if ( entry[i].valid == true && entry[i].blockTag == blockTag )
+			return i;
+	return -1;
+}
+
+int VictimCache :: Lookup ( int blockTag )
+{
+	lookups ++;
+	int i = Find ( blockTag );
+	if ( i != -1 ) hits ++;
+	return i;
+}
+
+int VictimCache :: Slot ( )
+{
+	int pick = 0;
+	for ( int i = 0; i < size; i++ )
+	{
+		if ( entry[i].valid == false ) return i;
+		if ( entry[i].lastUse < entry[pick].lastUse ) pick = i;
+	}
+	if ( entry[pick].modified == true ) dirtyEvictions ++;
+	return pick;
+}
+
+VictimCache_Entry & VictimCache :: Entry ( int i )
+{
+	return entry[i];
+}
+
+void VictimCache :: Insert ( int i, int blockTag, word_32 * data, bool modified )
+{
+	VictimCache_Entry & e = entry[i];
+	for ( int w = 0; w < wordsPerBlock; w++ )
+		e.data[w] = data[w];
+	e.blockTag = blockTag;
+	e.valid = true;
+	e.modified = modified;
+	e.lastUse = ++ useClock;
+	inserted ++;
+}
+
+bool VictimCache :: Swap ( int i, word_32 * line, int blockTag, bool modified )
+{
+	VictimCache_Entry & e = entry[i];
+	bool wasModified = e.modified;
+	for ( int w = 0; w < wordsPerBlock; w++ )
+	{
+		word_32 t = e.data[w];
+		e.data[w] = line[w];
+		line[w] = t;
+	}
+	if ( blockTag == -1 )
+		Remove ( i );
+	else
+	{
+		e.blockTag = blockTag;
+		e.modified = modified;
+		e.lastUse = ++ useClock;
+		inserted ++;
+	}
+	return wasModified;
+}
+
+void VictimCache :: Remove ( int i )
+{
+	entry[i].valid = false;
+	entry[i].modified = false;
+	entry[i].blockTag = -1;
+}
+
+void VictimCache :: Statistics ( )
+{
+	cout << "\nVictim cache entries : " << size
+		<< "\nLines put in the victim cache : " << inserted
+		<< "\nMisses checked against it : " << lookups
+		<< "\nMisses it absorbed : " << hits
+		<< "\nVictim cache hit ratio : " 
+		<< (( lookups != 0 ) ? static_cast<double>(hits) / lookups : 0)
+		<< "\nDirty lines written down from it : " << dirtyEvictions
+		<< flush;
+}
@@ -0,0 +1,79 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __VICTIM_CACHE_H
+# define __VICTIM_CACHE_H
+
+# include "../include/instruction.h"
+
+# define VICTIM_CACHE_LATENCY 1		// cycles a victim cache hit adds to a hit
+
+// A small fully associative buffer of the lines a SimpleCache evicted.
+// A miss that finds its block here swaps it with the line being
+// evicted; otherwise the evicted line takes the least recently used
+// entry, and the owning cache writes that entry down if it is dirty.
+class VictimCache_Entry
+{
+public:
+	int blockTag;
+	bool valid;
+	bool modified;
+	word_64 lastUse;
+	word_32 * data;
+};
+
+class VictimCache
+{
+private:
+	VictimCache_Entry * entry;
+	int size;
+	int wordsPerBlock;
+	word_64 useClock;	// orders the entries for LRU
+	
+	// Statistics
+	word_64 lookups;	// misses of the cache checked here
+	word_64 hits;		// ... that found their block ( misses absorbed )
+	word_64 inserted;
+	word_64 dirtyEvictions;	// entries written down to make room
+public:
+	VictimCache ( int entries, int wpb );
+	
+	int Find ( int blockTag );	// the entry holding the block, or -1
+	int Lookup ( int blockTag );	// Find, counted as a miss checked here
+	int Slot ( );			// a free entry, or else the LRU one
+	VictimCache_Entry & Entry ( int i );
+	
+	// Puts a block in entry i, which the cache has written down if need be
+	void Insert ( int i, int blockTag, word_32 * data, bool modified );
+	
+	// Swaps the data of entry i with a line of the cache, which had
+	// the block blockTag ( -1 if it was invalid ).  Returns whether the
+	// entry's block was modified.
+	bool Swap ( int i, word_32 * line, int blockTag, bool modified );
+	void Remove ( int i );
+	
+	void Statistics ( );
+	void AtExit ( );
+};
+
+# endif
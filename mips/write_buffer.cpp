@@ -0,0 +1,180 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "write_buffer.h"
+
+# include <iostream>
+using std::cout;
+using std::flush;
+
+# include "../include/color.h"
+
+# include <semaphore.h>
+extern sem_t * cout_mutex;	// Defined in main.cpp
+
+WriteBuffer :: WriteBuffer ( Cache * lower, int entries, int wpb )
+{
+	mem = lower;
+	size = ( entries > 0 ) ? entries : 1;
+	wordsPerBlock = wpb;
+	entry = new WriteBuffer_Entry [size];
+	for ( int i = 0; i < size; i++ )
+	{
+		entry[i].data = new word_32 [wordsPerBlock];
+		entry[i].valid = new bool [wordsPerBlock];
+	}
+	head = count = 0;
+	
+	writes = coalesced = fullStalls = drained = drainedBytes = 0;
+}
+
+void WriteBuffer :: AtExit ( )
+{
+	for ( int i = 0; i < size; i++ )
+	{
+		delete[] entry[i].data;
+		delete[] entry[i].valid;
+	}
+	delete[] entry;
+}
+
+int WriteBuffer :: Find ( word_32 blockAddress )
+{
+	for ( int i = 0; i < count; i++ )
+		if ( entry[( head + i ) % size].blockAddress == blockAddress )
+			return ( head + i ) % size;
+	return -1;
+}
+
+int WriteBuffer :: Insert ( word_32 address, word_32 value )
+{
+	writes ++;
+	word_32 blockAddress = address - address % ( wordsPerBlock * 4 );
+	int offset = ( address / 4 ) % wordsPerBlock;
+	
+	int i = Find ( blockAddress );
+	if ( i != -1 )
+	{
+		coalesced ++;
+		entry[i].data[offset] = value;
+		entry[i].valid[offset] = true;
+		return 0;
+	}
+	
+	int bytes = 0;
+	if ( count == size )
+	{
+		fullStalls ++;
+		bytes = DrainOldest ( );
+	}
+	WriteBuffer_Entry & e = entry[( head + count ) % size];
+	e.blockAddress = blockAddress;
+	for ( int w = 0; w < wordsPerBlock; w++ )
+		e.valid[w] = false;
+	e.data[offset] = value;
+	e.valid[offset] = true;
+	count ++;
+	return bytes;
+}
+
+int WriteBuffer :: DrainEntry ( int i )
+{
+	int bytes = 0;
+	WriteBuffer_Entry & e = entry[i];
+	
+	// A whole line goes down in one transfer
+	bool whole = true;
+	for ( int w = 0; w < wordsPerBlock; w++ )
+		if ( e.valid[w] == false ) whole = false;
+	if ( whole == true )
+	{
+		if ( mem -> WriteBlock ( e.blockAddress, e.data, wordsPerBlock ) == false )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ WriteBuffer ] Write to lower level failed"
+				<< reset << flush;
+			sem_post ( cout_mutex );
+		}
+		drained ++;
+		drainedBytes += wordsPerBlock * 4;
+		return wordsPerBlock * 4;
+	}
+	
+	for ( int w = 0; w < wordsPerBlock; w++ )
+	{
+		if ( e.valid[w] == false ) continue;
+		if ( mem -> Write ( e.blockAddress + 4 * w, e.data[w], 4 ) == false )
+		{
+			sem_wait ( cout_mutex );
+			cout << red << "\n[ WriteBuffer ] Write to lower level failed"
+				<< reset << flush;
+			sem_post ( cout_mutex );
+		}
+		bytes += 4;
+	}
+	drained ++;
+	drainedBytes += bytes;
+	return bytes;
+}
+
+int WriteBuffer :: DrainOldest ( )
+{
+	if ( count == 0 ) return 0;
+	int bytes = DrainEntry ( head );
+	head = ( head + 1 ) % size;
+	count --;
+	return bytes;
+}
+
+int WriteBuffer :: DrainBlock ( word_32 blockAddress )
+{
+	int i = Find ( blockAddress );
+	if ( i == -1 ) return 0;
+	int bytes = DrainEntry ( i );
+	
+	// Close the gap, keeping the order of the others
+	for ( int j = ( i - head + size ) % size; j < count - 1; j++ )
+	{
+		WriteBuffer_Entry t = entry[( head + j ) % size];
+		entry[( head + j ) % size] = entry[( head + j + 1 ) % size];
+		entry[( head + j + 1 ) % size] = t;
+	}
+	count --;
+	return bytes;
+}
+
+bool WriteBuffer :: Empty ( )
+{
+	return count == 0;
+}
+
+void WriteBuffer :: Statistics ( )
+{
+	cout << "\nWrite buffer entries : " << size
+		<< "\nWrites buffered : " << writes
+		<< "\nWrites coalesced : " << coalesced
+		<< "\nWrites that found the buffer full : " << fullStalls
+		<< "\nEntries drained : " << drained 
+		<< " ( " << drainedBytes << " bytes )"
+		<< flush;
+}
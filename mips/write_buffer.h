@@ -0,0 +1,73 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# ifndef __WRITE_BUFFER_H
+# define __WRITE_BUFFER_H
+
+# include "memory.h"
+
+// A coalescing write buffer between a SimpleCache and the level below.
+// Each entry holds the words written to one block; a write to a block
+// already in the buffer goes into its entry.  The owning cache drains
+// the oldest entry in the background, and before it fetches a block
+// that has an entry ( so that the fetch sees the data ).
+class WriteBuffer_Entry
+{
+public:
+	word_32 blockAddress;
+	word_32 * data;
+	bool * valid;
+};
+
+class WriteBuffer
+{
+private:
+	Cache * mem;
+	WriteBuffer_Entry * entry;
+	int size;
+	int wordsPerBlock;
+	int head, count;
+	
+	int Find ( word_32 blockAddress );
+	int DrainEntry ( int i );	// Writes an entry down, returns the bytes
+	
+	// Statistics
+	word_64 writes;
+	word_64 coalesced;	// writes that went into an existing entry
+	word_64 fullStalls;	// writes that had to drain an entry first
+	word_64 drained;
+	word_64 drainedBytes;
+public:
+	WriteBuffer ( Cache * lower, int entries, int wpb );
+	
+	// Both return the bytes written to the level below on the way.
+	int Insert ( word_32 address, word_32 value );
+	int DrainOldest ( );
+	int DrainBlock ( word_32 blockAddress );	// if the block has an entry
+	
+	bool Empty ( );
+	void Statistics ( );
+	void AtExit ( );
+};
+
+# endif
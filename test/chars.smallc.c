@@ -0,0 +1,67 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Char arrays hold a byte per element, four to a word ( lbu / sb ).
+ * Fills one with the alphabet, reverses it in place and checks every
+ * byte and the word after the array, then stores values that need all
+ * eight bits of a char, or more.  Prints "chars ok" and returns 0 ( in
+ * $v0 ), or prints "chars bad" and returns the number of wrong bytes. */
+
+char letters[26];
+int after;
+
+int main() {
+  char pair[2];
+  int i = 0;
+  int bad = 0;
+
+  after = 12345;
+  while (i < 26) {
+    letters[i] = 'a' + i;
+    i = i + 1;
+  }
+
+  i = 0;
+  while (i < 13) {
+    int c = letters[i];
+    letters[i] = letters[25 - i];
+    letters[25 - i] = c;
+    i = i + 1;
+  }
+
+  i = 0;
+  while (i < 26) {
+    if (letters[i] != 'z' - i) bad = bad + 1;
+    i = i + 1;
+  }
+  if (after != 12345) bad = bad + 1;
+
+  pair[0] = 300;
+  pair[1] = 255;
+  if (pair[0] != 44) bad = bad + 1;
+  if (pair[1] != 255) bad = bad + 1;
+
+  if (bad == 0) puts("chars ok\n");
+  else puts("chars bad\n");
+  return bad;
+}
@@ -0,0 +1,75 @@
+/* Copyright 2005-2025 Varghese Mathew (Matt)
+ *
+ * This file is part of Coconut (TM).
+ * Coconut is a
+ *     Multi-threaded simulation of the pipeline of a MIPS-like
+ *     Microprocessor (integer instructions only) replete with 
+ *     Memory Subsystem, Caches and their performance analysis,
+ *     I/O device modules and an assembler.
+ * 
+ * Coconut is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Coconut is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Coconut.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Keeps a table in the scratchpad and moves it with the DMA engine: out
+ * to main memory at 0x30000, then back into a second scratchpad array.
+ * The two arrays fill a 512 byte scratchpad, so dma[] lands on the DMA
+ * engine's registers right after it.  Build and run it with
+ *
+ *   ./smallc -s 131072 scratchpad.smallc.c
+ *   ./asm a.out scratchpad.smallc.mips
+ *   ./coconut -c machine.cfg scratchpad.base=131072 scratchpad.size=512
+ *
+ * It prints "scratchpad ok" and returns 0 ( in $v0 ), or prints
+ * "scratchpad bad" and returns the number of wrong words.  The
+ * scratchpad's statistics then show the table's accesses, which the data
+ * cache never sees, and 2 DMA transfers of 64 words each. */
+
+scratchpad int squares[64];
+scratchpad int copy[64];
+scratchpad int dma[4];	/* source, destination, count, control */
+
+int main() {
+  int i = 0;
+  int bad = 0;
+
+  while (i < 64) {
+    squares[i] = i * i;
+    i = i + 1;
+  }
+
+  dma[0] = 131072;	/* squares */
+  dma[1] = 196608;	/* 0x30000, in main memory */
+  dma[2] = 256;
+  dma[3] = 1;
+  while (dma[3] == 1) {
+  }
+
+  dma[0] = 196608;
+  dma[1] = 131328;	/* copy */
+  dma[2] = 256;
+  dma[3] = 1;
+  while (dma[3] == 1) {
+  }
+  if (dma[3] != 0) bad = bad + 1;
+
+  i = 0;
+  while (i < 64) {
+    if (copy[i] != i * i) bad = bad + 1;
+    i = i + 1;
+  }
+
+  if (bad == 0) puts("scratchpad ok\n");
+  else puts("scratchpad bad\n");
+  return bad;
+}